@@ -34,6 +34,41 @@ SYNTH_API float GetParameter(int parameterId);
 
 // Granular synthesis
 SYNTH_API int LoadGranularBuffer(const float* buffer, int length);
+// Zero-copy: buffer belongs to the engine until release(buffer, context) is called
+SYNTH_API int AdoptGranularBuffer(float* buffer, int length, void (*release)(float* buffer, void* context),
+                                  void* context);
+// Release replaced buffers (and wavetables) now; call periodically from a control thread
+SYNTH_API void CollectRetiredResources();
+
+// Additive synthesis
+// ratios may be null for harmonic partials (ratio of partial i == i + 1)
+SYNTH_API int SetAdditivePartials(const float* amplitudes, const float* ratios, int count);
+// Returns the number of partials extracted from the granular buffer, or a negative error code
+SYNTH_API int AnalyzeGranularBufferPartials(float position, int maxPartials);
+
+// Wavetable import (runs on a background thread; returns a job id or a negative error code)
+SYNTH_API int ImportWavetableFile(const char* path, const char* name);
+SYNTH_API int ImportWavetableBuffer(const float* buffer, int length, int sampleRate, const char* name);
+
+// Master EQ response curve: numPoints magnitudes in dB, log-spaced from minFrequency to maxFrequency
+SYNTH_API int GetEqualizerResponse(float* magnitudesDb, int numPoints, float minFrequency, float maxFrequency);
+
+// Multi-segment modulation envelope: count breakpoints (curves may be null for straight segments),
+// looping between points loopStart and loopEnd (-1 for no loop)
+SYNTH_API int SetMsegPoints(const float* times, const float* levels, const float* curves, int count,
+                            int loopStart, int loopEnd);
+
+// Convolution reverb impulse response (right may be null for mono); prepared before returning
+SYNTH_API int LoadImpulseResponse(const float* left, const float* right, int length, int sampleRate);
+
+// Insert effects chain (slots: 0 = modulation, 1 = delay, 2 = reverb, 3 = convolution)
+SYNTH_API int SetEffectsOrder(const int* slots, int count);
+SYNTH_API int GetEffectsLatency(); // Samples, including the master EQ
+SYNTH_API double GetEffectSlotCpuLoad(int slot);
+
+// Transport (tempo, play state and sync divisions are parameters)
+SYNTH_API double GetTransportPosition();
+SYNTH_API double GetTransportTempo();
 
 // Audio analysis for visualization
 SYNTH_API double GetBassLevel();
@@ -48,6 +83,7 @@ SYNTH_API double GetDominantFrequency();
 #define SYNTH_PARAM_FILTER_CUTOFF        10
 #define SYNTH_PARAM_FILTER_RESONANCE     11
 #define SYNTH_PARAM_FILTER_TYPE          12
+#define SYNTH_PARAM_FILTER_GAIN          13
 #define SYNTH_PARAM_ATTACK_TIME          20
 #define SYNTH_PARAM_DECAY_TIME           21
 #define SYNTH_PARAM_SUSTAIN_LEVEL        22
@@ -55,6 +91,13 @@ SYNTH_API double GetDominantFrequency();
 #define SYNTH_PARAM_REVERB_MIX           30
 #define SYNTH_PARAM_DELAY_TIME           31
 #define SYNTH_PARAM_DELAY_FEEDBACK       32
+#define SYNTH_PARAM_DELAY_TIME_RIGHT     33
+#define SYNTH_PARAM_DELAY_CROSS_FEEDBACK 34
+#define SYNTH_PARAM_DELAY_PING_PONG      35
+#define SYNTH_PARAM_MOD_FX_TYPE          36
+#define SYNTH_PARAM_MOD_FX_RATE          37
+#define SYNTH_PARAM_MOD_FX_DEPTH         38
+#define SYNTH_PARAM_MOD_FX_MIX           39
 #define SYNTH_PARAM_GRANULAR_ACTIVE      40
 #define SYNTH_PARAM_GRANULAR_GRAIN_RATE  41
 #define SYNTH_PARAM_GRANULAR_GRAIN_DURATION 42
@@ -84,6 +127,11 @@ SYNTH_API void register_parameter_change_callback_ffi(SynthParameterChangeCallba
 typedef void (*SynthUiControlMidiCallback)(int targetPanelId, int ccNumber, int ccValue);
 SYNTH_API void register_ui_control_midi_callback(SynthUiControlMidiCallback callback_ptr);
 
+// Typedef for wavetable import callback (status 0 = progress, 1 = completed, 2 = failed;
+// tableHandle is the wavetable index for SetParameter once completed). Called from the import thread.
+typedef void (*SynthWavetableImportCallback)(int jobId, int status, float progress, int tableHandle);
+SYNTH_API void register_wavetable_import_callback(SynthWavetableImportCallback callback_ptr);
+
 
 // --- MIDI Learn ---
 SYNTH_API void start_midi_learn_ffi(int parameter_id);
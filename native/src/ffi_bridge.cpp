@@ -16,6 +16,10 @@ static ParameterChangeCallback g_dart_parameter_change_callback = nullptr;
 typedef void (*UiControlMidiCallbackDart)(int targetPanelId, int ccNumber, int ccValue);
 static UiControlMidiCallbackDart g_dart_ui_control_midi_callback = nullptr;
 
+// Wavetable import progress/completion: status 0 = progress, 1 = completed, 2 = failed
+typedef void (*WavetableImportCallback)(int jobId, int status, float progress, int tableHandle);
+static WavetableImportCallback g_dart_wavetable_import_callback = nullptr;
+
 // Mock MIDI device list JSON string
 // In a real scenario, this would be dynamically generated by querying system MIDI services.
 // IMPORTANT: The memory for this string must be managed carefully if not static const.
@@ -239,11 +243,8 @@ int LoadGranularBuffer(const float* buffer, int length) {
             return -2; // Engine not initialized
         }
         
-        // Copy buffer data to a vector
-        std::vector<float> audioData(buffer, buffer + length);
-        
-        // Load into granular synth through engine
-        if (engine.loadGranularBuffer(audioData)) {
+        // Copied once, into the buffer the granular synth reads
+        if (engine.loadGranularBuffer(buffer, static_cast<size_t>(length))) {
             return 0; // Success
         } else {
             return -3; // Failed to load buffer
@@ -257,6 +258,297 @@ int LoadGranularBuffer(const float* buffer, int length) {
     }
 }
 
+FFI_BRIDGE_EXPORT int AdoptGranularBuffer(float* buffer, int length, GranularBufferReleaseCallback release, void* context) {
+    try {
+        if (!buffer || length <= 0 || !release) {
+            return -1; // Invalid parameters
+        }
+        
+        SynthEngine& engine = SynthEngine::getInstance();
+        if (!engine.isInitialized()) {
+            return -2; // Engine not initialized
+        }
+        
+        // The engine owns the buffer from here and releases it on failure too
+        if (engine.adoptGranularBuffer(buffer, static_cast<size_t>(length), release, context)) {
+            return 0; // Success
+        } else {
+            return -3; // Failed to load buffer
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Exception in AdoptGranularBuffer: " << e.what() << std::endl;
+        return -4; // Exception occurred
+    } catch (...) {
+        std::cerr << "Unknown exception in AdoptGranularBuffer" << std::endl;
+        return -5; // Unknown exception
+    }
+}
+
+FFI_BRIDGE_EXPORT void CollectRetiredResources() {
+    try {
+        SynthEngine& engine = SynthEngine::getInstance();
+        engine.collectRetiredResources();
+    } catch (const std::exception& e) {
+        std::cerr << "Exception in CollectRetiredResources: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "Unknown exception in CollectRetiredResources" << std::endl;
+    }
+}
+
+FFI_BRIDGE_EXPORT int SetAdditivePartials(const float* amplitudes, const float* ratios, int count) {
+    try {
+        if (!amplitudes || count <= 0) {
+            return -1; // Invalid parameters
+        }
+        
+        SynthEngine& engine = SynthEngine::getInstance();
+        if (!engine.isInitialized()) {
+            return -2; // Engine not initialized
+        }
+        
+        std::vector<float> amplitudeData(amplitudes, amplitudes + count);
+        std::vector<float> ratioData;
+        if (ratios) {
+            ratioData.assign(ratios, ratios + count);
+        }
+        
+        return engine.setAdditivePartials(amplitudeData, ratioData) ? 0 : -3;
+    } catch (const std::exception& e) {
+        std::cerr << "Exception in SetAdditivePartials: " << e.what() << std::endl;
+        return -4; // Exception occurred
+    } catch (...) {
+        std::cerr << "Unknown exception in SetAdditivePartials" << std::endl;
+        return -5; // Unknown exception
+    }
+}
+
+FFI_BRIDGE_EXPORT int AnalyzeGranularBufferPartials(float position, int maxPartials) {
+    try {
+        SynthEngine& engine = SynthEngine::getInstance();
+        if (!engine.isInitialized()) {
+            return -2; // Engine not initialized
+        }
+        
+        int count = engine.analyzeGranularBufferPartials(position, maxPartials);
+        return (count >= 0) ? count : -3;
+    } catch (const std::exception& e) {
+        std::cerr << "Exception in AnalyzeGranularBufferPartials: " << e.what() << std::endl;
+        return -4; // Exception occurred
+    } catch (...) {
+        std::cerr << "Unknown exception in AnalyzeGranularBufferPartials" << std::endl;
+        return -5; // Unknown exception
+    }
+}
+
+FFI_BRIDGE_EXPORT int ImportWavetableFile(const char* path, const char* name) {
+    try {
+        if (!path) {
+            return -1; // Invalid parameters
+        }
+        
+        SynthEngine& engine = SynthEngine::getInstance();
+        if (!engine.isInitialized()) {
+            return -2; // Engine not initialized
+        }
+        
+        int jobId = engine.importWavetableFile(path, name ? name : "");
+        return (jobId >= 0) ? jobId : -3;
+    } catch (const std::exception& e) {
+        std::cerr << "Exception in ImportWavetableFile: " << e.what() << std::endl;
+        return -4; // Exception occurred
+    } catch (...) {
+        std::cerr << "Unknown exception in ImportWavetableFile" << std::endl;
+        return -5; // Unknown exception
+    }
+}
+
+FFI_BRIDGE_EXPORT int ImportWavetableBuffer(const float* buffer, int length, int sampleRate, const char* name) {
+    try {
+        if (!buffer || length <= 0 || !name) {
+            return -1; // Invalid parameters
+        }
+        
+        SynthEngine& engine = SynthEngine::getInstance();
+        if (!engine.isInitialized()) {
+            return -2; // Engine not initialized
+        }
+        
+        // Copied here so the caller may free its buffer as soon as this returns
+        std::vector<float> audioData(buffer, buffer + length);
+        int jobId = engine.importWavetableBuffer(audioData, sampleRate, name);
+        return (jobId >= 0) ? jobId : -3;
+    } catch (const std::exception& e) {
+        std::cerr << "Exception in ImportWavetableBuffer: " << e.what() << std::endl;
+        return -4; // Exception occurred
+    } catch (...) {
+        std::cerr << "Unknown exception in ImportWavetableBuffer" << std::endl;
+        return -5; // Unknown exception
+    }
+}
+
+FFI_BRIDGE_EXPORT int GetEqualizerResponse(float* magnitudesDb, int numPoints, float minFrequency, float maxFrequency) {
+    try {
+        if (!magnitudesDb || numPoints <= 0 || minFrequency <= 0.0f || maxFrequency < minFrequency) {
+            return -1; // Invalid parameters
+        }
+        
+        SynthEngine& engine = SynthEngine::getInstance();
+        if (!engine.isInitialized()) {
+            return -2; // Engine not initialized
+        }
+        
+        return engine.getEqualizerResponse(magnitudesDb, numPoints, minFrequency, maxFrequency) ? 0 : -3;
+    } catch (const std::exception& e) {
+        std::cerr << "Exception in GetEqualizerResponse: " << e.what() << std::endl;
+        return -4; // Exception occurred
+    } catch (...) {
+        std::cerr << "Unknown exception in GetEqualizerResponse" << std::endl;
+        return -5; // Unknown exception
+    }
+}
+
+FFI_BRIDGE_EXPORT int SetMsegPoints(const float* times, const float* levels, const float* curves, int count,
+                                      int loopStart, int loopEnd) {
+    try {
+        if (!times || !levels || count <= 0) {
+            return -1; // Invalid parameters
+        }
+        
+        SynthEngine& engine = SynthEngine::getInstance();
+        if (!engine.isInitialized()) {
+            return -2; // Engine not initialized
+        }
+        
+        std::vector<float> timeData(times, times + count);
+        std::vector<float> levelData(levels, levels + count);
+        std::vector<float> curveData;
+        if (curves) {
+            curveData.assign(curves, curves + count);
+        }
+        
+        return engine.setMsegPoints(timeData, levelData, curveData, loopStart, loopEnd) ? 0 : -3;
+    } catch (const std::exception& e) {
+        std::cerr << "Exception in SetMsegPoints: " << e.what() << std::endl;
+        return -4; // Exception occurred
+    } catch (...) {
+        std::cerr << "Unknown exception in SetMsegPoints" << std::endl;
+        return -5; // Unknown exception
+    }
+}
+
+FFI_BRIDGE_EXPORT int LoadImpulseResponse(const float* left, const float* right, int length, int sampleRate) {
+    try {
+        if (!left || length <= 0 || sampleRate <= 0) {
+            return -1; // Invalid parameters
+        }
+        
+        SynthEngine& engine = SynthEngine::getInstance();
+        if (!engine.isInitialized()) {
+            return -2; // Engine not initialized
+        }
+        
+        std::vector<float> leftData(left, left + length);
+        std::vector<float> rightData;
+        if (right) {
+            rightData.assign(right, right + length);
+        }
+        
+        return engine.loadImpulseResponse(leftData, rightData, sampleRate) ? 0 : -3;
+    } catch (const std::exception& e) {
+        std::cerr << "Exception in LoadImpulseResponse: " << e.what() << std::endl;
+        return -4; // Exception occurred
+    } catch (...) {
+        std::cerr << "Unknown exception in LoadImpulseResponse" << std::endl;
+        return -5; // Unknown exception
+    }
+}
+
+FFI_BRIDGE_EXPORT int SetEffectsOrder(const int* slots, int count) {
+    try {
+        if (!slots || count <= 0) {
+            return -1; // Invalid parameters
+        }
+        
+        SynthEngine& engine = SynthEngine::getInstance();
+        if (!engine.isInitialized()) {
+            return -2; // Engine not initialized
+        }
+        
+        std::vector<int> order(slots, slots + count);
+        return engine.setEffectsOrder(order) ? 0 : -3;
+    } catch (const std::exception& e) {
+        std::cerr << "Exception in SetEffectsOrder: " << e.what() << std::endl;
+        return -4; // Exception occurred
+    } catch (...) {
+        std::cerr << "Unknown exception in SetEffectsOrder" << std::endl;
+        return -5; // Unknown exception
+    }
+}
+
+FFI_BRIDGE_EXPORT int GetEffectsLatency() {
+    try {
+        SynthEngine& engine = SynthEngine::getInstance();
+        if (!engine.isInitialized()) {
+            return -2; // Engine not initialized
+        }
+        return engine.getEffectsLatency();
+    } catch (const std::exception& e) {
+        std::cerr << "Exception in GetEffectsLatency: " << e.what() << std::endl;
+        return -4; // Exception occurred
+    } catch (...) {
+        std::cerr << "Unknown exception in GetEffectsLatency" << std::endl;
+        return -5; // Unknown exception
+    }
+}
+
+FFI_BRIDGE_EXPORT double GetEffectSlotCpuLoad(int slot) {
+    try {
+        SynthEngine& engine = SynthEngine::getInstance();
+        if (!engine.isInitialized()) {
+            return 0.0; // Engine not initialized
+        }
+        return engine.getEffectSlotCpuLoad(slot);
+    } catch (const std::exception& e) {
+        std::cerr << "Exception in GetEffectSlotCpuLoad: " << e.what() << std::endl;
+        return 0.0;
+    } catch (...) {
+        std::cerr << "Unknown exception in GetEffectSlotCpuLoad" << std::endl;
+        return 0.0;
+    }
+}
+
+FFI_BRIDGE_EXPORT double GetTransportPosition() {
+    try {
+        SynthEngine& engine = SynthEngine::getInstance();
+        if (!engine.isInitialized()) {
+            return 0.0; // Engine not initialized
+        }
+        return engine.getTransportPosition();
+    } catch (const std::exception& e) {
+        std::cerr << "Exception in GetTransportPosition: " << e.what() << std::endl;
+        return 0.0;
+    } catch (...) {
+        std::cerr << "Unknown exception in GetTransportPosition" << std::endl;
+        return 0.0;
+    }
+}
+
+FFI_BRIDGE_EXPORT double GetTransportTempo() {
+    try {
+        SynthEngine& engine = SynthEngine::getInstance();
+        if (!engine.isInitialized()) {
+            return 0.0; // Engine not initialized
+        }
+        return engine.getTransportTempo();
+    } catch (const std::exception& e) {
+        std::cerr << "Exception in GetTransportTempo: " << e.what() << std::endl;
+        return 0.0;
+    } catch (...) {
+        std::cerr << "Unknown exception in GetTransportTempo" << std::endl;
+        return 0.0;
+    }
+}
+
 // Audio analysis functions for visualization
 double GetBassLevel() {
     try {
@@ -442,6 +734,20 @@ FFI_BRIDGE_EXPORT void register_ui_control_midi_callback(UiControlMidiCallbackDa
     }
 }
 
+FFI_BRIDGE_EXPORT void register_wavetable_import_callback(WavetableImportCallback callback_ptr) {
+    g_dart_wavetable_import_callback = callback_ptr;
+
+    if (callback_ptr) {
+        auto cppCallback = [](int jobId, int status, float progress, int tableHandle) {
+            if (g_dart_wavetable_import_callback) {
+                g_dart_wavetable_import_callback(jobId, status, progress, tableHandle);
+            }
+        };
+        SynthEngine::getInstance().setWavetableImportCallback(cppCallback);
+    } else {
+        SynthEngine::getInstance().setWavetableImportCallback(nullptr); // Clear callback
+    }
+}
 
 // --- Preset Management FFI Functions ---
 
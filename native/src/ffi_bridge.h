@@ -80,6 +80,145 @@ EXPORT int NoteOff(int note);
  */
 EXPORT int LoadGranularBuffer(const float* buffer, int length);
 
+/**
+ * Called when the engine is done with an adopted granular buffer, from a
+ * control thread (never the audio thread).
+ */
+typedef void (*GranularBufferReleaseCallback)(float* buffer, void* context);
+
+/**
+ * Load a caller-allocated audio buffer into the granular synthesizer
+ * without copying it, for large samples.
+ * 
+ * The buffer must not be written or freed until release is called with it.
+ * Unless the call fails with -1 or -2, the engine takes ownership and calls
+ * release exactly once, even if loading then fails.
+ * 
+ * @param buffer Pointer to audio data
+ * @param length Number of samples in the buffer
+ * @param release Called with buffer and context when the engine is done with it
+ * @param context Passed back to release
+ * @return 0 on success, non-zero error code on failure
+ */
+EXPORT int AdoptGranularBuffer(float* buffer, int length, GranularBufferReleaseCallback release, void* context);
+
+/**
+ * Set the partials of the additive oscillator.
+ * 
+ * @param amplitudes Linear amplitude per partial
+ * @param ratios Frequency ratio per partial relative to the note, or null for harmonic partials
+ * @param count Number of partials (at most 512 are used)
+ * @return 0 on success, non-zero error code on failure
+ */
+EXPORT int SetAdditivePartials(const float* amplitudes, const float* ratios, int count);
+
+/**
+ * Analyze the granular buffer into partials for the additive oscillator.
+ * 
+ * @param position Centre of the analysis frame (0.0 - 1.0 of the buffer)
+ * @param maxPartials Maximum number of partials to extract
+ * @return The number of partials extracted, or a negative error code
+ */
+EXPORT int AnalyzeGranularBufferPartials(float position, int maxPartials);
+
+/**
+ * Import a WAV/AIFF file as a wavetable on a background thread.
+ * Progress and completion are reported through register_wavetable_import_callback.
+ * 
+ * @param path Path to the audio file
+ * @param name Name to register the table under (null to use the path)
+ * @return The import job id, or a negative error code
+ */
+EXPORT int ImportWavetableFile(const char* path, const char* name);
+
+/**
+ * Import mono samples as a wavetable on a background thread.
+ * 
+ * @param buffer Pointer to audio data (copied before returning)
+ * @param length Number of samples in the buffer
+ * @param sampleRate Sample rate of the audio data
+ * @param name Name to register the table under
+ * @return The import job id, or a negative error code
+ */
+EXPORT int ImportWavetableBuffer(const float* buffer, int length, int sampleRate, const char* name);
+
+/**
+ * Get the magnitude response of the master EQ in one call, for drawing its curve.
+ * 
+ * @param magnitudesDb Receives numPoints magnitudes in dB
+ * @param numPoints Number of points, spaced logarithmically from minFrequency to maxFrequency
+ * @param minFrequency Frequency of the first point in Hz
+ * @param maxFrequency Frequency of the last point in Hz
+ * @return 0 on success, non-zero error code on failure
+ */
+EXPORT int GetEqualizerResponse(float* magnitudesDb, int numPoints, float minFrequency, float maxFrequency);
+
+/**
+ * Set the breakpoints of the multi-segment modulation envelope.
+ * 
+ * @param times Time of each point from the start, in seconds (beats when tempo synced)
+ * @param levels Level of each point (0.0 - 1.0)
+ * @param curves Bend of the segment ending at each point (-1.0 - 1.0), or null for straight segments
+ * @param count Number of points (at most 64 are used)
+ * @param loopStart Index of the point the loop returns to, or -1 for no loop
+ * @param loopEnd Index of the point at which the loop returns, or -1
+ * @return 0 on success, non-zero error code on failure
+ */
+EXPORT int SetMsegPoints(const float* times, const float* levels, const float* curves, int count,
+                         int loopStart, int loopEnd);
+
+/**
+ * Load an impulse response into the convolution reverb (at most 10 seconds
+ * are used). Prepares the whole response before returning; do not call it
+ * from the audio thread.
+ * 
+ * @param left The left channel (or only channel) of the response
+ * @param right The right channel, or null for a mono response
+ * @param length Number of samples per channel
+ * @param sampleRate The sample rate of the response
+ * @return 0 on success, non-zero error code on failure
+ */
+EXPORT int LoadImpulseResponse(const float* left, const float* right, int length, int sampleRate);
+
+/**
+ * Set the order of the insert effects chain.
+ * 
+ * @param slots Every effect slot exactly once, first processed first
+ *              (0 = modulation, 1 = delay, 2 = reverb, 3 = convolution)
+ * @param count Number of slots
+ * @return 0 on success, non-zero error code on failure
+ */
+EXPORT int SetEffectsOrder(const int* slots, int count);
+
+/**
+ * Get the total latency of the enabled insert effects.
+ * 
+ * @return The latency in samples, or a negative error code
+ */
+EXPORT int GetEffectsLatency();
+
+/**
+ * Get the recent CPU load of an insert effect slot.
+ * 
+ * @param slot The effect slot
+ * @return Processing time as a fraction of real time (0.0 while bypassed)
+ */
+EXPORT double GetEffectSlotCpuLoad(int slot);
+
+/**
+ * Get the transport's play position, for position displays.
+ * 
+ * @return The song position in quarter notes
+ */
+EXPORT double GetTransportPosition();
+
+/**
+ * Get the tempo in effect, including the tempo followed under MIDI clock sync.
+ * 
+ * @return The tempo in BPM
+ */
+EXPORT double GetTransportTempo();
+
 /**
  * Audio analysis functions for visualization.
  */
@@ -2,10 +2,19 @@
 #include <vector>
 #include <memory>
 #include <cmath>
+#include <algorithm>
+#include "grain_window.h"
 
 namespace synth {
 
 /// Represents a single grain of sound
+///
+/// Everything that is fixed for the grain's life is worked out at trigger:
+/// the read increment through the source, the increment through its window
+/// table, the stereo gains and the number of frames it will sound for.
+/// Rendering is then a block loop of interpolated reads, with positions
+/// computed from the loop index rather than carried from frame to frame, so
+/// the loop vectorizes.
 class Grain {
 public:
     enum class WindowType {
@@ -14,102 +23,108 @@ public:
         Triangular,
         Tukey
     };
-    
-    Grain() 
-        : position_(0.0f)
-        , length_(0.05f)  // 50ms default
+
+    Grain()
+        : windowType_(WindowType::Hann)
+        , window_(GrainWindows::get().table(0))
+        , source_(nullptr)
+        , readPosition_(0.0)
         , pitch_(1.0f)
-        , amplitude_(1.0f)
+        , windowPosition_(0.0f)
+        , windowIncrement_(0.0f)
+        , leftGain_(0.0f)
+        , rightGain_(0.0f)
+        , framesLeft_(0)
         , pan_(0.0f)
-        , windowType_(WindowType::Hann)
-        , isActive_(false)
-        , currentFrame_(0) {
+        , isActive_(false) {
     }
-    
-    // Initialize the grain with parameters
-    void trigger(float position, float length, float pitch, float amplitude, float pan) {
-        position_ = position;
-        length_ = length;
+
+    // Initialize the grain with parameters. The grain reads source until it
+    // finishes, so the samples must stay alive that long. startOffset is the
+    // fraction of a frame (0-1) by which the grain's true start precedes its
+    // first frame.
+    void trigger(const float* source, size_t sourceFrames, float sampleRate, float position, float length,
+                 float pitch, float amplitude, float pan, float startOffset = 0.0f) {
+        const double lengthFrames = static_cast<double>(length) * sampleRate;
+        source_ = source;
         pitch_ = pitch;
-        amplitude_ = amplitude;
         pan_ = pan;
-        currentFrame_ = 0;
-        isActive_ = true;
+        readPosition_ = position * static_cast<double>(sourceFrames) + startOffset * pitch;
+        windowIncrement_ = static_cast<float>(GrainWindows::kSize / lengthFrames);
+        windowPosition_ = startOffset * windowIncrement_;
+        window_ = GrainWindows::get().table(static_cast<int>(windowType_));
+
+        // Equal-power pan, folded into the grain's gains
+        leftGain_ = amplitude * std::sqrt(0.5f * (1.0f - pan));
+        rightGain_ = amplitude * std::sqrt(0.5f * (1.0f + pan));
+
+        // The grain ends with its window or where the source runs out,
+        // whichever comes first (the last read needs the frame after it,
+        // and one more is kept back as rounding headroom)
+        const double windowFrames = std::ceil(lengthFrames - startOffset);
+        const double sourceLeft = std::ceil((static_cast<double>(sourceFrames) - 2.0 - readPosition_) / pitch);
+        framesLeft_ = static_cast<int>(std::max(0.0, std::min(windowFrames, sourceLeft)));
+        isActive_ = framesLeft_ > 0;
     }
-    
-    // Process one sample of the grain
-    float process(const std::vector<float>& buffer, float sampleRate) {
-        if (!isActive_ || buffer.empty()) return 0.0f;
-        
-        // Calculate position in the buffer
-        float bufferPos = position_ * buffer.size() + currentFrame_ * pitch_;
-        
-        // Check if grain has finished
-        float grainProgress = currentFrame_ / (length_ * sampleRate);
-        if (grainProgress >= 1.0f || bufferPos >= buffer.size()) {
-            isActive_ = false;
-            return 0.0f;
+
+    /// Add the grain's next frames to a stereo accumulator.
+    ///
+    /// @param left Left accumulator
+    /// @param right Right accumulator
+    /// @param numFrames Frames to render
+    void render(float* left, float* right, int numFrames) {
+        const int frames = std::min(numFrames, framesLeft_);
+        const size_t base = static_cast<size_t>(readPosition_);
+        const float* src = source_ + base;
+        const float readStart = static_cast<float>(readPosition_ - static_cast<double>(base));
+        const float pitch = pitch_;
+        const float* window = window_;
+        const float windowStart = windowPosition_;
+        const float windowIncrement = windowIncrement_;
+        const float leftGain = leftGain_;
+        const float rightGain = rightGain_;
+
+        for (int i = 0; i < frames; ++i) {
+            const float x = readStart + static_cast<float>(i) * pitch;
+            const int index = static_cast<int>(x);
+            const float fraction = x - static_cast<float>(index);
+            const float sample = src[index] + fraction * (src[index + 1] - src[index]);
+
+            const float w = windowStart + static_cast<float>(i) * windowIncrement;
+            const int windowIndex = static_cast<int>(w);
+            const float windowFraction = w - static_cast<float>(windowIndex);
+            const float gain = window[windowIndex] + windowFraction * (window[windowIndex + 1] - window[windowIndex]);
+
+            const float value = sample * gain;
+            left[i] += value * leftGain;
+            right[i] += value * rightGain;
         }
-        
-        // Interpolate sample from buffer
-        size_t index0 = static_cast<size_t>(bufferPos);
-        size_t index1 = (index0 + 1) % buffer.size();
-        float fraction = bufferPos - index0;
-        
-        float sample = buffer[index0] * (1.0f - fraction) + buffer[index1] * fraction;
-        
-        // Apply window
-        float window = getWindowValue(grainProgress);
-        sample *= window * amplitude_;
-        
-        currentFrame_++;
-        return sample;
+
+        readPosition_ += static_cast<double>(frames) * pitch;
+        windowPosition_ = std::min(windowStart + static_cast<float>(frames) * windowIncrement,
+                                   static_cast<float>(GrainWindows::kSize));
+        framesLeft_ -= frames;
+        isActive_ = framesLeft_ > 0;
     }
-    
+
     bool isActive() const { return isActive_; }
     float getPan() const { return pan_; }
-    
+
     void setWindowType(WindowType type) { windowType_ = type; }
-    
+
 private:
-    float getWindowValue(float progress) const {
-        switch (windowType_) {
-            case WindowType::Hann:
-                return 0.5f * (1.0f - std::cos(2.0f * M_PI * progress));
-                
-            case WindowType::Gaussian: {
-                float alpha = 2.5f;  // Width parameter
-                float x = (progress - 0.5f) * 2.0f;
-                return std::exp(-0.5f * alpha * x * x);
-            }
-            
-            case WindowType::Triangular:
-                return progress < 0.5f ? 2.0f * progress : 2.0f * (1.0f - progress);
-                
-            case WindowType::Tukey: {
-                float taperRatio = 0.1f;
-                if (progress < taperRatio / 2) {
-                    return 0.5f * (1.0f + std::cos(M_PI * (2.0f * progress / taperRatio - 1.0f)));
-                } else if (progress > 1.0f - taperRatio / 2) {
-                    return 0.5f * (1.0f + std::cos(M_PI * (2.0f * progress - 2.0f / taperRatio + 1.0f)));
-                } else {
-                    return 1.0f;
-                }
-            }
-            
-            default:
-                return 1.0f;
-        }
-    }
-    
-    float position_;      // Position in the source buffer (0-1)
-    float length_;        // Grain length in seconds
-    float pitch_;         // Pitch shift factor
-    float amplitude_;     // Grain amplitude
-    float pan_;          // Stereo pan (-1 to 1)
     WindowType windowType_;
+    const float* window_;     // Window table for the grain's shape
+    const float* source_;     // Samples the grain reads
+    double readPosition_;     // Source frame of the next read
+    float pitch_;             // Pitch shift factor (source frames per frame)
+    float windowPosition_;    // Window table position of the next frame
+    float windowIncrement_;   // Window table steps per frame
+    float leftGain_;          // Amplitude and pan, per side
+    float rightGain_;
+    int framesLeft_;          // Frames still to render
+    float pan_;               // Stereo pan (-1 to 1)
     bool isActive_;
-    size_t currentFrame_;
 };
 
-} // namespace synth
\ No newline at end of file
+} // namespace synth
@@ -0,0 +1,67 @@
+#pragma once
+#include <cmath>
+
+namespace synth {
+
+/// Precomputed grain envelopes, one table per window shape.
+///
+/// Each table covers a whole grain in kSize steps and is read with linear
+/// interpolation at a per-grain increment, so rendering a grain costs no
+/// transcendental functions. Two guard entries past the end hold the final
+/// value, so a read at the very end of a grain needs no bounds check.
+class GrainWindows {
+public:
+    static constexpr int kSize = 1024;  ///< Steps across one grain
+    static constexpr int kShapes = 4;   ///< Matches Grain::WindowType
+
+    /// The shared tables. Built on first use, so touch once off the audio thread.
+    static const GrainWindows& get() {
+        static const GrainWindows windows;
+        return windows;
+    }
+
+    /// @param shape A Grain::WindowType value; unknown shapes give Hann
+    /// @return kSize + 2 window values
+    const float* table(int shape) const {
+        return tables_[(shape >= 0 && shape < kShapes) ? shape : 0];
+    }
+
+private:
+    GrainWindows() {
+        for (int i = 0; i < kSize + 2; ++i) {
+            const double progress = std::fmin(1.0, static_cast<double>(i) / kSize);
+            tables_[0][i] = static_cast<float>(hann(progress));
+            tables_[1][i] = static_cast<float>(gaussian(progress));
+            tables_[2][i] = static_cast<float>(triangular(progress));
+            tables_[3][i] = static_cast<float>(tukey(progress));
+        }
+    }
+
+    static double hann(double progress) {
+        return 0.5 * (1.0 - std::cos(2.0 * M_PI * progress));
+    }
+
+    static double gaussian(double progress) {
+        const double alpha = 2.5;  // Width parameter
+        const double x = (progress - 0.5) * 2.0;
+        return std::exp(-0.5 * alpha * x * x);
+    }
+
+    static double triangular(double progress) {
+        return progress < 0.5 ? 2.0 * progress : 2.0 * (1.0 - progress);
+    }
+
+    static double tukey(double progress) {
+        const double taperRatio = 0.1;
+        if (progress < taperRatio / 2) {
+            return 0.5 * (1.0 + std::cos(M_PI * (2.0 * progress / taperRatio - 1.0)));
+        } else if (progress > 1.0 - taperRatio / 2) {
+            return 0.5 * (1.0 + std::cos(M_PI * (2.0 * progress / taperRatio - 2.0 / taperRatio + 1.0)));
+        }
+        return 1.0;
+    }
+
+    float tables_[kShapes][kSize + 2];
+};
+
+} // namespace synth
@@ -1,14 +1,36 @@
 #pragma once
 #include "grain.h"
+#include "sample_buffer.h"
 #include <vector>
 #include <random>
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 
 namespace synth {
 
 /// Granular synthesis engine
+///
+/// Grains live in a fixed pool. Sounding grains are tracked in an active
+/// list and idle ones on a free stack, so the per-sample cost depends on the
+/// number of live grains, not the pool size, and a spawn is a pop. The pool
+/// is allocated once at its full capacity; setMaxGrains() only moves the
+/// limit on how many may sound at once, so it is safe while processing.
+///
+/// The source is an immutable SampleBuffer, published to the audio thread
+/// with a single atomic pointer store. Grains already sounding finish on the
+/// buffer they started on. A replaced buffer is released on a control
+/// thread, by collectRetired(), getBuffer() or a later load, once the audio
+/// thread reports that neither it nor any grain still reads it, so the audio
+/// thread never frees memory.
 class GranularSynthesizer {
 public:
+    static constexpr int kMaxGrains = 4096;         ///< Pool capacity
+    static constexpr int kDefaultMaxGrains = 128;
+
     GranularSynthesizer() 
         : sampleRate_(44100.0f)
         , grainRate_(10.0f)  // 10 grains per second
@@ -22,63 +44,129 @@ public:
         , pan_(0.0f)
         , panVariation_(0.0f)
         , windowType_(Grain::WindowType::Hann)
-        , framesSinceLastGrain_(0)
+        , grainPhase_(0.0)
+        , maxGrains_(kDefaultMaxGrains)
         , randomEngine_(std::random_device{}())
-        , randomDist_(0.0f, 1.0f) {
+        , randomDist_(0.0f, 1.0f)
+        , published_(nullptr)
+        , oldestInUse_(0)
+        , generation_(0) {
+        
+        // Start without a buffer
+        ownedSource_ = std::make_unique<Source>();
+        ownedSource_->generation = 0;
+        published_.store(ownedSource_.get());
         
-        // Initialize grain pool
-        grains_.resize(128);  // Pool of 128 grains
+        // Initialize grain pool, every grain free (lowest index on top)
+        grains_.resize(kMaxGrains);
+        grainGenerations_.resize(kMaxGrains, 0);
+        activeGrains_.reserve(kMaxGrains);
+        freeGrains_.reserve(kMaxGrains);
+        for (int i = kMaxGrains - 1; i >= 0; --i) {
+            freeGrains_.push_back(static_cast<uint32_t>(i));
+        }
     }
     
     void setSampleRate(float sampleRate) {
         sampleRate_ = sampleRate;
     }
     
+    /// Replace the source (control thread). Grains already sounding finish
+    /// on the old buffer; new grains read the new one from the next block.
+    void setBuffer(std::shared_ptr<const SampleBuffer> buffer) {
+        publishSource(std::move(buffer));
+    }
+    
     void setBuffer(const std::vector<float>& buffer) {
-        sourceBuffer_ = buffer;
+        setBuffer(SampleBuffer::copy(buffer.data(), buffer.size()));
+    }
+    
+    /// Release replaced buffers that are out of the audio thread's reach
+    /// (control thread). Call periodically, so that a buffer swapped out is
+    /// freed without waiting for the next load.
+    void collectRetired() {
+        std::lock_guard<std::mutex> lock(sourceMutex_);
+        collectRetiredLocked();
+    }
+    
+    /// Also collects replaced buffers (control thread).
+    /// @return The current source, or null; safe to read for as long as it is held
+    std::shared_ptr<const SampleBuffer> getBuffer() {
+        std::lock_guard<std::mutex> lock(sourceMutex_);
+        collectRetiredLocked();
+        return ownedSource_->buffer;
     }
     
     void clearBuffer() {
-        sourceBuffer_.clear();
+        publishSource(nullptr);
     }
     
-    // Process stereo output
-    void process(float& left, float& right) {
-        left = 0.0f;
-        right = 0.0f;
+    /// Render a block of stereo output, replacing the contents of left and right.
+    ///
+    /// Grains already sounding are rendered first, a block at a time each.
+    /// Grains due in the block are then triggered at their exact fractional
+    /// times and rendered from their first frame to the end of the block.
+    void processBlock(float* left, float* right, int numFrames) {
+        std::fill(left, left + numFrames, 0.0f);
+        std::fill(right, right + numFrames, 0.0f);
         
-        if (sourceBuffer_.empty()) return;
+        const Source* current = published_.load();
+        uint64_t oldest = current->generation;
         
-        // Check if it's time to trigger a new grain
-        float framesBetweenGrains = sampleRate_ / grainRate_;
-        if (framesSinceLastGrain_ >= framesBetweenGrains) {
-            triggerNewGrain();
-            framesSinceLastGrain_ = 0;
+        // Continue the active grains, retiring those that finish
+        for (size_t k = 0; k < activeGrains_.size();) {
+            Grain& grain = grains_[activeGrains_[k]];
+            grain.render(left, right, numFrames);
+            if (!grain.isActive()) {
+                freeGrains_.push_back(activeGrains_[k]);
+                activeGrains_[k] = activeGrains_.back();
+                activeGrains_.pop_back();
+                continue;
+            }
+            oldest = std::min(oldest, grainGenerations_[activeGrains_[k]]);
+            ++k;
         }
-        framesSinceLastGrain_++;
         
-        // Process all active grains
-        for (auto& grain : grains_) {
-            if (grain.isActive()) {
-                float grainSample = grain.process(sourceBuffer_, sampleRate_);
-                
-                // Apply stereo panning
-                float pan = grain.getPan();
-                float leftGain = std::sqrt(0.5f * (1.0f - pan));
-                float rightGain = std::sqrt(0.5f * (1.0f + pan));
-                
-                left += grainSample * leftGain;
-                right += grainSample * rightGain;
+        if (current->buffer && !current->buffer->empty()) {
+            // The grain clock reaches 1 at 'due' frames into the block (fractional);
+            // the grain sounds from the next whole frame, offset by the difference
+            const double increment = grainRate_ / sampleRate_;
+            double due = (1.0 - grainPhase_) / increment - 1.0;
+            int triggered = 0;
+            for (double frame = std::ceil(due); frame < numFrames; frame = std::ceil(due)) {
+                const int start = std::max(0, static_cast<int>(frame));
+                if (triggerNewGrain(*current, static_cast<float>(start - due))) {
+                    Grain& grain = grains_[activeGrains_.back()];
+                    grain.render(left + start, right + start, numFrames - start);
+                    if (!grain.isActive()) {
+                        freeGrains_.push_back(activeGrains_.back());
+                        activeGrains_.pop_back();
+                    }
+                }
+                due += 1.0 / increment;
+                ++triggered;
             }
+            grainPhase_ += numFrames * increment - triggered;
         }
         
+        // Everything older than this may now be released
+        oldestInUse_.store(oldest);
+        
         // Apply master amplitude
-        left *= amplitude_;
-        right *= amplitude_;
+        const float amplitude = amplitude_;
+        for (int i = 0; i < numFrames; ++i) {
+            left[i] *= amplitude;
+            right[i] *= amplitude;
+        }
+    }
+    
+    // Process one frame of stereo output
+    void process(float& left, float& right) {
+        processBlock(&left, &right, 1);
     }
     
     // Granular parameters
-    void setGrainRate(float rate) { grainRate_ = std::max(0.1f, std::min(100.0f, rate)); }
+    void setGrainRate(float rate) { grainRate_ = std::max(0.1f, std::min(1000.0f, rate)); }
     void setGrainDuration(float duration) { grainDuration_ = std::max(0.001f, std::min(1.0f, duration)); }
     void setGrainDurationVariation(float variation) { grainDurationVariation_ = std::max(0.0f, std::min(1.0f, variation)); }
     void setPosition(float pos) { position_ = std::max(0.0f, std::min(1.0f, pos)); }
@@ -89,6 +177,25 @@ public:
     void setPan(float pan) { pan_ = std::max(-1.0f, std::min(1.0f, pan)); }
     void setPanVariation(float variation) { panVariation_ = std::max(0.0f, std::min(1.0f, variation)); }
     void setWindowType(Grain::WindowType type) { windowType_ = type; }
+    /// Limit the grains sounding at once (1 - kMaxGrains); new grains are dropped at the limit
+    void setMaxGrains(int count) { maxGrains_ = std::max(1, std::min(kMaxGrains, count)); }
+
+    /// Lock the grain clock to an external phase in cycles, such as the
+    /// transport's position within a musical division. Called once per
+    /// block; a grid point that falls between two calls still fires exactly
+    /// one grain.
+    void syncGrainPhase(double phase) {
+        double target = phase - std::floor(phase);
+        if (target + 0.5 < grainPhase_) {
+            // The grid wrapped before the clock got there
+            const Source* current = published_.load();
+            if (current->buffer && !current->buffer->empty()) triggerNewGrain(*current);
+        } else if (grainPhase_ + 0.5 < target) {
+            // The clock fired just ahead of the grid; wait for the next point
+            target -= 1.0;
+        }
+        grainPhase_ = target;
+    }
     
     // Getters
     float getGrainRate() const { return grainRate_; }
@@ -96,14 +203,49 @@ public:
     float getPosition() const { return position_; }
     float getPitch() const { return pitch_; }
     float getAmplitude() const { return amplitude_; }
+    int getMaxGrains() const { return maxGrains_; }
+    int getActiveGrainCount() const { return static_cast<int>(activeGrains_.size()); }
     
 private:
-    void triggerNewGrain() {
-        // Find an inactive grain
-        auto it = std::find_if(grains_.begin(), grains_.end(), 
-            [](const Grain& g) { return !g.isActive(); });
+    /// A published source and its generation (0 for the initial empty one).
+    /// Immutable once published.
+    struct Source {
+        std::shared_ptr<const SampleBuffer> buffer;
+        uint64_t generation;
+    };
+    
+    void publishSource(std::shared_ptr<const SampleBuffer> buffer) {
+        auto source = std::make_unique<Source>();
+        source->buffer = std::move(buffer);
         
-        if (it != grains_.end()) {
+        std::lock_guard<std::mutex> lock(sourceMutex_);
+        source->generation = ++generation_;
+        collectRetiredLocked();
+        published_.store(source.get());
+        retired_.push_back(std::move(ownedSource_));
+        ownedSource_ = std::move(source);
+    }
+    
+    void collectRetiredLocked() {
+        // Each block reports the oldest generation it or its grains read, never
+        // more than the one it loaded, so anything older is out of reach for good
+        const uint64_t oldest = oldestInUse_.load();
+        retired_.erase(std::remove_if(retired_.begin(), retired_.end(),
+                                      [oldest](const std::unique_ptr<Source>& source) {
+                                          return source->generation < oldest;
+                                      }),
+                       retired_.end());
+    }
+    
+    // Returns true if a grain was started; it is then last in the active list
+    bool triggerNewGrain(const Source& source, float startOffset = 0.0f) {
+        // Take a free grain, unless the limit is reached
+        if (static_cast<int>(activeGrains_.size()) < maxGrains_ && !freeGrains_.empty()) {
+            const uint32_t index = freeGrains_.back();
+            freeGrains_.pop_back();
+            activeGrains_.push_back(index);
+            Grain& grain = grains_[index];
+
             // Calculate grain parameters with variations
             float duration = grainDuration_ + (randomDist_(randomEngine_) - 0.5f) * 2.0f * grainDurationVariation_;
             float pos = position_ + (randomDist_(randomEngine_) - 0.5f) * 2.0f * positionVariation_;
@@ -117,14 +259,20 @@ private:
             pan = std::max(-1.0f, std::min(1.0f, pan));
             
             // Set window type and trigger
-            it->setWindowType(windowType_);
-            it->trigger(pos, duration, pitch, 1.0f, pan);
+            grain.setWindowType(windowType_);
+            grain.trigger(source.buffer->data(), source.buffer->size(), sampleRate_, pos, duration, pitch, 1.0f, pan,
+                          startOffset);
+            grainGenerations_[index] = source.generation;
+            return true;
         }
+        return false;
     }
     
     float sampleRate_;
-    std::vector<float> sourceBuffer_;
     std::vector<Grain> grains_;
+    std::vector<uint64_t> grainGenerations_;  // Source generation each grain reads
+    std::vector<uint32_t> activeGrains_;  // Pool indices of the sounding grains
+    std::vector<uint32_t> freeGrains_;    // Pool indices of the idle grains, used as a stack
     
     // Granular parameters
     float grainRate_;           // Grains per second
@@ -140,11 +288,20 @@ private:
     Grain::WindowType windowType_;
     
     // Timing
-    size_t framesSinceLastGrain_;
+    double grainPhase_;         // Cycles towards the next grain
+    int maxGrains_;             // Grains allowed to sound at once
     
     // Random number generation
     std::mt19937 randomEngine_;
     std::uniform_real_distribution<float> randomDist_;
+    
+    // Source publishing (under sourceMutex_)
+    std::atomic<const Source*> published_;
+    std::atomic<uint64_t> oldestInUse_;       // Oldest generation the audio thread still reads
+    std::mutex sourceMutex_;
+    uint64_t generation_;
+    std::unique_ptr<Source> ownedSource_;
+    std::vector<std::unique_ptr<Source>> retired_;
 };
 
 } // namespace synth
\ No newline at end of file
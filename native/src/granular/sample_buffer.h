@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace synth {
+
+/// Immutable block of mono samples, shared by reference count between the
+/// loader, the granular engine and analysis. The samples never change once
+/// the buffer exists, so any thread holding a reference may read them
+/// without locking.
+///
+/// A buffer either owns a copy of its samples or adopts memory allocated by
+/// the caller, which is handed back through a release callback when the
+/// last reference goes.
+class SampleBuffer {
+public:
+    /// Receives adopted samples, and the context given with them, once the buffer is freed
+    using ReleaseCallback = void (*)(float* samples, void* context);
+
+    /// Make a buffer holding a copy of the samples.
+    static std::shared_ptr<const SampleBuffer> copy(const float* samples, size_t frames) {
+        std::shared_ptr<SampleBuffer> buffer(new SampleBuffer());
+        buffer->storage_.assign(samples, samples + frames);
+        buffer->samples_ = buffer->storage_.data();
+        buffer->frames_ = frames;
+        return buffer;
+    }
+
+    /// Wrap caller-allocated samples without copying them. The caller must
+    /// neither change nor free the samples until release is called.
+    static std::shared_ptr<const SampleBuffer> adopt(float* samples, size_t frames,
+                                                     ReleaseCallback release, void* context) {
+        std::shared_ptr<SampleBuffer> buffer(new SampleBuffer());
+        buffer->samples_ = samples;
+        buffer->frames_ = frames;
+        buffer->adopted_ = samples;
+        buffer->release_ = release;
+        buffer->context_ = context;
+        return buffer;
+    }
+
+    ~SampleBuffer() {
+        if (release_) {
+            release_(adopted_, context_);
+        }
+    }
+
+    SampleBuffer(const SampleBuffer&) = delete;
+    SampleBuffer& operator=(const SampleBuffer&) = delete;
+
+    const float* data() const { return samples_; }
+    size_t size() const { return frames_; }
+    bool empty() const { return frames_ == 0; }
+
+private:
+    SampleBuffer()
+        : samples_(nullptr)
+        , frames_(0)
+        , adopted_(nullptr)
+        , release_(nullptr)
+        , context_(nullptr) {
+    }
+
+    std::vector<float> storage_;  // Copied samples
+    const float* samples_;
+    size_t frames_;
+    float* adopted_;              // Adopted samples, handed back on release
+    ReleaseCallback release_;
+    void* context_;
+};
+
+} // namespace synth
@@ -1,11 +1,22 @@
 #include "synth_engine.h"
 #include "synthesis/oscillator.h"
 #include "synthesis/filter.h"
+#include "synthesis/filter_bank.h"
+#include "synthesis/equalizer.h"
 #include "synthesis/envelope.h"
-#include "synthesis/delay.h"
+#include "synthesis/mseg.h"
+#include "synthesis/modulation_effects.h"
+#include "synthesis/stereo_delay.h"
 #include "synthesis/reverb.h"
+#include "synthesis/convolution_reverb.h"
+#include "synthesis/effects_chain.h"
+#include "synthesis/transport.h"
+#include "synthesis/unison_oscillator.h"
+#include "synthesis/fast_math.h"
+#include "synthesis/partial_analyzer.h"
 #include "audio_platform/audio_platform.h"
 #include "wavetable/wavetable_manager.h"
+#include "wavetable/wavetable_importer.h"
 #include "wavetable/wavetable_oscillator_impl.h"
 #include "granular/granular_synth.h"
 #include <cmath>
@@ -58,6 +69,7 @@ bool SynthEngine::initialize(int sr, int bs, float initialVolume) {
         
         // Initialize wavetable manager
         wavetableManager = std::make_unique<synth::WavetableManager>();
+        wavetableImporter = std::make_unique<synth::WavetableImporter>(wavetableManager.get());
         
         // Initialize granular synth
         granularSynth = std::make_unique<synth::GranularSynthesizer>();
@@ -119,9 +131,19 @@ void SynthEngine::shutdown() {
     // Clean up all modules
     oscillators.clear();
     filter.reset();
+    filterBanks.clear();
+    equalizer.reset();
     envelope.reset();
+    mseg.reset();
+    transport.reset();
+    effectsChain.reset(); // Holds callbacks into the effects below
+    chorus.reset();
+    flanger.reset();
+    phaser.reset();
     delay.reset();
     reverb.reset();
+    convolutionReverb.reset(); // Joins the convolution worker thread
+    wavetableImporter.reset(); // Joins the import thread before the tables go away
     wavetableManager.reset();
     granularSynth.reset();
     
@@ -165,105 +187,244 @@ void SynthEngine::processAudio(float* outputBuffer, int numFrames, int numChanne
         for (int i = 0; i < numFrames * numChannels; ++i) {
             outputBuffer[i] = 0.0f;
         }
+        if (wavetableManager) {
+            wavetableManager->audioBlockFinished();
+        }
+        // Time goes on while muted
+        if (initialized && transport) {
+            transport->beginBlock();
+            transport->endBlock(numFrames);
+        }
         return;
     }
 
     float currentGlobalPitchBend = currentPitchBendFactor.load();
 
-    for (int frame = 0; frame < numFrames; ++frame) {
-        float currentSmoothedMasterVolume = masterVolume.getNextValue();
-        float sampleLeft = 0.0f;
-        float sampleRight = 0.0f;
-        float mixedVoicesSample = 0.0f;
+    // Pick up EQ band changes once per block
+    if (equalizer) {
+        equalizer->update();
+    }
+
+    // Voices are rendered and filtered a block at a time: each voice writes its
+    // stereo output into its own lanes of the filter bank, which filters all
+    // voices together before they are mixed down.
+    for (int blockStart = 0; blockStart < numFrames; blockStart += FilterBank::kBlockSize) {
+        const int blockFrames = std::min(FilterBank::kBlockSize, numFrames - blockStart);
+
+        // --- Advance the Transport and lock tempo-synced settings to it ---
+        if (transport) {
+            transport->beginBlock();
+            applyTempoSync();
+        }
+
+        // --- Render the Modulation Envelope for the block ---
+        // Turned into what its destination needs per frame: a cutoff in Hz,
+        // an amplitude gain or a pitch ratio
+        const auto modDestination = mseg ? static_cast<MsegDestination>(msegDestination.load()) : MsegDestination::Off;
+        const float modAmount = msegAmount.load();
+        float modValues[FilterBank::kBlockSize];
+        if (modDestination != MsegDestination::Off) {
+            mseg->processBlock(modValues, blockFrames);
+            if (modDestination == MsegDestination::FilterCutoff) {
+                const float baseCutoff = filter ? filter->getCutoff() : 1000.0f;
+                for (int i = 0; i < blockFrames; ++i) {
+                    modValues[i] = baseCutoff * fastmath::exp2(modAmount * 4.0f * modValues[i]);
+                }
+            } else if (modDestination == MsegDestination::Amplitude) {
+                // Positive amounts follow the shape, negative ones invert it
+                const float base = (modAmount >= 0.0f) ? 1.0f - modAmount : 1.0f;
+                for (int i = 0; i < blockFrames; ++i) {
+                    modValues[i] = base + modAmount * modValues[i];
+                }
+            } else {
+                for (int i = 0; i < blockFrames; ++i) {
+                    modValues[i] = fastmath::exp2(modAmount * modValues[i]);
+                }
+            }
+        }
+
+        for (auto& filterBank : filterBanks) {
+            for (int blockFrame = 0; blockFrame < blockFrames; ++blockFrame) {
+                filterBank->clearFrame(blockFrame);
+            }
+        }
 
         // --- Process Voices (Oscillators) ---
+        // Waveforms with a block kernel render the whole block in one call at
+        // the block's pitch; the rest are stepped per frame, as are all voices
+        // while the modulation envelope bends pitch per frame.
+        const bool pitchPerFrame = (modDestination == MsegDestination::Pitch);
         for (int vIdx = 0; vIdx < static_cast<int>(oscillators.size()); ++vIdx) {
             int note = voiceToNoteMap[vIdx]; // Assumes voiceToNoteMap is correctly sized
+            if (note == -1) {
+                // Voice is inactive, its oscillator should output 0.0f
+                // (ideally its volume was set to 0 in noteOff)
+                continue;
+            }
+            Oscillator& oscillator = *oscillators[vIdx];
+            // Ensure voiceBaseFrequency has valid data for this vIdx
+            const bool hasBaseFrequency = vIdx < static_cast<int>(voiceBaseFrequency.size());
 
-            if (note != -1) { // Voice is active
-                // Dynamic Pitch Bend
-                // Ensure voiceBaseFrequency has valid data for this vIdx
-                if (vIdx < static_cast<int>(voiceBaseFrequency.size())) {
-                     oscillators[vIdx]->setFrequency(voiceBaseFrequency[vIdx] * currentGlobalPitchBend);
+            // Per-Voice Aftertouch Modulation
+            float pressure = 0.0f;
+            { // Scope for mutex lock
+                std::lock_guard<std::mutex> lock(pressureMutex);
+                // Check if note exists in map before accessing
+                auto it = activeNotesPressure.find(note);
+                if (it != activeNotesPressure.end()) {
+                    pressure = it->second;
                 }
+            }
 
-                float oscSample = oscillators[vIdx]->process();
+            float aftertouchSensitivity = 0.5f; // Example: 0.0 to 0.5 additional gain
+            float aftertouchGain = 1.0f + pressure * aftertouchSensitivity;
 
-                // Per-Voice Aftertouch Modulation
-                float pressure = 0.0f;
-                { // Scope for mutex lock
-                    std::lock_guard<std::mutex> lock(pressureMutex);
-                    // Check if note exists in map before accessing
-                    auto it = activeNotesPressure.find(note);
-                    if (it != activeNotesPressure.end()) {
-                        pressure = it->second;
-                    }
+            // Every voice has its own lanes, so the filter state is never shared
+            FilterBank* filterBank = filterBanks[vIdx / FilterBank::kMaxVoices].get();
+            const int lane = 2 * (vIdx % FilterBank::kMaxVoices);
+
+            if (oscillator.hasBlockKernel() && !pitchPerFrame) {
+                if (hasBaseFrequency) {
+                    oscillator.setFrequency(voiceBaseFrequency[vIdx] * currentGlobalPitchBend);
                 }
+                float oscLeft[FilterBank::kBlockSize];
+                float oscRight[FilterBank::kBlockSize];
+                oscillator.processStereoBlock(oscLeft, oscRight, blockFrames);
+                for (int blockFrame = 0; blockFrame < blockFrames; ++blockFrame) {
+                    float* voiceLanes = filterBank->frame(blockFrame);
+                    voiceLanes[lane] += oscLeft[blockFrame] * aftertouchGain;
+                    voiceLanes[lane + 1] += oscRight[blockFrame] * aftertouchGain;
+                }
+                continue;
+            }
 
-                float aftertouchSensitivity = 0.5f; // Example: 0.0 to 0.5 additional gain
-                oscSample *= (1.0f + pressure * aftertouchSensitivity);
+            for (int blockFrame = 0; blockFrame < blockFrames; ++blockFrame) {
+                // Dynamic Pitch Bend (and modulation envelope pitch)
+                if (hasBaseFrequency) {
+                    const float pitchFactor = pitchPerFrame ? currentGlobalPitchBend * modValues[blockFrame]
+                                                            : currentGlobalPitchBend;
+                    oscillator.setFrequency(voiceBaseFrequency[vIdx] * pitchFactor);
+                }
+
+                // Stereo render so oscillatorPan and unison spread are applied
+                float oscLeft = 0.0f, oscRight = 0.0f;
+                oscillator.processStereo(oscLeft, oscRight);
 
-                mixedVoicesSample += oscSample;
+                float* voiceLanes = filterBank->frame(blockFrame);
+                voiceLanes[lane] += oscLeft * aftertouchGain;
+                voiceLanes[lane + 1] += oscRight * aftertouchGain;
             }
-            // Else: voice is inactive, its oscillator should output 0.0f
-            // (ideally its volume was set to 0 in noteOff)
         }
 
-        // --- Apply Global Envelope and Filter ---
+        // --- Render the Global Envelope for the block ---
+        // While idle the envelope is bypassed, as when it was stepped per frame
+        float envelopeValues[FilterBank::kBlockSize];
+        int envelopeFrames = 0;
         if (this->envelope && this->envelope->isActive()) {
-            mixedVoicesSample *= this->envelope->process();
+            envelopeFrames = this->envelope->processBlock(envelopeValues, blockFrames);
         }
-        if (this->filter) {
-            mixedVoicesSample = this->filter->process(mixedVoicesSample);
+
+        // --- Apply Global Envelope and Per-Voice Filters ---
+        // The envelope scales the voices ahead of the filter, so a nonlinear
+        // filter is driven less as the note fades
+        for (auto& filterBank : filterBanks) {
+            for (int blockFrame = 0; blockFrame < envelopeFrames; ++blockFrame) {
+                float* voiceLanes = filterBank->frame(blockFrame);
+                for (int lane = 0; lane < FilterBank::kLanes; ++lane) {
+                    voiceLanes[lane] *= envelopeValues[blockFrame];
+                }
+            }
+            if (this->filter) {
+                filterBank->setParameters(*this->filter);
+            }
+            if (modDestination == MsegDestination::FilterCutoff) {
+                filterBank->process(blockFrames, modValues);
+            } else {
+                filterBank->process(blockFrames);
+            }
+        }
+
+        // --- Render Granular Synthesis for the block ---
+        float granularLeft[FilterBank::kBlockSize];
+        float granularRight[FilterBank::kBlockSize];
+        if (granularSynth) {
+            granularSynth->processBlock(granularLeft, granularRight, blockFrames);
         }
 
-        sampleLeft = mixedVoicesSample;
-        sampleRight = mixedVoicesSample; // Assuming mono mix from voices for now
+        // Mixed voices and granular output for the block, before the effects
+        float blockLeft[FilterBank::kBlockSize];
+        float blockRight[FilterBank::kBlockSize];
+
+        for (int blockFrame = 0; blockFrame < blockFrames; ++blockFrame) {
+            float sampleLeft = 0.0f;
+            float sampleRight = 0.0f;
+            float mixedVoicesLeft = 0.0f;
+            float mixedVoicesRight = 0.0f;
+
+            for (const auto& filterBank : filterBanks) {
+                const float* voiceLanes = filterBank->frame(blockFrame);
+                for (int lane = 0; lane < FilterBank::kLanes; lane += 2) {
+                    mixedVoicesLeft += voiceLanes[lane];
+                    mixedVoicesRight += voiceLanes[lane + 1];
+                }
+            }
 
-        // --- Add Granular Synthesis (after main synth's global filter) ---
-        if (granularSynth) { // Check if granularSynth is initialized
-            float granLeft = 0.0f, granRight = 0.0f;
-            granularSynth->process(granLeft, granRight); // Assumes this method exists and works
-            sampleLeft += granLeft;
-            sampleRight += granRight;
+            if (modDestination == MsegDestination::Amplitude) {
+                mixedVoicesLeft *= modValues[blockFrame];
+                mixedVoicesRight *= modValues[blockFrame];
+            }
+
+            sampleLeft = mixedVoicesLeft;
+            sampleRight = mixedVoicesRight;
+
+            // --- Add Granular Synthesis (after the voice filters) ---
+            if (granularSynth) {
+                sampleLeft += granularLeft[blockFrame];
+                sampleRight += granularRight[blockFrame];
+            }
+
+            blockLeft[blockFrame] = sampleLeft;
+            blockRight[blockFrame] = sampleRight;
         }
 
-        // --- Apply Effects (Delay, Reverb) ---
-        if (this->delay) { // Check if delay is initialized
-            // Assuming delay processes stereo (or adapt if it's mono-in/stereo-out etc.)
-            // This is a simplified placeholder. A real delay might take separate L/R inputs
-            // or process a mono sum and output stereo.
-            // If delay is mono-in mono-out:
-            // float delayedSample = this->delay->process((sampleLeft + sampleRight) * 0.5f);
-            // sampleLeft = delayedSample; sampleRight = delayedSample;
-            // Or if it handles stereo:
-            float processedLeft = this->delay->process(sampleLeft); // Hypothetical stereo processing
-            float processedRight = this->delay->process(sampleRight); // Hypothetical
-            sampleLeft = processedLeft;
-            sampleRight = processedRight;
+        // --- Apply Effects (Modulation, Delay, Reverb, Convolution, in chain order) ---
+        if (this->effectsChain) {
+            this->effectsChain->processBlock(blockLeft, blockRight, blockFrames);
         }
-        
-        if (this->reverb) { // Check if reverb is initialized
-            // Similar assumptions for reverb processing (mono/stereo)
-            float processedLeft = this->reverb->process(sampleLeft); // Hypothetical stereo processing
-            float processedRight = this->reverb->process(sampleRight); // Hypothetical
-            sampleLeft = processedLeft;
-            sampleRight = processedRight;
+        if (transport) {
+            transport->endBlock(blockFrames);
         }
 
-        // --- Apply Master Volume ---
-        sampleLeft *= currentSmoothedMasterVolume;
-        sampleRight *= currentSmoothedMasterVolume;
+        for (int blockFrame = 0; blockFrame < blockFrames; ++blockFrame) {
+            const int frame = blockStart + blockFrame;
+            float currentSmoothedMasterVolume = masterVolume.getNextValue();
+            float sampleLeft = blockLeft[blockFrame];
+            float sampleRight = blockRight[blockFrame];
 
-        // --- Write to Output Buffer ---
-        if (numChannels == 1) {
-            outputBuffer[frame] = (sampleLeft + sampleRight) * 0.5f;
-        } else {
-            outputBuffer[frame * numChannels] = sampleLeft;
-            outputBuffer[frame * numChannels + 1] = sampleRight;
+            // --- Apply Master EQ ---
+            if (this->equalizer) {
+                this->equalizer->processStereo(sampleLeft, sampleRight);
+            }
+
+            // --- Apply Master Volume ---
+            sampleLeft *= currentSmoothedMasterVolume;
+            sampleRight *= currentSmoothedMasterVolume;
+
+            // --- Write to Output Buffer ---
+            if (numChannels == 1) {
+                outputBuffer[frame] = (sampleLeft + sampleRight) * 0.5f;
+            } else {
+                outputBuffer[frame * numChannels] = sampleLeft;
+                outputBuffer[frame * numChannels + 1] = sampleRight;
+            }
         }
     }
 
+    // No wavetable pointer loaded during this block is used past this point
+    if (wavetableManager) {
+        wavetableManager->audioBlockFinished();
+    }
+
     // Update audio analysis (original position is fine)
     updateAudioAnalysis(outputBuffer, numFrames, numChannels);
 
@@ -335,11 +496,15 @@ bool SynthEngine::noteOn(int note, int velocity) {
         // Apply current pitch bend and set frequency
         oscillators[vIdx]->setFrequency(baseFreq * currentPitchBendFactor.load());
         oscillators[vIdx]->setVolume(normalizedVelocity); // Set individual oscillator volume
+        oscillators[vIdx]->noteOn(normalizedVelocity);
 
         // Retrigger global envelope if used
         if (this->envelope) {
             this->envelope->noteOn(normalizedVelocity);
         }
+        if (this->mseg) {
+            this->mseg->noteOn();
+        }
 
         // Initialize pressure for the note
         {
@@ -380,6 +545,7 @@ bool SynthEngine::noteOff(int note) {
 
         if (vIdx != -1) {
             voiceToNoteMap[vIdx] = -1; // Free the voice
+            oscillators[vIdx]->noteOff();
             oscillators[vIdx]->setVolume(0.0f); // Silence the specific oscillator quickly
 
             // Remove pressure information for the note
@@ -407,6 +573,9 @@ bool SynthEngine::noteOff(int note) {
             if (!anyVoiceStillActive && this->envelope) {
                 this->envelope->noteOff();
             }
+            if (!anyVoiceStillActive && this->mseg) {
+                this->mseg->noteOff();
+            }
         }
         return true;
     } catch (const std::exception& e) {
@@ -424,6 +593,11 @@ bool SynthEngine::processMidiEvent(unsigned char status, unsigned char data1, un
     }
     
     try {
+        // System real-time and song position messages drive the transport
+        if ((status >= 0xF8 || status == 0xF2) && transport) {
+            return transport->handleMidiMessage(status, data1, data2);
+        }
+
         unsigned char messageType = status & 0xF0;
         unsigned char channel = status & 0x0F; // MIDI channel 0-15
 
@@ -577,6 +751,12 @@ bool SynthEngine::setParameter(int parameterId, float value, bool fromAutomation
         {
             std::lock_guard<std::mutex> lock(parameterMutex);
             parameterCache[parameterId] = value;
+            // The envelope tempo is the transport tempo under another id; keep both reading it back
+            if (parameterId == SynthParameterId::msegTempo) {
+                parameterCache[SynthParameterId::transportTempo] = value;
+            } else if (parameterId == SynthParameterId::transportTempo) {
+                parameterCache[SynthParameterId::msegTempo] = value;
+            }
         }
         
         // Handle parameter based on ID (apply to synth modules)
@@ -637,6 +817,13 @@ bool SynthEngine::setParameter(int parameterId, float value, bool fromAutomation
                 }
                 return false;
                 
+            case SynthParameterId::filterGain:
+                if (filter) {
+                    filter->setGain(std::clamp(value, 0.0f, 10.0f));
+                    return true;
+                }
+                return false;
+                
             // Envelope parameters
             case SynthParameterId::attackTime:
                 if (envelope) {
@@ -676,7 +863,11 @@ bool SynthEngine::setParameter(int parameterId, float value, bool fromAutomation
                 
             case SynthParameterId::delayTime:
                 if (delay) {
-                    delay->setTime(value);
+                    freeDelayTime.store(value);
+                    freeDelayTimeRight.store(value);
+                    if (delaySyncDivision.load() == 0) {
+                        delay->setTime(value);
+                    }
                     return true;
                 }
                 return false;
@@ -688,10 +879,72 @@ bool SynthEngine::setParameter(int parameterId, float value, bool fromAutomation
                 }
                 return false;
                 
+            case SynthParameterId::delayTimeRight:
+                if (delay) {
+                    freeDelayTimeRight.store(value);
+                    if (delaySyncDivision.load() == 0) {
+                        delay->setTimeRight(value);
+                    }
+                    return true;
+                }
+                return false;
+                
+            case SynthParameterId::delayCrossFeedback:
+                if (delay) {
+                    delay->setCrossFeedback(value);
+                    return true;
+                }
+                return false;
+                
+            case SynthParameterId::delayPingPong:
+                if (delay) {
+                    delay->setPingPong(value >= 0.5f);
+                    return true;
+                }
+                return false;
+                
+            // Modulation effect parameters (rate, depth and mix are shared by all three)
+            case SynthParameterId::modFxType:
+                modFxType.store(std::clamp(static_cast<int>(value), 0, 3));
+                return true;
+                
+            case SynthParameterId::modFxRate:
+                if (chorus && flanger && phaser) {
+                    freeModFxRate.store(std::max(0.0f, value));
+                    if (modFxSyncDivision.load() == 0) {
+                        chorus->setRate(value);
+                        flanger->setRate(value);
+                        phaser->setRate(value);
+                    }
+                    return true;
+                }
+                return false;
+                
+            case SynthParameterId::modFxDepth:
+                if (chorus && flanger && phaser) {
+                    chorus->setDepth(value);
+                    flanger->setDepth(value);
+                    phaser->setDepth(value);
+                    return true;
+                }
+                return false;
+                
+            case SynthParameterId::modFxMix:
+                if (chorus && flanger && phaser) {
+                    chorus->setMix(value);
+                    flanger->setMix(value);
+                    phaser->setMix(value);
+                    return true;
+                }
+                return false;
+                
             // Granular parameters
             case SynthParameterId::granularGrainRate:
                 if (granularSynth) {
-                    granularSynth->setGrainRate(value);
+                    freeGrainRate.store(value);
+                    if (granularSyncDivision.load() == 0) {
+                        granularSynth->setGrainRate(value);
+                    }
                     return true;
                 }
                 return false;
@@ -791,11 +1044,8 @@ bool SynthEngine::setParameter(int parameterId, float value, bool fromAutomation
                                 return true;
                             case 5: // Wavetable Index
                                 if (auto wtOsc = dynamic_cast<synth::WavetableOscillatorImpl*>(oscillators[oscIndex].get())) {
-                                    auto tableNames = wavetableManager->getTableNames();
-                                    int tableIndex = static_cast<int>(value);
-                                    if (tableIndex >= 0 && tableIndex < tableNames.size()) {
-                                        wtOsc->selectWavetable(tableNames[tableIndex]);
-                                    }
+                                    // Indices are registry handles: stable, and resolved without allocating
+                                    wtOsc->selectWavetable(static_cast<synth::WavetableManager::Handle>(value));
                                 }
                                 return true;
                             case 6: // Wavetable Position
@@ -808,6 +1058,249 @@ bool SynthEngine::setParameter(int parameterId, float value, bool fromAutomation
                         }
                     }
                 }
+
+                // FM parameters, applied to the operator voice of every oscillator
+                if (parameterId >= SynthParameterId::fmAlgorithm && parameterId < SynthParameterId::fmOperatorRatio + FMVoice::kNumOperators * 10) {
+                    int op = (parameterId - SynthParameterId::fmOperatorRatio) / 10;
+                    int paramOffset = (parameterId - SynthParameterId::fmOperatorRatio) % 10;
+                    bool handled = false;
+
+                    for (auto& osc : oscillators) {
+                        auto wtOsc = dynamic_cast<synth::WavetableOscillatorImpl*>(osc.get());
+                        if (!wtOsc) {
+                            continue;
+                        }
+                        FMVoice& fm = wtOsc->getFMVoice();
+                        handled = true;
+                        if (parameterId == SynthParameterId::fmAlgorithm) {
+                            fm.setAlgorithm(static_cast<int>(value));
+                        } else if (parameterId == SynthParameterId::fmFeedback) {
+                            fm.setFeedback(value);
+                        } else if (parameterId < SynthParameterId::fmOperatorRatio) {
+                            handled = false;
+                        } else {
+                            switch (paramOffset) {
+                                case 0: fm.setOperatorRatio(op, value); break;
+                                case 1: fm.setOperatorLevel(op, value); break;
+                                case 2: fm.setOperatorAttack(op, value); break;
+                                case 3: fm.setOperatorDecay(op, value); break;
+                                case 4: fm.setOperatorSustain(op, value); break;
+                                case 5: fm.setOperatorRelease(op, value); break;
+                                default: handled = false; break;
+                            }
+                        }
+                    }
+                    return handled;
+                }
+
+                // Additive parameters, applied to the partial bank of every oscillator
+                if (parameterId >= SynthParameterId::additivePartialCount && parameterId <= SynthParameterId::additiveEvenLevel) {
+                    bool handled = false;
+                    for (auto& osc : oscillators) {
+                        auto wtOsc = dynamic_cast<synth::WavetableOscillatorImpl*>(osc.get());
+                        if (!wtOsc) {
+                            continue;
+                        }
+                        AdditiveVoice& additive = wtOsc->getAdditiveVoice();
+                        handled = true;
+                        switch (parameterId) {
+                            case SynthParameterId::additivePartialCount:
+                                additive.setPartialCount(static_cast<int>(value));
+                                break;
+                            case SynthParameterId::additiveTilt:
+                                additive.setTilt(value);
+                                break;
+                            case SynthParameterId::additiveOddLevel:
+                                additive.setOddLevel(value);
+                                break;
+                            case SynthParameterId::additiveEvenLevel:
+                                additive.setEvenLevel(value);
+                                break;
+                        }
+                    }
+                    return handled;
+                }
+
+                // Master EQ band parameters
+                if (parameterId >= SynthParameterId::eqBandType && parameterId < SynthParameterId::eqBandType + Equalizer::kBands * 10) {
+                    if (!equalizer) {
+                        return false;
+                    }
+                    int band = (parameterId - SynthParameterId::eqBandType) / 10;
+                    switch ((parameterId - SynthParameterId::eqBandType) % 10) {
+                        case 0: equalizer->setBandType(band, static_cast<int>(value)); return true;
+                        case 1: equalizer->setBandFrequency(band, value); return true;
+                        case 2: equalizer->setBandGain(band, value); return true;
+                        case 3: equalizer->setBandQ(band, value); return true;
+                        default: return false;
+                    }
+                }
+
+                // Multi-segment modulation envelope
+                if (parameterId >= SynthParameterId::msegDestination && parameterId <= SynthParameterId::msegTempo) {
+                    if (!mseg) {
+                        return false;
+                    }
+                    switch (parameterId) {
+                        case SynthParameterId::msegDestination:
+                            msegDestination.store(std::clamp(static_cast<int>(value), 0, 3));
+                            return true;
+                        case SynthParameterId::msegAmount:
+                            msegAmount.store(std::clamp(value, -1.0f, 1.0f));
+                            return true;
+                        case SynthParameterId::msegLoopMode:
+                            mseg->setLoopMode(static_cast<int>(value));
+                            return true;
+                        case SynthParameterId::msegTempoSync:
+                            mseg->setTempoSync(value >= 0.5f);
+                            return true;
+                        case SynthParameterId::msegTempo:
+                            // Deprecated alias: the envelope follows the transport tempo
+                            if (transport) {
+                                transport->setTempo(value);
+                                return true;
+                            }
+                            return false;
+                    }
+                }
+
+                // Transport and tempo sync
+                if (parameterId >= SynthParameterId::transportTempo && parameterId <= SynthParameterId::granularSyncDivision) {
+                    if (!transport) {
+                        return false;
+                    }
+                    const int division = std::clamp(static_cast<int>(value), 0, Transport::kDivisions - 1);
+                    switch (parameterId) {
+                        case SynthParameterId::transportTempo:
+                            transport->setTempo(value);
+                            return true;
+                        case SynthParameterId::transportPlaying:
+                            transport->setPlaying(value >= 0.5f);
+                            return true;
+                        case SynthParameterId::timeSignatureNumerator:
+                        case SynthParameterId::timeSignatureDenominator: {
+                            int numerator = static_cast<int>(value);
+                            int denominator = static_cast<int>(value);
+                            {
+                                std::lock_guard<std::mutex> lock(parameterMutex);
+                                auto other = parameterCache.find(parameterId == SynthParameterId::timeSignatureNumerator
+                                    ? SynthParameterId::timeSignatureDenominator : SynthParameterId::timeSignatureNumerator);
+                                const int otherValue = (other != parameterCache.end()) ? static_cast<int>(other->second) : 4;
+                                if (parameterId == SynthParameterId::timeSignatureNumerator) {
+                                    denominator = otherValue;
+                                } else {
+                                    numerator = otherValue;
+                                }
+                            }
+                            transport->setTimeSignature(numerator, denominator);
+                            return true;
+                        }
+                        case SynthParameterId::transportExternalSync:
+                            transport->setExternalSync(value >= 0.5f);
+                            return true;
+                        case SynthParameterId::transportPosition:
+                            transport->locate(value);
+                            return true;
+                        case SynthParameterId::delaySyncDivision:
+                            delaySyncDivision.store(division);
+                            return true;
+                        case SynthParameterId::modFxSyncDivision:
+                            modFxSyncDivision.store(division);
+                            return true;
+                        case SynthParameterId::granularSyncDivision:
+                            granularSyncDivision.store(division);
+                            return true;
+                    }
+                }
+
+                // Insert effects chain slots
+                if (parameterId >= SynthParameterId::effectSlotEnabled && parameterId < SynthParameterId::effectSlotEnabled + EffectsChain::kMaxSlots * 10) {
+                    int slot = (parameterId - SynthParameterId::effectSlotEnabled) / 10;
+                    if (!effectsChain || slot >= effectsChain->getSlotCount()) {
+                        return false;
+                    }
+                    switch ((parameterId - SynthParameterId::effectSlotEnabled) % 10) {
+                        case 0: effectsChain->setEnabled(slot, value >= 0.5f); return true;
+                        case 1: return effectsChain->moveSlot(slot, static_cast<int>(value));
+                        default: return false;
+                    }
+                }
+
+                // Granular grain limit
+                if (parameterId == SynthParameterId::granularMaxGrains) {
+                    if (!granularSynth) {
+                        return false;
+                    }
+                    granularSynth->setMaxGrains(static_cast<int>(value));
+                    return true;
+                }
+
+                // Convolution reverb
+                if (parameterId == SynthParameterId::convolutionMix) {
+                    if (!convolutionReverb) {
+                        return false;
+                    }
+                    convolutionReverb->setMix(value);
+                    return true;
+                }
+
+                // Vector synthesis parameters, applied to the vector voice of every oscillator
+                if (parameterId >= SynthParameterId::vectorX && parameterId < SynthParameterId::vectorCornerType + 4 * 3) {
+                    return setVectorParameter(parameterId, value, fromAutomation);
+                }
+
+                // Extended oscillator parameters (unison, pulse width, sync, PWM, shaping)
+                if (parameterId >= SynthParameterId::oscillatorUnisonVoices && parameterId < SynthParameterId::oscillatorUnisonVoices + 1000) {
+                    int oscIndex = (parameterId - SynthParameterId::oscillatorUnisonVoices) / 10;
+                    int paramOffset = (parameterId - SynthParameterId::oscillatorUnisonVoices) % 10;
+
+                    if (oscIndex >= 0 && oscIndex < static_cast<int>(oscillators.size())) {
+                        Oscillator* osc = oscillators[oscIndex].get();
+                        switch (paramOffset) {
+                            case 4: // Pulse width
+                                osc->setPulseWidth(value);
+                                return true;
+                            case 5: // Hard-sync ratio
+                                osc->setSyncRatio(value);
+                                return true;
+                            case 6: // PWM depth
+                                osc->setPwmDepth(value);
+                                return true;
+                            case 7: // PWM rate (Hz)
+                                osc->setPwmRate(value);
+                                return true;
+                            case 8: // Phase distortion / waveshaper amount
+                                osc->setDistortion(value);
+                                return true;
+                            case 9: // Phase distortion variant / waveshaper curve
+                                osc->setShape(value);
+                                return true;
+                            default:
+                                break;
+                        }
+
+                        auto unisonOsc = dynamic_cast<UnisonOscillator*>(osc);
+                        if (!unisonOsc) {
+                            return false;
+                        }
+                        switch (paramOffset) {
+                            case 0: // Unison voices
+                                unisonOsc->setUnisonVoices(static_cast<int>(value));
+                                return true;
+                            case 1: // Unison detune (cents)
+                                unisonOsc->setUnisonDetune(value);
+                                return true;
+                            case 2: // Unison stereo spread
+                                unisonOsc->setStereoSpread(value);
+                                return true;
+                            case 3: // Unison phase randomization
+                                unisonOsc->setPhaseRandomization(value);
+                                return true;
+                            default:
+                                return false;
+                        }
+                    }
+                }
                 
                 // Unhandled parameter ID
                 return false;
@@ -888,7 +1381,7 @@ void SynthEngine::setPitchBend(int value) {
     float normalizedBend = (static_cast<float>(value) - 8192.0f) / 8192.0f; // -1.0 to 1.0
 
     // Calculate factor: 2^(semitones/12)
-    float factor = std::pow(2.0f, (normalizedBend * bendRangeSemitones) / 12.0f);
+    float factor = fastmath::semitonesToRatio(normalizedBend * bendRangeSemitones);
     currentPitchBendFactor.store(factor);
 
     // Update active oscillator frequencies immediately
@@ -915,9 +1408,13 @@ void SynthEngine::setModWheel(int value) {
 }
 
 void SynthEngine::initializeDefaultModules() {
-    // Create default oscillators with wavetable support
+    // Build the shared MinBLEP table here rather than on the first audio callback
+    MinBlepTable::prepare();
+    ShapingTables::prepare();
+    
+    // Create default oscillators with wavetable and unison support
     oscillators.clear();
-    auto osc = std::make_unique<synth::WavetableOscillatorImpl>();
+    auto osc = std::make_unique<UnisonOscillator>();
     osc->setSampleRate(sampleRate);
     osc->setType(static_cast<int>(Oscillator::WaveformType::Sine));
     osc->setVolume(0.5f);
@@ -925,7 +1422,7 @@ void SynthEngine::initializeDefaultModules() {
     oscillators.push_back(std::move(osc));
     
     // Add a second oscillator
-    auto osc2 = std::make_unique<synth::WavetableOscillatorImpl>();
+    auto osc2 = std::make_unique<UnisonOscillator>();
     osc2->setSampleRate(sampleRate);
     osc2->setType(static_cast<int>(Oscillator::WaveformType::Square));
     osc2->setVolume(0.3f);
@@ -940,6 +1437,15 @@ void SynthEngine::initializeDefaultModules() {
     filter->setResonance(0.5f);
     filter->setType(static_cast<int>(Filter::FilterType::LowPass));
     
+    // Per-voice filters, one pair of lanes per oscillator, in as many banks as it takes
+    filterBanks.clear();
+    for (int first = 0; first < static_cast<int>(oscillators.size()); first += FilterBank::kMaxVoices) {
+        auto filterBank = std::make_unique<FilterBank>();
+        filterBank->setVoiceCount(static_cast<int>(oscillators.size()) - first);
+        filterBank->setParameters(*filter);
+        filterBanks.push_back(std::move(filterBank));
+    }
+    
     // Create envelope
     envelope = std::make_unique<Envelope>();
     envelope->setSampleRate(sampleRate);
@@ -948,8 +1454,23 @@ void SynthEngine::initializeDefaultModules() {
     envelope->setSustain(0.7f);
     envelope->setRelease(0.5f);
     
+    // Modulation envelope, unrouted until msegDestination is set
+    mseg = std::make_unique<MultiSegmentEnvelope>();
+    mseg->setSampleRate(sampleRate);
+    
+    // Tempo and play position, stopped at 120 BPM
+    transport = std::make_unique<Transport>();
+    transport->setSampleRate(sampleRate);
+    
     // Create effects
-    delay = std::make_unique<Delay>();
+    chorus = std::make_unique<Chorus>();
+    chorus->setSampleRate(sampleRate);
+    flanger = std::make_unique<Flanger>();
+    flanger->setSampleRate(sampleRate);
+    phaser = std::make_unique<Phaser>();
+    phaser->setSampleRate(sampleRate);
+    
+    delay = std::make_unique<StereoDelay>();
     delay->setSampleRate(sampleRate);
     delay->setTime(0.5f);
     delay->setFeedback(0.3f);
@@ -960,20 +1481,140 @@ void SynthEngine::initializeDefaultModules() {
     reverb->setRoomSize(0.5f);
     reverb->setDamping(0.5f);
     reverb->setMix(0.2f);
+    
+    convolutionReverb = std::make_unique<ConvolutionReverb>();
+    convolutionReverb->setSampleRate(sampleRate);
+    
+    initializeEffectsChain();
+    
+    // Master EQ, all bands off until configured
+    equalizer = std::make_unique<Equalizer>();
+    equalizer->setSampleRate(sampleRate);
+}
+
+void SynthEngine::initializeEffectsChain() {
+    // Slot indices are fixed by the order of addition (see effectSlotEnabled)
+    effectsChain = std::make_unique<EffectsChain>();
+    effectsChain->setSampleRate(sampleRate);
+    // Each slot clears its effect once bypassed, so re-enabling it starts from silence.
+    // The delay and reverb buffers are cleared a chunk per block.
+    effectsChain->addSlot("Modulation", [this](float* left, float* right, int numFrames) {
+        processModulationEffect(left, right, numFrames);
+    }, 0, [this]() {
+        chorus->clear();
+        flanger->clear();
+        phaser->clear();
+        return true;
+    });
+    effectsChain->addSlot("Delay", [this](float* left, float* right, int numFrames) {
+        delay->processBlock(left, right, numFrames);
+    }, 0, [this]() {
+        return delay->clearPart();
+    });
+    effectsChain->addSlot("Reverb", [this](float* left, float* right, int numFrames) {
+        reverb->processBlock(left, right, numFrames);
+    }, 0, [this]() {
+        return reverb->clearPart();
+    });
+    effectsChain->addSlot("Convolution", [this](float* left, float* right, int numFrames) {
+        convolutionReverb->processBlock(left, right, numFrames);
+    }, 0, [this]() {
+        convolutionReverb->clear();
+        return true;
+    });
+}
+
+void SynthEngine::processModulationEffect(float* left, float* right, int numFrames) {
+    const int modType = modFxType.load();
+    if (modType != activeModFxType) {
+        // Start the newly selected effect from silence rather than stale state
+        switch (static_cast<ModFxType>(modType)) {
+            case ModFxType::Chorus: chorus->clear(); break;
+            case ModFxType::Flanger: flanger->clear(); break;
+            case ModFxType::Phaser: phaser->clear(); break;
+            default: break;
+        }
+        activeModFxType = modType;
+    }
+    // While tempo synced the LFO phase is taken from the transport each block (after any clear)
+    const bool synced = transport && syncedModFxDivision > 0;
+    const double lfoPhase = synced ? transport->getPhase(syncedModFxDivision) : 0.0;
+    switch (static_cast<ModFxType>(modType)) {
+        case ModFxType::Chorus:
+            if (synced) chorus->setLfoPhase(lfoPhase);
+            chorus->processBlock(left, right, numFrames);
+            break;
+        case ModFxType::Flanger:
+            if (synced) flanger->setLfoPhase(lfoPhase);
+            flanger->processBlock(left, right, numFrames);
+            break;
+        case ModFxType::Phaser:
+            if (synced) phaser->setLfoPhase(lfoPhase);
+            phaser->processBlock(left, right, numFrames);
+            break;
+        default:
+            break;
+    }
+}
+
+void SynthEngine::applyTempoSync() {
+    // Modulation envelope beats are transport beats
+    if (mseg) {
+        mseg->setTempo(static_cast<float>(transport->getTempo()));
+    }
+
+    const int delayDivision = delaySyncDivision.load();
+    if (delay) {
+        if (delayDivision > 0) {
+            delay->setTime(static_cast<float>(transport->getDivisionSeconds(delayDivision)));
+        } else if (syncedDelayDivision > 0) {
+            // Back to the free-running times
+            delay->setTimeLeft(freeDelayTime.load());
+            delay->setTimeRight(freeDelayTimeRight.load());
+        }
+    }
+    syncedDelayDivision = delayDivision;
+
+    const int modDivision = modFxSyncDivision.load();
+    if (chorus && flanger && phaser) {
+        if (modDivision > 0) {
+            const float rate = static_cast<float>(1.0 / transport->getDivisionSeconds(modDivision));
+            chorus->setRate(rate);
+            flanger->setRate(rate);
+            phaser->setRate(rate);
+        } else if (syncedModFxDivision > 0) {
+            const float rate = freeModFxRate.load();
+            chorus->setRate(rate >= 0.0f ? rate : Chorus::kDefaultRate);
+            flanger->setRate(rate >= 0.0f ? rate : Flanger::kDefaultRate);
+            phaser->setRate(rate >= 0.0f ? rate : Phaser::kDefaultRate);
+        }
+    }
+    syncedModFxDivision = modDivision;
+
+    const int grainDivision = granularSyncDivision.load();
+    if (granularSynth) {
+        if (grainDivision > 0) {
+            granularSynth->setGrainRate(static_cast<float>(1.0 / transport->getDivisionSeconds(grainDivision)));
+            granularSynth->syncGrainPhase(transport->getPhase(grainDivision));
+        } else if (syncedGranularDivision > 0) {
+            granularSynth->setGrainRate(freeGrainRate.load());
+        }
+    }
+    syncedGranularDivision = grainDivision;
 }
 
 float SynthEngine::noteToFrequency(int note) const {
     // A4 = MIDI note 69 = 440 Hz
-    return 440.0f * std::pow(2.0f, (note - 69) / 12.0f);
+    return 440.0f * fastmath::semitonesToRatio<fastmath::Precision::High>(static_cast<float>(note - 69));
 }
 
-bool SynthEngine::loadGranularBuffer(const std::vector<float>& buffer) {
-    if (!initialized || !granularSynth) {
+bool SynthEngine::loadGranularBuffer(const float* samples, size_t numSamples) {
+    if (!initialized || !granularSynth || !samples) {
         return false;
     }
     
     try {
-        granularSynth->setBuffer(buffer);
+        granularSynth->setBuffer(synth::SampleBuffer::copy(samples, numSamples));
         return true;
     } catch (const std::exception& e) {
         std::cerr << "Exception in SynthEngine::loadGranularBuffer: " << e.what() << std::endl;
@@ -984,6 +1625,311 @@ bool SynthEngine::loadGranularBuffer(const std::vector<float>& buffer) {
     }
 }
 
+bool SynthEngine::adoptGranularBuffer(float* samples, size_t numSamples, void (*release)(float*, void*), void* context) {
+    // Owned from here on, so the release runs on every path
+    std::shared_ptr<const synth::SampleBuffer> buffer;
+    try {
+        buffer = synth::SampleBuffer::adopt(samples, numSamples, release, context);
+    } catch (...) {
+        if (release) {
+            release(samples, context);
+        }
+        std::cerr << "Exception in SynthEngine::adoptGranularBuffer" << std::endl;
+        return false;
+    }
+    if (!initialized || !granularSynth || !samples) {
+        return false;
+    }
+    
+    try {
+        granularSynth->setBuffer(std::move(buffer));
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Exception in SynthEngine::adoptGranularBuffer: " << e.what() << std::endl;
+        return false;
+    } catch (...) {
+        std::cerr << "Unknown exception in SynthEngine::adoptGranularBuffer" << std::endl;
+        return false;
+    }
+}
+
+void SynthEngine::collectRetiredResources() {
+    if (!initialized) {
+        return;
+    }
+    
+    try {
+        if (granularSynth) {
+            granularSynth->collectRetired();
+        }
+        if (wavetableManager) {
+            wavetableManager->collectRetired();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Exception in SynthEngine::collectRetiredResources: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "Unknown exception in SynthEngine::collectRetiredResources" << std::endl;
+    }
+}
+
+bool SynthEngine::setAdditivePartials(const std::vector<float>& amplitudes, const std::vector<float>& ratios) {
+    if (!initialized || amplitudes.empty()) {
+        return false;
+    }
+    
+    try {
+        PartialSet partials;
+        partials.amplitudes = amplitudes;
+        partials.ratios = ratios;
+        for (auto& osc : oscillators) {
+            if (auto wtOsc = dynamic_cast<synth::WavetableOscillatorImpl*>(osc.get())) {
+                wtOsc->getAdditiveVoice().setPartials(partials);
+            }
+        }
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Exception in SynthEngine::setAdditivePartials: " << e.what() << std::endl;
+        return false;
+    } catch (...) {
+        std::cerr << "Unknown exception in SynthEngine::setAdditivePartials" << std::endl;
+        return false;
+    }
+}
+
+int SynthEngine::analyzeGranularBufferPartials(float position, int maxPartials) {
+    if (!initialized || !granularSynth) {
+        return -1;
+    }
+    
+    try {
+        // The granular buffer is stored at the engine sample rate; holding it keeps it alive
+        // however the audio thread moves on
+        std::shared_ptr<const synth::SampleBuffer> buffer = granularSynth->getBuffer();
+        if (!buffer) {
+            return -1;
+        }
+        PartialSet partials = PartialAnalyzer::analyze(buffer->data(), buffer->size(), sampleRate, position,
+                                                       std::min(maxPartials, AdditiveVoice::kMaxPartials));
+        if (partials.amplitudes.empty()) {
+            return -1;
+        }
+        if (!setAdditivePartials(partials.amplitudes, partials.ratios)) {
+            return -1;
+        }
+        return static_cast<int>(partials.amplitudes.size());
+    } catch (const std::exception& e) {
+        std::cerr << "Exception in SynthEngine::analyzeGranularBufferPartials: " << e.what() << std::endl;
+        return -1;
+    } catch (...) {
+        std::cerr << "Unknown exception in SynthEngine::analyzeGranularBufferPartials" << std::endl;
+        return -1;
+    }
+}
+
+bool SynthEngine::setVectorParameter(int parameterId, float value, bool fromAutomation) {
+    // Automation playback calls in from the audio thread, and replayed moves
+    // are not part of a live gesture, so it neither records nor toggles
+    // recording
+    bool stopRecording = false;
+    if (parameterId == SynthParameterId::vectorX || parameterId == SynthParameterId::vectorY) {
+        std::atomic<float>& axis = (parameterId == SynthParameterId::vectorX) ? vectorPadX : vectorPadY;
+        axis.store(std::clamp(value, 0.0f, 1.0f));
+        if (!fromAutomation) {
+            std::lock_guard<std::mutex> lock(vectorEnvelopeMutex);
+            if (vectorEnvelopeRecording && vectorEnvelopePath.size() < kMaxVectorPathPoints) {
+                auto now = std::chrono::steady_clock::now();
+                if (vectorEnvelopePath.empty()) {
+                    vectorEnvelopeStartTime = now; // The gesture starts with the first move
+                }
+                float time = std::chrono::duration<float>(now - vectorEnvelopeStartTime).count();
+                vectorEnvelopePath.push_back({time, vectorPadX.load(), vectorPadY.load()});
+            }
+        }
+    } else if (parameterId == SynthParameterId::vectorEnvelopeRecord && !fromAutomation) {
+        std::lock_guard<std::mutex> lock(vectorEnvelopeMutex);
+        const bool startRecording = value >= 0.5f && !vectorEnvelopeRecording;
+        stopRecording = value < 0.5f && vectorEnvelopeRecording;
+        vectorEnvelopeRecording = value >= 0.5f;
+        if (startRecording) {
+            vectorEnvelopePath.clear();
+            vectorEnvelopePath.reserve(kMaxVectorPathPoints);
+        }
+    }
+    if (stopRecording) {
+        publishVectorEnvelope();
+    }
+
+    int corner = (parameterId - SynthParameterId::vectorCornerType) / 3;
+    int cornerParam = (parameterId - SynthParameterId::vectorCornerType) % 3;
+    bool handled = false;
+    for (auto& osc : oscillators) {
+        auto wtOsc = dynamic_cast<synth::WavetableOscillatorImpl*>(osc.get());
+        if (!wtOsc) {
+            continue;
+        }
+        synth::VectorVoice& vector = wtOsc->getVectorVoice();
+        handled = true;
+        switch (parameterId) {
+            case SynthParameterId::vectorX:
+                vector.setX(value);
+                break;
+            case SynthParameterId::vectorY:
+                vector.setY(value);
+                break;
+            case SynthParameterId::vectorSmoothing:
+                vector.setSmoothing(value);
+                break;
+            case SynthParameterId::vectorEnvelopeRecord:
+                break;
+            case SynthParameterId::vectorEnvelopeMode:
+                vector.setEnvelopeMode(static_cast<int>(value));
+                break;
+            default:
+                if (parameterId < SynthParameterId::vectorCornerType) {
+                    handled = false;
+                } else if (cornerParam == 0) {
+                    vector.setCornerType(corner, static_cast<int>(value));
+                } else if (cornerParam == 1) {
+                    vector.setCornerWavetable(corner, static_cast<synth::WavetableManager::Handle>(value));
+                } else {
+                    vector.setCornerWavetablePosition(corner, value);
+                }
+                break;
+        }
+    }
+    return handled;
+}
+
+void SynthEngine::publishVectorEnvelope() {
+    synth::JoystickEnvelope envelope;
+    {
+        std::lock_guard<std::mutex> lock(vectorEnvelopeMutex);
+        // Long gestures are thinned evenly to fit the fixed-size envelope
+        size_t count = vectorEnvelopePath.size();
+        size_t points = std::min(count, static_cast<size_t>(synth::JoystickEnvelope::kMaxPoints));
+        for (size_t i = 0; i < points; ++i) {
+            size_t source = (points > 1) ? i * (count - 1) / (points - 1) : 0;
+            const VectorPathPoint& point = vectorEnvelopePath[source];
+            envelope.points[i] = {point.time, point.x, point.y};
+        }
+        envelope.count = static_cast<int>(points);
+    }
+    for (auto& osc : oscillators) {
+        if (auto wtOsc = dynamic_cast<synth::WavetableOscillatorImpl*>(osc.get())) {
+            wtOsc->getVectorVoice().setJoystickEnvelope(envelope);
+        }
+    }
+}
+
+int SynthEngine::importWavetableFile(const std::string& path, const std::string& name) {
+    if (!initialized || !wavetableImporter || path.empty()) {
+        return -1;
+    }
+    
+    try {
+        return wavetableImporter->importFile(path, name.empty() ? path : name);
+    } catch (const std::exception& e) {
+        std::cerr << "Exception in SynthEngine::importWavetableFile: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+int SynthEngine::importWavetableBuffer(const std::vector<float>& samples, int sourceSampleRate, const std::string& name) {
+    if (!initialized || !wavetableImporter || samples.empty() || name.empty()) {
+        return -1;
+    }
+    
+    try {
+        return wavetableImporter->importBuffer(samples, sourceSampleRate > 0 ? sourceSampleRate : sampleRate, name);
+    } catch (const std::exception& e) {
+        std::cerr << "Exception in SynthEngine::importWavetableBuffer: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+bool SynthEngine::getEqualizerResponse(float* magnitudesDb, int numPoints, float minFrequency, float maxFrequency) {
+    if (!initialized || !equalizer || !magnitudesDb || numPoints <= 0) {
+        return false;
+    }
+    
+    try {
+        equalizer->getMagnitudeResponse(magnitudesDb, numPoints, minFrequency, maxFrequency);
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Exception in SynthEngine::getEqualizerResponse: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool SynthEngine::setMsegPoints(const std::vector<float>& times, const std::vector<float>& levels,
+                                const std::vector<float>& curves, int loopStart, int loopEnd) {
+    if (!initialized || !mseg || times.empty() || levels.size() < times.size()) {
+        return false;
+    }
+    
+    try {
+        std::vector<MultiSegmentEnvelope::Point> points(times.size());
+        for (size_t i = 0; i < points.size(); ++i) {
+            points[i] = {times[i], levels[i], (i < curves.size()) ? curves[i] : 0.0f};
+        }
+        return mseg->setPoints(points.data(), static_cast<int>(points.size()), loopStart, loopEnd);
+    } catch (const std::exception& e) {
+        std::cerr << "Exception in SynthEngine::setMsegPoints: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool SynthEngine::loadImpulseResponse(const std::vector<float>& left, const std::vector<float>& right, int irSampleRate) {
+    if (!initialized || !convolutionReverb || left.empty()) {
+        return false;
+    }
+    
+    try {
+        return convolutionReverb->loadImpulseResponse(left, right, irSampleRate);
+    } catch (const std::exception& e) {
+        std::cerr << "Exception in SynthEngine::loadImpulseResponse: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool SynthEngine::setEffectsOrder(const std::vector<int>& order) {
+    if (!initialized || !effectsChain) {
+        return false;
+    }
+    return effectsChain->setOrder(order);
+}
+
+int SynthEngine::getEffectsLatency() const {
+    // The master EQ runs after the chain and always delays by its fixed latency
+    return (effectsChain ? effectsChain->getLatency() : 0) + (equalizer ? Equalizer::kLatency : 0);
+}
+
+float SynthEngine::getEffectSlotCpuLoad(int slot) const {
+    return effectsChain ? effectsChain->getCpuLoad(slot) : 0.0f;
+}
+
+double SynthEngine::getTransportPosition() const {
+    return transport ? transport->getPublishedBeat() : 0.0;
+}
+
+float SynthEngine::getTransportTempo() const {
+    return transport ? transport->getCurrentTempo() : 0.0f;
+}
+
+void SynthEngine::setWavetableImportCallback(std::function<void(int, int, float, int)> callback) {
+    if (!wavetableImporter) {
+        return;
+    }
+    if (!callback) {
+        wavetableImporter->setCallback(nullptr);
+        return;
+    }
+    wavetableImporter->setCallback([callback](int jobId, synth::WavetableImporter::Status status,
+                                              float progress, synth::WavetableManager::Handle handle) {
+        callback(jobId, static_cast<int>(status), progress, handle);
+    });
+}
+
 // --- MIDI Learn Methods ---
 void SynthEngine::startMidiLearn(int parameterId) {
     parameterIdToLearn.store(parameterId);
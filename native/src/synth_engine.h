@@ -18,13 +18,23 @@
 // Forward declarations
 class Oscillator;
 class Filter;
+class FilterBank;
+class Equalizer;
 class Envelope;
-class Delay;
+class MultiSegmentEnvelope;
+class StereoDelay;
+class Chorus;
+class Flanger;
+class Phaser;
 class Reverb;
+class ConvolutionReverb;
+class EffectsChain;
+class Transport;
 class AudioPlatform;
 
 namespace synth {
     class WavetableManager;
+    class WavetableImporter;
     class GranularSynthesizer;
 }
 
@@ -142,12 +152,145 @@ public:
     }
     
     /**
-     * Load an audio buffer for granular synthesis.
+     * Load an audio buffer for granular synthesis. The samples are copied
+     * once, into an immutable buffer swapped in at the next audio block.
      * 
-     * @param buffer The audio buffer to load
+     * @param samples The mono samples, at the engine sample rate
+     * @param numSamples The number of samples
      * @return True on success, false on failure
      */
-    bool loadGranularBuffer(const std::vector<float>& buffer);
+    bool loadGranularBuffer(const float* samples, size_t numSamples);
+    
+    /**
+     * Use caller-allocated samples for granular synthesis without copying
+     * them. The samples must not change until release is called, from a
+     * control thread, once neither the audio thread nor any grain reads them.
+     * Once this is called the engine owns the samples: release is called
+     * even if loading fails.
+     * 
+     * @param samples The mono samples, at the engine sample rate
+     * @param numSamples The number of samples
+     * @param release Called with samples and context when the engine is done with them
+     * @param context Passed back to release
+     * @return True on success, false on failure
+     */
+    bool adoptGranularBuffer(float* samples, size_t numSamples, void (*release)(float*, void*), void* context);
+    
+    /**
+     * Free granular buffers and wavetables that have been replaced and are
+     * out of the audio thread's reach. The audio thread never frees them
+     * itself, so call this periodically from a control thread.
+     */
+    void collectRetiredResources();
+    
+    /**
+     * Set the partial amplitudes (and optionally frequency ratios) of the additive oscillator.
+     * 
+     * @param amplitudes Linear amplitude per partial
+     * @param ratios Frequency ratio per partial relative to the note; empty for harmonic partials
+     * @return True on success, false on failure
+     */
+    bool setAdditivePartials(const std::vector<float>& amplitudes, const std::vector<float>& ratios);
+    
+    /**
+     * Analyze the granular buffer into partials for the additive oscillator.
+     * 
+     * @param position Centre of the analysis frame (0.0 - 1.0 of the buffer)
+     * @param maxPartials Maximum number of partials to extract
+     * @return The number of partials extracted, or -1 on failure
+     */
+    int analyzeGranularBufferPartials(float position, int maxPartials);
+    
+    /**
+     * Import a WAV/AIFF file as a wavetable on a background thread.
+     * 
+     * @param path Path to the audio file
+     * @param name Name to register the table under; an existing table of that name is replaced
+     * @return The import job id, or -1 on failure
+     */
+    int importWavetableFile(const std::string& path, const std::string& name);
+    
+    /**
+     * Import mono samples as a wavetable on a background thread.
+     * 
+     * @param samples The source audio
+     * @param sourceSampleRate Sample rate of the source audio
+     * @param name Name to register the table under
+     * @return The import job id, or -1 on failure
+     */
+    int importWavetableBuffer(const std::vector<float>& samples, int sourceSampleRate, const std::string& name);
+    
+    /**
+     * Set the callback for wavetable import progress and completion:
+     * (jobId, status 0 = progress / 1 = completed / 2 = failed, progress 0.0 - 1.0, table handle).
+     * Called from the import thread.
+     */
+    void setWavetableImportCallback(std::function<void(int, int, float, int)> callback);
+    
+    /**
+     * Get the magnitude response of the master EQ, for drawing its curve.
+     * 
+     * @param magnitudesDb Receives numPoints magnitudes in dB
+     * @param numPoints Number of points, spaced logarithmically from minFrequency to maxFrequency
+     * @param minFrequency Frequency of the first point in Hz
+     * @param maxFrequency Frequency of the last point in Hz
+     * @return True on success, false on failure
+     */
+    bool getEqualizerResponse(float* magnitudesDb, int numPoints, float minFrequency, float maxFrequency);
+    
+    /**
+     * Set the breakpoints of the multi-segment modulation envelope.
+     * 
+     * @param times Time of each point from the start, in seconds (beats when tempo synced)
+     * @param levels Level of each point (0.0 - 1.0)
+     * @param curves Bend of the segment ending at each point (-1.0 - 1.0); empty for straight segments
+     * @param loopStart Index of the point the loop returns to, or -1 for no loop
+     * @param loopEnd Index of the point at which the loop returns, or -1
+     * @return True on success, false on failure
+     */
+    bool setMsegPoints(const std::vector<float>& times, const std::vector<float>& levels,
+                       const std::vector<float>& curves, int loopStart, int loopEnd);
+    
+    /**
+     * Load an impulse response into the convolution reverb. Prepares the
+     * whole response on the calling thread.
+     * 
+     * @param left The left channel (or only channel) of the response
+     * @param right The right channel; empty for a mono response
+     * @param irSampleRate The sample rate the response was recorded at
+     * @return True on success, false on failure
+     */
+    bool loadImpulseResponse(const std::vector<float>& left, const std::vector<float>& right, int irSampleRate);
+    
+    /**
+     * Set the order of the insert effects chain.
+     * 
+     * @param order Every effect slot exactly once, first processed first
+     *              (0 = modulation, 1 = delay, 2 = reverb, 3 = convolution)
+     * @return True on success, false on failure
+     */
+    bool setEffectsOrder(const std::vector<int>& order);
+    
+    /**
+     * @return The total latency of the enabled effects and the master EQ, in samples
+     */
+    int getEffectsLatency() const;
+    
+    /**
+     * @param slot The effect slot
+     * @return Its recent processing time as a fraction of real time, or 0.0 while bypassed
+     */
+    float getEffectSlotCpuLoad(int slot) const;
+    
+    /**
+     * @return The transport's song position at the end of the last audio block, in quarter notes
+     */
+    double getTransportPosition() const;
+    
+    /**
+     * @return The tempo in effect, in BPM (estimated from MIDI clock under external sync)
+     */
+    float getTransportTempo() const;
     
     /**
      * Audio analysis functions for visualization.
@@ -245,12 +388,42 @@ private:
     
     // Audio modules
     std::vector<std::unique_ptr<Oscillator>> oscillators;
-    std::unique_ptr<Filter> filter;
+    std::unique_ptr<Filter> filter;           // Filter settings, applied per voice by filterBanks
+    std::vector<std::unique_ptr<FilterBank>> filterBanks; // FilterBank::kMaxVoices voices each
     std::unique_ptr<Envelope> envelope;
-    std::unique_ptr<Delay> delay;
+    std::unique_ptr<MultiSegmentEnvelope> mseg; // Modulation envelope, routed by msegDestination
+    enum class MsegDestination { Off, FilterCutoff, Amplitude, Pitch };
+    std::atomic<int> msegDestination{0};
+    std::atomic<float> msegAmount{0.0f};
+    std::unique_ptr<Chorus> chorus;
+    std::unique_ptr<Flanger> flanger;
+    std::unique_ptr<Phaser> phaser;
+    enum class ModFxType { Off, Chorus, Flanger, Phaser };
+    std::atomic<int> modFxType{0};           // The modulation effect in use
+    int activeModFxType = 0;                 // Audio thread: the one processed last block
+    std::unique_ptr<StereoDelay> delay;
     std::unique_ptr<Reverb> reverb;
+    std::unique_ptr<ConvolutionReverb> convolutionReverb; // Silent until an impulse response is loaded
+    std::unique_ptr<EffectsChain> effectsChain; // Runs the insert effects above in a reorderable order
+    std::unique_ptr<Equalizer> equalizer;    // Master-bus parametric EQ
     std::unique_ptr<synth::WavetableManager> wavetableManager;
+    std::unique_ptr<synth::WavetableImporter> wavetableImporter;
     std::unique_ptr<synth::GranularSynthesizer> granularSynth;
+
+    // Tempo and play position. A sync division (see Transport::divisionBeats)
+    // locks a setting to the beat; 0 leaves it free running at the value last
+    // set, which is restored when sync is switched off.
+    std::unique_ptr<Transport> transport;
+    std::atomic<int> delaySyncDivision{0};
+    std::atomic<int> modFxSyncDivision{0};
+    std::atomic<int> granularSyncDivision{0};
+    std::atomic<float> freeDelayTime{0.5f};
+    std::atomic<float> freeDelayTimeRight{0.5f};
+    std::atomic<float> freeModFxRate{-1.0f};     // -1 = each effect's own default
+    std::atomic<float> freeGrainRate{10.0f};
+    int syncedDelayDivision = 0;                 // Audio thread: the divisions applied last block
+    int syncedModFxDivision = 0;
+    int syncedGranularDivision = 0;
     
     // Note tracking
     std::unordered_map<int, float> activeNotes; // note -> velocity
@@ -324,6 +497,9 @@ private:
     void initializeAudioAnalysis(int fftSze); // New method for FFT setup
     float noteToFrequency(int note) const;
     void updateAudioAnalysis(const float* buffer, int numFrames, int numChannels); // Will be updated for FFT
+    void initializeEffectsChain();
+    void processModulationEffect(float* left, float* right, int numFrames);
+    void applyTempoSync();
 
     // Placeholder for an actual FFT function
     // In a real scenario, this would call an FFT library (e.g., FFTW, KissFFT)
@@ -367,6 +543,22 @@ private:
     std::atomic<int> currentXYPadXParameterId;
     std::atomic<int> currentXYPadYParameterId;
 
+    // Vector synthesis: pad position and joystick envelope recording
+    struct VectorPathPoint {
+        float time;
+        float x;
+        float y;
+    };
+    bool setVectorParameter(int parameterId, float value, bool fromAutomation);
+    void publishVectorEnvelope();
+    static constexpr size_t kMaxVectorPathPoints = 4096; // Moves kept per gesture; later ones are dropped
+    std::mutex vectorEnvelopeMutex;
+    bool vectorEnvelopeRecording{false};
+    std::chrono::steady_clock::time_point vectorEnvelopeStartTime;
+    std::vector<VectorPathPoint> vectorEnvelopePath; // Reserved to kMaxVectorPathPoints when recording starts
+    std::atomic<float> vectorPadX{0.5f};
+    std::atomic<float> vectorPadY{0.5f};
+
     // Internal helper for preset application
     bool applyParameterMap(const std::unordered_map<int, float>& parameters, bool fromPreset);
     bool applyMidiMap(const std::unordered_map<int, int>& midiMappings);
@@ -451,6 +643,7 @@ namespace SynthParameterId {
     constexpr int filterCutoff = 10;
     constexpr int filterResonance = 11;
     constexpr int filterType = 12;
+    constexpr int filterGain = 13;             // Shelf gain (0.0 - 10.0)
     
     // Envelope parameters
     constexpr int attackTime = 20;
@@ -462,6 +655,13 @@ namespace SynthParameterId {
     constexpr int reverbMix = 30;
     constexpr int delayTime = 31;
     constexpr int delayFeedback = 32;
+    constexpr int delayTimeRight = 33;         // Seconds; delayTime sets both sides, this one the right only
+    constexpr int delayCrossFeedback = 34;     // 0.0 = each side feeds itself, 1.0 = each feeds the other
+    constexpr int delayPingPong = 35;          // 1 = mono input on the left, repeats alternate sides
+    constexpr int modFxType = 36;              // 0 = off, 1 = chorus, 2 = flanger, 3 = phaser
+    constexpr int modFxRate = 37;              // LFO rate in Hz
+    constexpr int modFxDepth = 38;
+    constexpr int modFxMix = 39;
     
     // Granular parameters
     constexpr int granularActive = 40;
@@ -503,6 +703,72 @@ namespace SynthParameterId {
     constexpr int xyPadXValue = 600; // Example ID for X value input
     constexpr int xyPadYValue = 601; // Example ID for Y value input
 
+    // Vector synthesis (oscillator type Vector), shared by every voice.
+    // Map the XY pad onto it with setXYPadXParameter(vectorX) / setXYPadYParameter(vectorY).
+    constexpr int vectorX = 610;
+    constexpr int vectorY = 611;
+    constexpr int vectorSmoothing = 612;       // Glide time in ms
+    constexpr int vectorEnvelopeRecord = 613;  // 1 = start recording pad moves, 0 = stop and apply
+    constexpr int vectorEnvelopeMode = 614;    // 0 = off, 1 = one-shot per note, 2 = loop
+    // Per-corner parameters. For corner c (0 = bottom-left, 1 = bottom-right,
+    // 2 = top-left, 3 = top-right), use: vectorCornerType + (c * 3)
+    constexpr int vectorCornerType = 620;      // Oscillator waveform type; Wavetable uses the handle below
+    constexpr int vectorCornerWavetable = 621;
+    constexpr int vectorCornerWavetablePosition = 622;
+
+    // FM parameters (shared by every voice whose oscillator type is FM)
+    constexpr int fmAlgorithm = 700;
+    constexpr int fmFeedback = 701;
+    // Per-operator parameters. For operator k (0-5), use: fmOperatorRatio + (k * 10)
+    constexpr int fmOperatorRatio = 710;
+    constexpr int fmOperatorLevel = 711;
+    constexpr int fmOperatorAttack = 712;
+    constexpr int fmOperatorDecay = 713;
+    constexpr int fmOperatorSustain = 714;
+    constexpr int fmOperatorRelease = 715;
+
+    // Additive parameters (shared by every voice whose oscillator type is Additive)
+    constexpr int additivePartialCount = 770;
+    constexpr int additiveTilt = 771;        // dB per octave
+    constexpr int additiveOddLevel = 772;
+    constexpr int additiveEvenLevel = 773;
+
+    // Master EQ parameters. For band b (0-7), use: eqBandType + (b * 10)
+    constexpr int eqBandType = 900;            // 0 = off, 1 = peak, 2 = low shelf, 3 = high shelf, 4 = low pass, 5 = high pass
+    constexpr int eqBandFrequency = 901;       // Hz
+    constexpr int eqBandGain = 902;            // dB
+    constexpr int eqBandQ = 903;
+
+    // Multi-segment modulation envelope (shape set with SetMsegPoints)
+    constexpr int msegDestination = 990;       // 0 = off, 1 = filter cutoff, 2 = amplitude, 3 = pitch
+    constexpr int msegAmount = 991;            // -1.0 - 1.0: +/-4 octaves of cutoff, full amplitude, +/-1 octave of pitch
+    constexpr int msegLoopMode = 992;          // 0 = off, 1 = sustain loop, 2 = repeat
+    constexpr int msegTempoSync = 993;         // 1 = point times are beats
+    constexpr int msegTempo = 994;             // Deprecated: sets and reads back transportTempo
+
+    // Insert effects chain. For slot s (0 = modulation, 1 = delay, 2 = reverb, 3 = convolution),
+    // use: effectSlotEnabled + (s * 10)
+    constexpr int effectSlotEnabled = 500;     // 0 = bypassed (crossfaded), 1 = processed
+    constexpr int effectSlotPosition = 501;    // Position in the chain, 0 = first
+
+    // Convolution reverb (impulse response loaded with LoadImpulseResponse)
+    constexpr int convolutionMix = 980;
+
+    // Transport and tempo sync. Sync divisions: 0 = free running, 1 = 4 bars, 2 = 2 bars, 3 = 1 bar,
+    // 4 = 1/2, 5 = 1/4, 6 = 1/8, 7 = 1/16, 8 = 1/32, 9 - 12 = dotted 1/2 - 1/16, 13 - 16 = triplet 1/2 - 1/16
+    constexpr int transportTempo = 1000;           // BPM (20 - 999)
+    constexpr int transportPlaying = 1001;         // 1 = playing
+    constexpr int timeSignatureNumerator = 1002;
+    constexpr int timeSignatureDenominator = 1003;
+    constexpr int transportExternalSync = 1004;    // 1 = follow MIDI clock, start, stop and song position
+    constexpr int transportPosition = 1005;        // Locate, in quarter notes
+    constexpr int delaySyncDivision = 1006;        // Delay time of both sides
+    constexpr int modFxSyncDivision = 1007;        // One modulation effect LFO cycle
+    constexpr int granularSyncDivision = 1008;     // Time between grains
+
+    // Granular grain limit
+    constexpr int granularMaxGrains = 1010;        // Grains sounding at once (1 - 4096)
+
 
     // Oscillator parameters (per oscillator)
     // For oscillator n, use: oscillatorType + (n * 10)
@@ -514,6 +780,20 @@ namespace SynthParameterId {
     constexpr int oscillatorWavetableIndex = 105;
     constexpr int oscillatorWavetablePosition = 106;
 
+    // Extended oscillator parameters (per oscillator)
+    // The block above is full, so these live in a second block with the same stride.
+    // For oscillator n, use: oscillatorUnisonVoices + (n * 10)
+    constexpr int oscillatorUnisonVoices = 1100;
+    constexpr int oscillatorUnisonDetune = 1101;        // Spread of the outer copies in cents
+    constexpr int oscillatorUnisonStereoSpread = 1102;
+    constexpr int oscillatorUnisonPhaseRandom = 1103;
+    constexpr int oscillatorPulseWidth = 1104;
+    constexpr int oscillatorSyncRatio = 1105;          // 1.0 = sync off
+    constexpr int oscillatorPwmDepth = 1106;
+    constexpr int oscillatorPwmRate = 1107;            // Hz, audio rates allowed
+    constexpr int oscillatorDistortion = 1108;         // Phase distortion / waveshaper amount
+    constexpr int oscillatorShape = 1109;              // Phase distortion variant / waveshaper curve morph
+
     // Placeholder for unmapped parameters or direct MIDI CC access if needed
     // This range assumes CCs 0-119 can be mapped.
     // FFI might expose these if direct CC binding is desired without named parameters.
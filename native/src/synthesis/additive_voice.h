@@ -0,0 +1,386 @@
+#ifndef ADDITIVE_VOICE_H
+#define ADDITIVE_VOICE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "fast_math.h"
+#include "kiss_fftr.h"
+
+/**
+ * A set of partials: amplitude and frequency ratio (relative to the played
+ * fundamental) for each partial. A harmonic set has ratio[i] == i + 1.
+ */
+struct PartialSet {
+    std::vector<float> amplitudes;
+    std::vector<float> ratios;
+
+    /**
+     * Create a harmonic set with 2/(pi n) amplitudes (a band-limited sawtooth).
+     */
+    static PartialSet sawtooth(int count) {
+        PartialSet set;
+        set.amplitudes.resize(count);
+        set.ratios.resize(count);
+        for (int i = 0; i < count; ++i) {
+            set.amplitudes[i] = 0.63661977f / static_cast<float>(i + 1);
+            set.ratios[i] = static_cast<float>(i + 1);
+        }
+        return set;
+    }
+};
+
+/**
+ * Additive oscillator voice rendered with the inverse-FFT method
+ * (Rodet & Depalle, "Spectral envelopes and inverse FFT synthesis").
+ *
+ * Instead of running a sine per partial, every hop the voice writes each
+ * partial into a spectrum as a short Blackman-Harris kernel (kKernelHalfWidth
+ * bins either side of the partial's fractional bin), runs one inverse real FFT
+ * and overlap-adds the windowed frame. The four-term Blackman-Harris window
+ * overlap-adds to a constant at a hop of N/4, so no synthesis-window division
+ * is needed. Per-hop cost is one FFT plus a few complex adds per partial, so
+ * the cost per sample barely moves between 8 and 512 partials.
+ *
+ * Amplitudes and frequencies change at hop boundaries; the overlapping
+ * windows crossfade between consecutive frames.
+ *
+ * The partial amplitudes and ratios are built on the control thread into a
+ * new table and published with a single atomic pointer store, picked up at
+ * the next hop; the gain settings are atomics. A replaced table is freed by
+ * a later edit, once every hop that could still be reading it has finished.
+ */
+class AdditiveVoice {
+public:
+    static constexpr int kMaxPartials = 512;
+    static constexpr int kFFTSize = 1024;
+    static constexpr int kHopSize = kFFTSize / 4;
+    static constexpr int kKernelHalfWidth = 4;
+    static constexpr int kKernelOversampling = 64;
+
+    AdditiveVoice() : sampleRate(44100), baseFrequency(440.0f), partialCount(kMaxPartials),
+                      tilt(0.0f), oddLevel(1.0f), evenLevel(1.0f), gainsDirty(true),
+                      published(nullptr), audioEpoch(0), appliedPartials(nullptr),
+                      outputPosition(kHopSize) {
+        inversePlan = kiss_fftr_alloc(kFFTSize, 1, nullptr, nullptr);
+        spectrum.assign(kFFTSize / 2 + 1, {0.0f, 0.0f});
+        frame.assign(kFFTSize, 0.0f);
+        overlap.assign(kFFTSize, 0.0f);
+        output.assign(kHopSize, 0.0f);
+        for (int i = 0; i < kMaxPartials; ++i) {
+            gain[i] = 0.0f;
+            phase[i] = 0.75f;
+        }
+        setPartials(PartialSet::sawtooth(kMaxPartials));
+    }
+
+    ~AdditiveVoice() {
+        if (inversePlan) {
+            kiss_fftr_free(inversePlan);
+        }
+    }
+
+    AdditiveVoice(const AdditiveVoice&) = delete;
+    AdditiveVoice& operator=(const AdditiveVoice&) = delete;
+
+    void setSampleRate(int sr) {
+        sampleRate = (sr > 0) ? sr : 44100;
+    }
+
+    void setFrequency(float freq) {
+        baseFrequency = freq;
+    }
+
+    /**
+     * Replace the partial amplitudes and ratios (control thread). Partials
+     * beyond the set are silenced.
+     */
+    void setPartials(const PartialSet& set) {
+        auto partials = std::make_unique<Partials>();
+        int count = std::min(static_cast<int>(set.amplitudes.size()), static_cast<int>(kMaxPartials));
+        for (int i = 0; i < kMaxPartials; ++i) {
+            bool inSet = i < count;
+            partials->amplitude[i] = inSet ? std::max(set.amplitudes[i], 0.0f) : 0.0f;
+            partials->ratio[i] = (inSet && i < static_cast<int>(set.ratios.size()) && set.ratios[i] > 0.0f)
+                ? set.ratios[i] : static_cast<float>(i + 1);
+        }
+        std::lock_guard<std::mutex> lock(editMutex);
+        publishLocked(std::move(partials));
+    }
+
+    /**
+     * Set the amplitude of a single partial (control thread).
+     *
+     * @param index The partial index (0 = fundamental)
+     * @param amplitude The linear amplitude
+     */
+    void setPartialAmplitude(int index, float amplitude) {
+        if (index < 0 || index >= kMaxPartials) return;
+        std::lock_guard<std::mutex> lock(editMutex);
+        auto partials = std::make_unique<Partials>(*owned);
+        partials->amplitude[index] = std::max(amplitude, 0.0f);
+        publishLocked(std::move(partials));
+    }
+
+    /**
+     * Limit how many partials are rendered.
+     *
+     * @param count Number of partials (1 - kMaxPartials)
+     */
+    void setPartialCount(int count) {
+        partialCount.store(std::clamp(count, 1, static_cast<int>(kMaxPartials)));
+        gainsDirty.store(true);
+    }
+
+    /**
+     * Set the spectral tilt.
+     *
+     * @param dbPerOctave Gain change per octave of partial number (-24.0 - 24.0)
+     */
+    void setTilt(float dbPerOctave) {
+        tilt.store(std::clamp(dbPerOctave, -24.0f, 24.0f));
+        gainsDirty.store(true);
+    }
+
+    /**
+     * Set the level of the odd-numbered harmonics (1st, 3rd, ...).
+     */
+    void setOddLevel(float l) {
+        oddLevel.store(std::clamp(l, 0.0f, 1.0f));
+        gainsDirty.store(true);
+    }
+
+    /**
+     * Set the level of the even-numbered harmonics (2nd, 4th, ...).
+     */
+    void setEvenLevel(float l) {
+        evenLevel.store(std::clamp(l, 0.0f, 1.0f));
+        gainsDirty.store(true);
+    }
+
+    /**
+     * Reset the partial phases and clear the overlap buffer for a new note.
+     */
+    void noteOn() {
+        for (int i = 0; i < kMaxPartials; ++i) {
+            phase[i] = 0.75f; // Sine phase; all-cosine starts would stack into a click
+        }
+        std::fill(overlap.begin(), overlap.end(), 0.0f);
+        outputPosition = kHopSize;
+    }
+
+    /**
+     * Get the next output sample, synthesizing a new hop when needed.
+     */
+    float nextSample() {
+        if (outputPosition >= kHopSize) {
+            synthesizeHop();
+            outputPosition = 0;
+        }
+        return output[outputPosition++];
+    }
+
+    /**
+     * Render numFrames samples into out.
+     */
+    void render(float* out, int numFrames) {
+        while (numFrames > 0) {
+            if (outputPosition >= kHopSize) {
+                synthesizeHop();
+                outputPosition = 0;
+            }
+            int count = std::min(numFrames, kHopSize - outputPosition);
+            std::copy(output.begin() + outputPosition, output.begin() + outputPosition + count, out);
+            outputPosition += count;
+            out += count;
+            numFrames -= count;
+        }
+    }
+
+private:
+    /**
+     * Partial amplitudes and frequency ratios. Immutable once published.
+     */
+    struct Partials {
+        float amplitude[kMaxPartials];
+        float ratio[kMaxPartials];
+    };
+
+    struct RetiredPartials {
+        std::unique_ptr<Partials> partials;
+        uint64_t epoch;
+    };
+
+    void publishLocked(std::unique_ptr<Partials> partials) {
+        collectRetiredLocked();
+        // Sequentially consistent store and epoch read: any hop that starts
+        // after the epoch we read is guaranteed to load the new table.
+        published.store(partials.get());
+        if (owned) {
+            retired.push_back({std::move(owned), audioEpoch.load()});
+        }
+        owned = std::move(partials);
+    }
+
+    void collectRetiredLocked() {
+        uint64_t epoch = audioEpoch.load();
+        std::vector<RetiredPartials> pending;
+        for (auto& entry : retired) {
+            if (epoch <= entry.epoch) {
+                pending.push_back(std::move(entry));
+            }
+        }
+        retired.swap(pending);
+    }
+
+    /**
+     * Zero-phase spectrum of the Blackman-Harris window, sampled at
+     * kKernelOversampling points per bin over [0, kKernelHalfWidth] and scaled
+     * by 1/N so that a unit partial comes out of the inverse FFT at unit level.
+     */
+    static const float* windowKernel() {
+        struct Table {
+            float values[kKernelHalfWidth * kKernelOversampling + 2];
+            Table() {
+                const double a[4] = {0.35875, 0.48829, 0.14128, 0.01168};
+                const double twoPi = 2.0 * 3.14159265358979323846;
+                const int size = kKernelHalfWidth * kKernelOversampling + 2;
+                for (int k = 0; k < size; ++k) {
+                    double delta = static_cast<double>(k) / kKernelOversampling;
+                    double sum = 0.0;
+                    for (int n = -kFFTSize / 2; n < kFFTSize / 2; ++n) {
+                        // Zero-phase window: centred on n = 0, so the odd cosine terms change sign
+                        double m = twoPi * n / kFFTSize;
+                        double w = a[0] + a[1] * std::cos(m) + a[2] * std::cos(2.0 * m) + a[3] * std::cos(3.0 * m);
+                        sum += w * std::cos(m * delta);
+                    }
+                    values[k] = static_cast<float>(sum / kFFTSize);
+                }
+            }
+        };
+        static const Table table;
+        return table.values;
+    }
+
+    static inline float kernelAt(const float* kernel, float delta) {
+        float position = std::abs(delta) * static_cast<float>(kKernelOversampling);
+        int index = static_cast<int>(position);
+        float fraction = position - static_cast<float>(index);
+        return kernel[index] + fraction * (kernel[index + 1] - kernel[index]);
+    }
+
+    void updateGains(const Partials& partials) {
+        // tilt dB/octave -> n^(tilt / 20 * log2(10)) == n^(tilt / 6.0206)
+        const float tiltDb = tilt.load();
+        const float exponent = tiltDb / 6.0206f;
+        const float odd = oddLevel.load();
+        const float even = evenLevel.load();
+        const int count = partialCount.load();
+        for (int i = 0; i < kMaxPartials; ++i) {
+            float harmonic = static_cast<float>(i + 1);
+            float parity = ((i & 1) == 0) ? odd : even;
+            float tiltGain = (tiltDb == 0.0f) ? 1.0f : fastmath::exp2(exponent * std::log2(harmonic));
+            gain[i] = (i < count) ? partials.amplitude[i] * parity * tiltGain : 0.0f;
+        }
+    }
+
+    void synthesizeHop() {
+        const Partials* partials = published.load();
+        if (gainsDirty.exchange(false) || partials != appliedPartials) {
+            updateGains(*partials);
+            appliedPartials = partials;
+        }
+        const float* ratio = partials->ratio;
+
+        const float* kernel = windowKernel();
+        const float binsPerHz = static_cast<float>(kFFTSize) / static_cast<float>(sampleRate);
+        const float maxBin = static_cast<float>(kFFTSize / 2 - kKernelHalfWidth - 1);
+        const float hopSeconds = static_cast<float>(kHopSize) / static_cast<float>(sampleRate);
+
+        std::fill(spectrum.begin(), spectrum.end(), kiss_fft_cpx{0.0f, 0.0f});
+
+        for (int i = 0; i < kMaxPartials; ++i) {
+            float amplitude = gain[i];
+            float frequency = baseFrequency * ratio[i];
+            float bin = frequency * binsPerHz;
+
+            if (amplitude > 0.0f && bin < maxBin) {
+                // Each real partial contributes (A/2) e^{i phi} W(k - bin); the (-1)^k
+                // factor moves the frame centre from n = 0 to n = N/2.
+                float half = 0.5f * amplitude;
+                float re = half * fastmath::cos2pi(phase[i]);
+                float im = half * fastmath::sin2pi(phase[i]);
+                int first = static_cast<int>(std::ceil(bin - kKernelHalfWidth));
+                int last = static_cast<int>(std::floor(bin + kKernelHalfWidth));
+
+                for (int k = first; k <= last; ++k) {
+                    float w = kernelAt(kernel, static_cast<float>(k) - bin);
+                    if (k & 1) {
+                        w = -w;
+                    }
+                    if (k > 0) {
+                        spectrum[k].r += re * w;
+                        spectrum[k].i += im * w;
+                    } else if (k == 0) {
+                        spectrum[0].r += 2.0f * re * w;
+                    } else {
+                        // Negative-frequency bins fold back as the complex conjugate
+                        spectrum[-k].r += re * w;
+                        spectrum[-k].i -= im * w;
+                    }
+                }
+            }
+
+            float advance = phase[i] + frequency * hopSeconds;
+            phase[i] = advance - std::floor(advance);
+        }
+
+        kiss_fftri(inversePlan, spectrum.data(), frame.data());
+
+        // Overlap-add: the Blackman-Harris window sums to 4 * a0 at a hop of N/4
+        const float norm = 1.0f / (4.0f * 0.35875f);
+        for (int n = 0; n < kFFTSize; ++n) {
+            overlap[n] += frame[n] * norm;
+        }
+        std::copy(overlap.begin(), overlap.begin() + kHopSize, output.begin());
+        std::copy(overlap.begin() + kHopSize, overlap.end(), overlap.begin());
+        std::fill(overlap.end() - kHopSize, overlap.end(), 0.0f);
+
+        audioEpoch.fetch_add(1);
+    }
+
+    int sampleRate;
+    float baseFrequency;
+
+    // Gain settings (control thread)
+    std::atomic<int> partialCount;
+    std::atomic<float> tilt;
+    std::atomic<float> oddLevel;
+    std::atomic<float> evenLevel;
+    std::atomic<bool> gainsDirty;
+
+    // Partial table publishing (under editMutex)
+    std::atomic<const Partials*> published;
+    std::atomic<uint64_t> audioEpoch; // Hops finished by the renderer
+    std::mutex editMutex;
+    std::unique_ptr<Partials> owned;
+    std::vector<RetiredPartials> retired;
+    const Partials* appliedPartials;  // Table the gains were last computed from (audio thread)
+
+    // Partial state (structure-of-arrays)
+    alignas(32) float gain[kMaxPartials];
+    alignas(32) float phase[kMaxPartials];
+
+    kiss_fftr_cfg inversePlan;
+    std::vector<kiss_fft_cpx> spectrum;
+    std::vector<float> frame;
+    std::vector<float> overlap;
+    std::vector<float> output;
+    int outputPosition;
+};
+
+#endif // ADDITIVE_VOICE_H
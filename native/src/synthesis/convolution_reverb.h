@@ -0,0 +1,568 @@
+#ifndef CONVOLUTION_REVERB_H
+#define CONVOLUTION_REVERB_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "kiss_fftr.h"
+
+/**
+ * Stereo convolution reverb for impulse responses of up to kMaxLength
+ * seconds, using partitioned FFT convolution (overlap-save with a
+ * frequency-domain delay line).
+ *
+ * The impulse response is split in two. The head (the first kTailOffset
+ * samples) is cut into short uniform partitions of kPartitionSize samples
+ * and convolved in the audio callback, so the wet signal is only
+ * kPartitionSize samples late and the callback never does more than one
+ * short FFT pair per channel per partition. The tail is cut into long
+ * partitions of kTailPartitionSize samples and convolved on a background
+ * worker thread. The tail starts two long partitions into the response, so
+ * the worker has a whole long partition of time to deliver each result
+ * before the audio thread needs it; if it falls behind, the late tail block
+ * is dropped rather than stalling the callback.
+ *
+ * Impulse responses are resampled, normalized, partitioned and transformed
+ * on the calling thread, then published with a single atomic pointer store
+ * and picked up by the audio thread and the worker at their next block. A
+ * replaced response is freed by a later load, once neither thread can
+ * still be reading it.
+ */
+class ConvolutionReverb {
+public:
+    static constexpr int kPartitionSize = 128;      // Samples per head partition (the wet delay; dry is not delayed)
+    static constexpr int kTailPartitionSize = 2048; // Samples per tail partition
+    static constexpr int kTailOffset = 2 * kTailPartitionSize;
+    static constexpr int kHeadPartitions = kTailOffset / kPartitionSize;
+    static constexpr float kMaxLength = 10.0f;      // Seconds
+
+    ConvolutionReverb() :
+        sampleRate(44100),
+        published(nullptr),
+        audioEpoch(0),
+        workerEpoch(0),
+        workerRunning(false),
+        kernel(nullptr),
+        inputTime(0),
+        headPosition(0),
+        headIndex(0),
+        tailFirstJob(0),
+        tailSubmitted(0),
+        tailResetJob(0) {
+        mix.store(0.3f);
+        headForward = kiss_fftr_alloc(2 * kPartitionSize, 0, nullptr, nullptr);
+        headInverse = kiss_fftr_alloc(2 * kPartitionSize, 1, nullptr, nullptr);
+        for (int c = 0; c < 2; ++c) {
+            headInput[c].assign(2 * kPartitionSize, 0.0f);
+            headOutput[c].assign(kPartitionSize, 0.0f);
+            headHistoryRe[c].assign(kHeadPartitions * kHeadBins, 0.0f);
+            headHistoryIm[c].assign(kHeadPartitions * kHeadBins, 0.0f);
+            tailInput[c].assign(kTailRing, 0.0f);
+            tailOutput[c].assign(kTailRing, 0.0f);
+        }
+        silence.assign(kPartitionSize, 0.0f);
+        headSpectrum.resize(kHeadBins);
+        headTime.resize(2 * kPartitionSize);
+        sumRe.resize(kHeadBins);
+        sumIm.resize(kHeadBins);
+        for (auto& job : regionJob) {
+            job.store(-1);
+        }
+    }
+
+    ~ConvolutionReverb() {
+        workerRunning.store(false);
+        if (worker.joinable()) {
+            worker.join();
+        }
+        kiss_fftr_free(headForward);
+        kiss_fftr_free(headInverse);
+    }
+
+    ConvolutionReverb(const ConvolutionReverb&) = delete;
+    ConvolutionReverb& operator=(const ConvolutionReverb&) = delete;
+
+    /**
+     * Set the sample rate. A loaded impulse response is prepared again for
+     * the new rate. Not realtime safe; call before processing starts.
+     *
+     * @param sr The sample rate
+     */
+    void setSampleRate(int sr) {
+        sr = (sr > 0) ? sr : 44100;
+        std::lock_guard<std::mutex> lock(editMutex);
+        if (sr == sampleRate) {
+            return;
+        }
+        sampleRate = sr;
+        if (owned) {
+            publishLocked(prepare(owned->sourceLeft, owned->sourceRight, owned->sourceRate, sampleRate));
+        }
+    }
+
+    /**
+     * Set the wet/dry mix.
+     *
+     * @param m The mix amount (0.0 = dry, 1.0 = wet)
+     */
+    void setMix(float m) {
+        mix.store(std::clamp(m, 0.0f, 1.0f));
+    }
+
+    /**
+     * Prepare and publish an impulse response (control thread). The
+     * response is resampled to the engine rate, cut to kMaxLength seconds and
+     * normalized to unit energy. Allocates and transforms the whole
+     * response, so call it from a UI or worker thread, never from the audio
+     * callback.
+     *
+     * @param left The left channel (or only channel) of the response
+     * @param right The right channel; empty for a mono response
+     * @param irSampleRate The sample rate the response was recorded at
+     * @return True on success, false if the response is empty or silent
+     */
+    bool loadImpulseResponse(const std::vector<float>& left, const std::vector<float>& right, int irSampleRate) {
+        if (left.empty() || irSampleRate <= 0) {
+            return false;
+        }
+        const std::vector<float>& secondChannel = (right.size() == left.size()) ? right : left;
+
+        std::lock_guard<std::mutex> lock(editMutex);
+        std::unique_ptr<Kernel> prepared = prepare(left, secondChannel, irSampleRate, sampleRate);
+        if (!prepared) {
+            return false;
+        }
+        if (!worker.joinable()) {
+            workerRunning.store(true);
+            worker = std::thread(&ConvolutionReverb::workerLoop, this);
+        }
+        publishLocked(std::move(prepared));
+        return true;
+    }
+
+    /**
+     * Check if an impulse response is loaded.
+     */
+    bool isLoaded() const {
+        return published.load() != nullptr;
+    }
+
+    /**
+     * Drop the reverb's state, so nothing heard before the call rings on
+     * after it (audio thread). The input clock moves on to the next tail
+     * partition boundary; tail results still in flight from before are
+     * ignored, and the worker starts its history afresh from there.
+     */
+    void clear() {
+        for (int c = 0; c < 2; ++c) {
+            std::fill(headInput[c].begin(), headInput[c].end(), 0.0f);
+            std::fill(headOutput[c].begin(), headOutput[c].end(), 0.0f);
+            std::fill(headHistoryRe[c].begin(), headHistoryRe[c].end(), 0.0f);
+            std::fill(headHistoryIm[c].begin(), headHistoryIm[c].end(), 0.0f);
+        }
+        headPosition = 0;
+        inputTime = (inputTime + kTailPartitionSize - 1) / kTailPartitionSize * kTailPartitionSize;
+        tailFirstJob = inputTime / kTailPartitionSize;
+        tailResetJob.store(tailFirstJob, std::memory_order_release);
+    }
+
+    /**
+     * Process a block of stereo audio in place. Passes the input through
+     * untouched until an impulse response is loaded.
+     *
+     * @param left Left channel samples
+     * @param right Right channel samples
+     * @param numFrames The number of frames
+     */
+    void processBlock(float* left, float* right, int numFrames) {
+        kernel = published.load();
+        if (!kernel) {
+            audioEpoch.fetch_add(1);
+            return;
+        }
+        const float wet = mix.load();
+        const float dry = 1.0f - wet;
+        float* io[2] = {left, right};
+
+        int frame = 0;
+        while (frame < numFrames) {
+            const int count = std::min(numFrames - frame, kPartitionSize - headPosition);
+
+            // Tail results for the wet samples of this run (the run never
+            // crosses a tail partition boundary)
+            const int64_t wetTime = inputTime - kPartitionSize;
+            bool tailReady = false;
+            if (wetTime >= kTailOffset) {
+                const int64_t job = (wetTime - kTailOffset) / kTailPartitionSize;
+                tailReady = job >= tailFirstJob && regionJob[regionOf(job)].load(std::memory_order_acquire) == job;
+            }
+            const int tailRead = static_cast<int>(wetTime & (kTailRing - 1));
+            const int tailWrite = static_cast<int>(inputTime & (kTailRing - 1));
+
+            for (int c = 0; c < 2; ++c) {
+                float* samples = io[c] + frame;
+                float* headIn = headInput[c].data() + kPartitionSize + headPosition;
+                const float* headOut = headOutput[c].data() + headPosition;
+                float* tailIn = tailInput[c].data() + tailWrite;
+                const float* tailOut = tailReady ? tailOutput[c].data() + tailRead : silence.data();
+                for (int i = 0; i < count; ++i) {
+                    const float in = samples[i];
+                    headIn[i] = in;
+                    tailIn[i] = in;
+                    samples[i] = in * dry + (headOut[i] + tailOut[i]) * wet;
+                }
+            }
+            frame += count;
+            headPosition += count;
+            inputTime += count;
+
+            if (headPosition == kPartitionSize) {
+                headPosition = 0;
+                convolveHead();
+                if (inputTime % kTailPartitionSize == 0) {
+                    // A tail partition of input is complete: hand it to the worker
+                    tailSubmitted.store(inputTime / kTailPartitionSize, std::memory_order_release);
+                }
+            }
+        }
+
+        audioEpoch.fetch_add(1);
+    }
+
+private:
+    static constexpr int kHeadBins = kPartitionSize + 1;
+    static constexpr int kTailBins = kTailPartitionSize + 1;
+    static constexpr int kTailSlots = 4;            // Tail partitions held by the input and output rings
+    static constexpr int kTailRing = kTailSlots * kTailPartitionSize;
+
+    /**
+     * A prepared impulse response: the spectra of its partitions, real and
+     * imaginary parts stored apart so the multiply-accumulate vectorizes.
+     * Spectra are pre-scaled by the inverse FFT normalization. Immutable
+     * once published.
+     */
+    struct Kernel {
+        int headPartitions;
+        int tailPartitions;
+        std::vector<float> headRe[2];   // headPartitions * kHeadBins
+        std::vector<float> headIm[2];
+        std::vector<float> tailRe[2];   // tailPartitions * kTailBins
+        std::vector<float> tailIm[2];
+        std::vector<float> sourceLeft;  // As loaded, to prepare again for another sample rate
+        std::vector<float> sourceRight;
+        int sourceRate;
+    };
+
+    struct RetiredKernel {
+        std::unique_ptr<Kernel> kernel;
+        uint64_t audioEpoch;
+        uint64_t workerEpoch;
+    };
+
+    static int regionOf(int64_t job) {
+        // Tail job j fills wet samples from j * kTailPartitionSize + kTailOffset
+        return static_cast<int>((job + kTailOffset / kTailPartitionSize) % kTailSlots);
+    }
+
+    static std::unique_ptr<Kernel> prepare(const std::vector<float>& left, const std::vector<float>& right,
+                                           int sourceRate, int targetRate) {
+        // Resample (linear) to the engine rate and trim to the maximum length
+        const double step = static_cast<double>(sourceRate) / targetRate;
+        const int length = std::min(static_cast<int>(std::ceil(static_cast<double>(left.size()) / step)),
+                                    static_cast<int>(kMaxLength * static_cast<float>(targetRate)));
+        std::vector<float> channels[2];
+        double energy = 0.0;
+        for (int c = 0; c < 2; ++c) {
+            const std::vector<float>& source = c ? right : left;
+            channels[c].resize(length);
+            double channelEnergy = 0.0;
+            for (int n = 0; n < length; ++n) {
+                const double position = n * step;
+                const size_t index = static_cast<size_t>(position);
+                const float fraction = static_cast<float>(position - static_cast<double>(index));
+                const float a = source[index];
+                const float b = (index + 1 < source.size()) ? source[index + 1] : 0.0f;
+                channels[c][n] = a + fraction * (b - a);
+                channelEnergy += static_cast<double>(channels[c][n]) * channels[c][n];
+            }
+            energy = std::max(energy, channelEnergy);
+        }
+        if (length <= 0 || energy < 1e-12) {
+            return nullptr;
+        }
+
+        auto prepared = std::make_unique<Kernel>();
+        prepared->headPartitions = std::min(kHeadPartitions, (length + kPartitionSize - 1) / kPartitionSize);
+        prepared->tailPartitions = std::max(0, (length - kTailOffset + kTailPartitionSize - 1) / kTailPartitionSize);
+        prepared->sourceLeft = left;
+        prepared->sourceRight = right;
+        prepared->sourceRate = sourceRate;
+
+        const float gain = static_cast<float>(1.0 / std::sqrt(energy));
+        for (int c = 0; c < 2; ++c) {
+            transformPartitions(channels[c], 0, prepared->headPartitions, kPartitionSize,
+                                gain / (2 * kPartitionSize), prepared->headRe[c], prepared->headIm[c]);
+            transformPartitions(channels[c], kTailOffset, prepared->tailPartitions, kTailPartitionSize,
+                                gain / (2 * kTailPartitionSize), prepared->tailRe[c], prepared->tailIm[c]);
+        }
+        return prepared;
+    }
+
+    /**
+     * Transform consecutive partitions of a response, each zero-padded to
+     * twice its size for overlap-save.
+     */
+    static void transformPartitions(const std::vector<float>& response, int start, int partitions, int size,
+                                    float scale, std::vector<float>& re, std::vector<float>& im) {
+        const int bins = size + 1;
+        re.assign(static_cast<size_t>(partitions) * bins, 0.0f);
+        im.assign(static_cast<size_t>(partitions) * bins, 0.0f);
+        if (partitions == 0) {
+            return;
+        }
+        kiss_fftr_cfg plan = kiss_fftr_alloc(2 * size, 0, nullptr, nullptr);
+        std::vector<kiss_fft_scalar> frame(2 * size);
+        std::vector<kiss_fft_cpx> spectrum(bins);
+        for (int p = 0; p < partitions; ++p) {
+            std::fill(frame.begin(), frame.end(), 0.0f);
+            const int from = start + p * size;
+            const int count = std::min(size, static_cast<int>(response.size()) - from);
+            for (int n = 0; n < count; ++n) {
+                frame[n] = response[from + n] * scale;
+            }
+            kiss_fftr(plan, frame.data(), spectrum.data());
+            for (int k = 0; k < bins; ++k) {
+                re[static_cast<size_t>(p) * bins + k] = spectrum[k].r;
+                im[static_cast<size_t>(p) * bins + k] = spectrum[k].i;
+            }
+        }
+        kiss_fftr_free(plan);
+    }
+
+    /**
+     * Publish a prepared kernel and retire the old one (under editMutex).
+     */
+    void publishLocked(std::unique_ptr<Kernel> prepared) {
+        collectRetiredLocked();
+        // Sequentially consistent store and epoch reads: any block that
+        // starts after the epochs we read is guaranteed to see the new kernel.
+        published.store(prepared.get());
+        if (owned) {
+            retired.push_back({std::move(owned), audioEpoch.load(), workerEpoch.load()});
+        }
+        owned = std::move(prepared);
+    }
+
+    void collectRetiredLocked() {
+        const uint64_t audio = audioEpoch.load();
+        const uint64_t work = workerEpoch.load();
+        std::vector<RetiredKernel> pending;
+        for (auto& entry : retired) {
+            if (audio <= entry.audioEpoch || work <= entry.workerEpoch) {
+                pending.push_back(std::move(entry));
+            }
+        }
+        retired.swap(pending);
+    }
+
+    /**
+     * Multiply-accumulate a spectrum history against a kernel's partitions:
+     * sum over p of history[newest - p] * kernel[p].
+     */
+    static void accumulate(const float* historyRe, const float* historyIm, int historyLength, int newest,
+                           const float* kernelRe, const float* kernelIm, int partitions, int bins,
+                           float* outRe, float* outIm) {
+        std::fill(outRe, outRe + bins, 0.0f);
+        std::fill(outIm, outIm + bins, 0.0f);
+        for (int p = 0; p < partitions; ++p) {
+            const int slot = (newest - p + historyLength) % historyLength;
+            const float* xRe = historyRe + static_cast<size_t>(slot) * bins;
+            const float* xIm = historyIm + static_cast<size_t>(slot) * bins;
+            const float* hRe = kernelRe + static_cast<size_t>(p) * bins;
+            const float* hIm = kernelIm + static_cast<size_t>(p) * bins;
+            for (int k = 0; k < bins; ++k) {
+                outRe[k] += xRe[k] * hRe[k] - xIm[k] * hIm[k];
+                outIm[k] += xRe[k] * hIm[k] + xIm[k] * hRe[k];
+            }
+        }
+    }
+
+    /**
+     * Convolve the head partition of input just completed (audio thread).
+     * Leaves the wet head output for the next kPartitionSize samples in
+     * headOutput.
+     */
+    void convolveHead() {
+        for (int c = 0; c < 2; ++c) {
+            float* input = headInput[c].data();
+            kiss_fftr(headForward, input, headSpectrum.data());
+            float* historyRe = headHistoryRe[c].data() + static_cast<size_t>(headIndex) * kHeadBins;
+            float* historyIm = headHistoryIm[c].data() + static_cast<size_t>(headIndex) * kHeadBins;
+            for (int k = 0; k < kHeadBins; ++k) {
+                historyRe[k] = headSpectrum[k].r;
+                historyIm[k] = headSpectrum[k].i;
+            }
+            // Slide the overlap-save frame along by one partition
+            std::copy(input + kPartitionSize, input + 2 * kPartitionSize, input);
+
+            accumulate(headHistoryRe[c].data(), headHistoryIm[c].data(), kHeadPartitions, headIndex,
+                       kernel->headRe[c].data(), kernel->headIm[c].data(), kernel->headPartitions, kHeadBins,
+                       sumRe.data(), sumIm.data());
+            for (int k = 0; k < kHeadBins; ++k) {
+                headSpectrum[k].r = sumRe[k];
+                headSpectrum[k].i = sumIm[k];
+            }
+            kiss_fftri(headInverse, headSpectrum.data(), headTime.data());
+            std::copy(headTime.begin() + kPartitionSize, headTime.end(), headOutput[c].begin());
+        }
+        headIndex = (headIndex + 1) % kHeadPartitions;
+    }
+
+    /**
+     * Background thread: convolve each tail partition of input as the audio
+     * thread completes it.
+     */
+    void workerLoop() {
+        kiss_fftr_cfg forward = kiss_fftr_alloc(2 * kTailPartitionSize, 0, nullptr, nullptr);
+        kiss_fftr_cfg inverse = kiss_fftr_alloc(2 * kTailPartitionSize, 1, nullptr, nullptr);
+        std::vector<kiss_fft_scalar> frame(2 * kTailPartitionSize);
+        std::vector<kiss_fft_cpx> spectrum(kTailBins);
+        std::vector<float> outRe(kTailBins);
+        std::vector<float> outIm(kTailBins);
+        std::vector<float> previous[2];
+        std::vector<float> historyRe[2];
+        std::vector<float> historyIm[2];
+        int historyLength = 0;
+        int historyIndex = 0;
+        int64_t nextJob = 0;
+        int64_t resetJob = 0;
+
+        while (workerRunning.load()) {
+            const int64_t reset = tailResetJob.load(std::memory_order_acquire);
+            if (reset != resetJob) {
+                // The audio thread cleared the reverb: skip to the first job
+                // after the clear and drop the history of the input before it
+                resetJob = reset;
+                nextJob = std::max(nextJob, reset);
+                historyLength = 0;
+            }
+            const int64_t submitted = tailSubmitted.load(std::memory_order_acquire);
+            if (nextJob >= submitted) {
+                workerEpoch.fetch_add(1);
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            if (submitted - nextJob >= kTailSlots - 1) {
+                // Fell too far behind: the input ring has moved on. Drop to
+                // the newest partition and start the tail history afresh.
+                nextJob = submitted - 1;
+                historyLength = 0;
+            }
+
+            const Kernel* current = published.load();
+            const int partitions = current ? current->tailPartitions : 0;
+            if (partitions > historyLength) {
+                for (int c = 0; c < 2; ++c) {
+                    previous[c].assign(kTailPartitionSize, 0.0f);
+                    historyRe[c].assign(static_cast<size_t>(partitions) * kTailBins, 0.0f);
+                    historyIm[c].assign(static_cast<size_t>(partitions) * kTailBins, 0.0f);
+                }
+                historyLength = partitions;
+                historyIndex = 0;
+            }
+
+            const int inputStart = static_cast<int>((nextJob * kTailPartitionSize) & (kTailRing - 1));
+            const int outputStart = static_cast<int>((nextJob * kTailPartitionSize + kTailOffset) & (kTailRing - 1));
+            for (int c = 0; c < 2; ++c) {
+                const float* input = tailInput[c].data() + inputStart;
+                float* output = tailOutput[c].data() + outputStart;
+                if (partitions == 0) {
+                    std::fill(output, output + kTailPartitionSize, 0.0f);
+                    continue;
+                }
+                std::copy(previous[c].begin(), previous[c].end(), frame.begin());
+                std::copy(input, input + kTailPartitionSize, frame.begin() + kTailPartitionSize);
+                std::copy(input, input + kTailPartitionSize, previous[c].begin());
+
+                kiss_fftr(forward, frame.data(), spectrum.data());
+                float* slotRe = historyRe[c].data() + static_cast<size_t>(historyIndex) * kTailBins;
+                float* slotIm = historyIm[c].data() + static_cast<size_t>(historyIndex) * kTailBins;
+                for (int k = 0; k < kTailBins; ++k) {
+                    slotRe[k] = spectrum[k].r;
+                    slotIm[k] = spectrum[k].i;
+                }
+                accumulate(historyRe[c].data(), historyIm[c].data(), historyLength, historyIndex,
+                           current->tailRe[c].data(), current->tailIm[c].data(), partitions, kTailBins,
+                           outRe.data(), outIm.data());
+                for (int k = 0; k < kTailBins; ++k) {
+                    spectrum[k].r = outRe[k];
+                    spectrum[k].i = outIm[k];
+                }
+                kiss_fftri(inverse, spectrum.data(), frame.data());
+                std::copy(frame.begin() + kTailPartitionSize, frame.end(), output);
+            }
+            if (historyLength > 0) {
+                historyIndex = (historyIndex + 1) % historyLength;
+            }
+
+            // Only publish the result if the input was not overwritten while we read it
+            if (tailSubmitted.load(std::memory_order_acquire) - nextJob < kTailSlots - 1) {
+                regionJob[regionOf(nextJob)].store(nextJob, std::memory_order_release);
+            }
+            ++nextJob;
+            workerEpoch.fetch_add(1);
+        }
+
+        kiss_fftr_free(forward);
+        kiss_fftr_free(inverse);
+    }
+
+    int sampleRate;
+    std::atomic<float> mix;
+
+    // Kernel publishing (control thread, under editMutex)
+    std::atomic<const Kernel*> published;
+    std::atomic<uint64_t> audioEpoch;  // Blocks processed so far
+    std::atomic<uint64_t> workerEpoch; // Worker passes so far
+    std::mutex editMutex;
+    std::unique_ptr<Kernel> owned;
+    std::vector<RetiredKernel> retired;
+
+    // Tail worker
+    std::thread worker;
+    std::atomic<bool> workerRunning;
+
+    // Audio thread state
+    const Kernel* kernel;
+    int64_t inputTime;                      // Input samples consumed
+    int headPosition;                       // Samples into the current head partition
+    int headIndex;                          // Newest slot of the head spectrum history
+    int64_t tailFirstJob;                   // First tail job since the last clear()
+    kiss_fftr_cfg headForward;
+    kiss_fftr_cfg headInverse;
+    std::vector<float> headInput[2];        // Previous and current partition (the overlap-save frame)
+    std::vector<float> headOutput[2];       // Wet head samples for the current partition
+    std::vector<float> headHistoryRe[2];    // Spectra of the last kHeadPartitions input partitions
+    std::vector<float> headHistoryIm[2];
+    std::vector<kiss_fft_cpx> headSpectrum;
+    std::vector<kiss_fft_scalar> headTime;
+    std::vector<float> sumRe;
+    std::vector<float> sumIm;
+    std::vector<float> silence;             // Stands in for tail results that are not ready
+
+    // Shared with the worker: input and wet tail rings indexed by sample time,
+    // kTailSlots partitions long
+    std::vector<float> tailInput[2];
+    std::vector<float> tailOutput[2];
+    std::atomic<int64_t> tailSubmitted;     // Tail partitions of input completed
+    std::atomic<int64_t> regionJob[kTailSlots]; // Tail job whose result each output slot holds
+    std::atomic<int64_t> tailResetJob;      // tailFirstJob, for the worker
+};
+
+#endif // CONVOLUTION_REVERB_H
@@ -0,0 +1,321 @@
+#ifndef EFFECTS_CHAIN_H
+#define EFFECTS_CHAIN_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Ordered chain of stereo insert effects.
+ *
+ * Each slot wraps one effect's block processor along with an enable switch,
+ * the latency the effect reports and a running measure of its CPU load.
+ * Switching a slot on or off crossfades between its input and output over
+ * kCrossfadeTime instead of clicking. Once the fade out has finished the
+ * slot is skipped entirely, so a bypassed effect costs nothing, and its
+ * optional reset callback clears the effect's state, so re-enabling it
+ * later does not bring back the old tail. The reset runs a bounded step
+ * per block until it reports the state clear; a slot re-enabled before
+ * then waits for it before fading back in.
+ *
+ * The processing order is an immutable snapshot published with a single
+ * atomic pointer store and picked up at the start of the next block; the
+ * audio thread never locks. A replaced snapshot is freed by a later edit,
+ * once the audio thread has finished every block that could still be
+ * reading it.
+ *
+ * Slots are added during setup, before processing starts. Enabling,
+ * reordering and the queries may be called from any thread afterwards.
+ */
+class EffectsChain {
+public:
+    static constexpr int kMaxSlots = 8;
+    static constexpr int kMaxBlockSize = 256;      // Longer blocks are processed in pieces
+    static constexpr float kCrossfadeTime = 0.02f; // Seconds
+
+    using Processor = std::function<void(float* left, float* right, int numFrames)>;
+    using Reset = std::function<bool()>;
+
+    EffectsChain() : sampleRate(44100), slotCount(0), published(nullptr), audioEpoch(0) {
+        std::lock_guard<std::mutex> lock(editMutex);
+        publishOrderLocked(std::vector<int>());
+    }
+
+    EffectsChain(const EffectsChain&) = delete;
+    EffectsChain& operator=(const EffectsChain&) = delete;
+
+    /**
+     * @param sr The sample rate
+     */
+    void setSampleRate(int sr) {
+        sampleRate = (sr > 0) ? sr : 44100;
+    }
+
+    /**
+     * Add an effect at the end of the chain, enabled. Setup only; not safe
+     * once processing has started.
+     *
+     * @param name A name for display
+     * @param process Processes a stereo block in place
+     * @param latency Samples by which the effect delays its whole output; a
+     *                delay of the wet signal alone is predelay and counts as 0
+     * @param reset Clears part of the effect's state, returning true once all of it is
+     *              clear; called once per block after the slot is bypassed until it
+     *              does (audio thread). May be empty
+     * @return The slot index, or -1 if the chain is full
+     */
+    int addSlot(const std::string& name, Processor process, int latency = 0, Reset reset = Reset()) {
+        if (slotCount >= kMaxSlots || !process) {
+            return -1;
+        }
+        auto slot = std::make_unique<Slot>();
+        slot->name = name;
+        slot->process = std::move(process);
+        slot->reset = std::move(reset);
+        slot->latency = std::max(0, latency);
+        slots[slotCount] = std::move(slot);
+
+        std::lock_guard<std::mutex> lock(editMutex);
+        std::vector<int> order = orderLocked();
+        order.push_back(slotCount++);
+        publishOrderLocked(order);
+        return slotCount - 1;
+    }
+
+    int getSlotCount() const {
+        return slotCount;
+    }
+
+    const std::string& getSlotName(int slot) const {
+        static const std::string none;
+        return isValid(slot) ? slots[slot]->name : none;
+    }
+
+    /**
+     * Switch a slot on or off, with a crossfade.
+     *
+     * @param slot The slot index
+     * @param enabled True to process, false to bypass
+     */
+    void setEnabled(int slot, bool enabled) {
+        if (isValid(slot)) {
+            slots[slot]->enabled.store(enabled);
+        }
+    }
+
+    bool isEnabled(int slot) const {
+        return isValid(slot) && slots[slot]->enabled.load();
+    }
+
+    /**
+     * Set the processing order.
+     *
+     * @param order Every slot index exactly once, first processed first
+     * @return True on success, false if order is not a permutation of the slots
+     */
+    bool setOrder(const std::vector<int>& order) {
+        if (static_cast<int>(order.size()) != slotCount) {
+            return false;
+        }
+        bool seen[kMaxSlots] = {};
+        for (int slot : order) {
+            if (!isValid(slot) || seen[slot]) {
+                return false;
+            }
+            seen[slot] = true;
+        }
+        std::lock_guard<std::mutex> lock(editMutex);
+        publishOrderLocked(order);
+        return true;
+    }
+
+    /**
+     * Move one slot to a new position, shifting the others along.
+     *
+     * @param slot The slot index
+     * @param position Its new position in the chain (0 = first)
+     * @return True on success, false on an invalid slot
+     */
+    bool moveSlot(int slot, int position) {
+        if (!isValid(slot)) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(editMutex);
+        std::vector<int> order = orderLocked();
+        order.erase(std::find(order.begin(), order.end(), slot));
+        position = std::clamp(position, 0, static_cast<int>(order.size()));
+        order.insert(order.begin() + position, slot);
+        publishOrderLocked(order);
+        return true;
+    }
+
+    /**
+     * @return The slot indices in processing order
+     */
+    std::vector<int> getOrder() {
+        std::lock_guard<std::mutex> lock(editMutex);
+        return orderLocked();
+    }
+
+    /**
+     * @return The total latency of the enabled slots, in samples
+     */
+    int getLatency() const {
+        int total = 0;
+        for (int slot = 0; slot < slotCount; ++slot) {
+            if (slots[slot]->enabled.load()) {
+                total += slots[slot]->latency;
+            }
+        }
+        return total;
+    }
+
+    /**
+     * @param slot The slot index
+     * @return The slot's recent processing time as a fraction of the audio
+     *         it processed (1.0 = a whole core), or 0.0 while bypassed
+     */
+    float getCpuLoad(int slot) const {
+        return isValid(slot) ? slots[slot]->cpuLoad.load(std::memory_order_relaxed) : 0.0f;
+    }
+
+    /**
+     * Run a block of stereo audio through the chain, in place (audio thread).
+     *
+     * @param left Left channel samples
+     * @param right Right channel samples
+     * @param numFrames The number of frames
+     */
+    void processBlock(float* left, float* right, int numFrames) {
+        const Order* order = published.load();
+        for (int start = 0; start < numFrames; start += kMaxBlockSize) {
+            const int frames = std::min(kMaxBlockSize, numFrames - start);
+            for (int k = 0; k < order->count; ++k) {
+                processSlot(*slots[order->slots[k]], left + start, right + start, frames);
+            }
+        }
+        audioEpoch.fetch_add(1);
+    }
+
+private:
+    struct Slot {
+        std::string name;
+        Processor process;
+        Reset reset;
+        int latency = 0;
+        std::atomic<bool> enabled{true};
+        std::atomic<float> cpuLoad{0.0f};
+        float fade = 1.0f; // Audio thread: 0.0 = bypassed, 1.0 = fully in
+        bool resetPending = false; // Audio thread: reset started but not finished
+    };
+
+    /**
+     * A processing order. Immutable once published.
+     */
+    struct Order {
+        int slots[kMaxSlots];
+        int count;
+    };
+
+    struct RetiredOrder {
+        std::unique_ptr<Order> order;
+        uint64_t epoch;
+    };
+
+    bool isValid(int slot) const {
+        return slot >= 0 && slot < slotCount;
+    }
+
+    std::vector<int> orderLocked() const {
+        return std::vector<int>(owned->slots, owned->slots + owned->count);
+    }
+
+    void publishOrderLocked(const std::vector<int>& slotOrder) {
+        auto order = std::make_unique<Order>();
+        order->count = static_cast<int>(slotOrder.size());
+        std::copy(slotOrder.begin(), slotOrder.end(), order->slots);
+
+        collectRetiredLocked();
+        // Sequentially consistent store and epoch read: any block that starts
+        // after the epoch we read is guaranteed to load the new order.
+        published.store(order.get());
+        if (owned) {
+            retired.push_back({std::move(owned), audioEpoch.load()});
+        }
+        owned = std::move(order);
+    }
+
+    void collectRetiredLocked() {
+        uint64_t epoch = audioEpoch.load();
+        std::vector<RetiredOrder> pending;
+        for (auto& entry : retired) {
+            if (epoch <= entry.epoch) {
+                pending.push_back(std::move(entry));
+            }
+        }
+        retired.swap(pending);
+    }
+
+    void processSlot(Slot& slot, float* left, float* right, int numFrames) {
+        const float target = slot.enabled.load() ? 1.0f : 0.0f;
+        if (slot.fade == 0.0f && (target == 0.0f || slot.resetPending)) {
+            // Bypassed, or re-enabled while a reset is still clearing the state
+            if (slot.resetPending) {
+                slot.resetPending = !slot.reset();
+            }
+            slot.cpuLoad.store(0.0f, std::memory_order_relaxed);
+            return;
+        }
+
+        const auto started = std::chrono::steady_clock::now();
+        if (slot.fade == 1.0f && target == 1.0f) {
+            slot.process(left, right, numFrames);
+        } else {
+            // Crossfade between the slot's input and output
+            std::copy(left, left + numFrames, dryLeft);
+            std::copy(right, right + numFrames, dryRight);
+            slot.process(left, right, numFrames);
+            const float step = (target > slot.fade ? 1.0f : -1.0f) / (kCrossfadeTime * static_cast<float>(sampleRate));
+            float fade = slot.fade;
+            for (int i = 0; i < numFrames; ++i) {
+                fade = std::clamp(fade + step, 0.0f, 1.0f);
+                left[i] = dryLeft[i] + fade * (left[i] - dryLeft[i]);
+                right[i] = dryRight[i] + fade * (right[i] - dryRight[i]);
+            }
+            slot.fade = fade;
+            if (fade == 0.0f && slot.reset) {
+                // Fully bypassed from here on
+                slot.resetPending = !slot.reset();
+            }
+        }
+        const float elapsed = std::chrono::duration<float>(std::chrono::steady_clock::now() - started).count();
+
+        // Smoothed over roughly the last 20 blocks
+        const float load = elapsed * static_cast<float>(sampleRate) / static_cast<float>(numFrames);
+        const float previous = slot.cpuLoad.load(std::memory_order_relaxed);
+        slot.cpuLoad.store(previous + 0.05f * (load - previous), std::memory_order_relaxed);
+    }
+
+    int sampleRate;
+    std::unique_ptr<Slot> slots[kMaxSlots];
+    int slotCount;
+
+    // Order publishing (under editMutex)
+    std::atomic<const Order*> published;
+    std::atomic<uint64_t> audioEpoch; // Blocks processed so far
+    std::mutex editMutex;
+    std::unique_ptr<Order> owned;
+    std::vector<RetiredOrder> retired;
+
+    // Audio thread scratch for crossfades
+    float dryLeft[kMaxBlockSize];
+    float dryRight[kMaxBlockSize];
+};
+
+#endif // EFFECTS_CHAIN_H
@@ -3,9 +3,25 @@
 
 #include <cmath>
 #include <algorithm>
+#include <atomic>
+#include "fast_math.h"
 
 /**
  * ADSR (Attack, Decay, Sustain, Release) envelope generator.
+ * 
+ * Stages are rendered as chains of recursive segments. When a stage starts,
+ * its curve is split into kSegments pieces and each piece is fitted with a
+ * one-pole curve (level = level * multiplier + offset) that meets the curve
+ * at both ends and at its midpoint, so rendering costs a single multiply-add
+ * per sample and the curve functions are only evaluated at stage starts.
+ * The fit is exact for linear curves, within 0.6% for the exponential and
+ * S-curves and within 1.6% for the logarithmic curve.
+ * 
+ * Stage times are taken when a stage starts: changing them affects the next
+ * stage, not the one in progress. The sustain level applies immediately.
+ * 
+ * noteOn()/noteOff() may be called from any thread; they are applied at the
+ * start of the next block, so the segments are only touched by the renderer.
  */
 class Envelope {
 public:
@@ -24,6 +40,8 @@ public:
         SCurve
     };
     
+    static constexpr int kSegments = 8; // Recursive segments per stage
+    
     Envelope() : 
         sampleRate(44100),
         attackTime(0.01f),
@@ -35,9 +53,13 @@ public:
         releaseCurve(CurveType::Exponential),
         currentState(State::Idle),
         currentLevel(0.0f),
-        currentTime(0.0f),
-        releaseLevel(0.0f),
-        velocity(1.0f) {
+        velocity(1.0f),
+        segmentCount(0),
+        segmentIndex(0),
+        segmentRemaining(0),
+        pendingVelocity(1.0f),
+        triggerPending(false),
+        releasePending(false) {
     }
     
     ~Envelope() = default;
@@ -48,26 +70,17 @@ public:
      * @param vel Velocity value (0.0 - 1.0)
      */
     void noteOn(float vel = 1.0f) {
-        currentState = State::Attack;
-        currentTime = 0.0f;
-        velocity = vel;
-        
-        // If already have some level (e.g., legato notes), start from there
-        // Otherwise, reset to zero
-        if (currentLevel <= 0.001f) {
-            currentLevel = 0.0f;
-        }
+        pendingVelocity.store(vel);
+        // A release posted earlier is superseded by the new note
+        releasePending.store(false);
+        triggerPending.store(true);
     }
     
     /**
      * Trigger the envelope release phase.
      */
     void noteOff() {
-        if (currentState != State::Idle) {
-            currentState = State::Release;
-            releaseLevel = currentLevel;
-            currentTime = 0.0f;
-        }
+        releasePending.store(true);
     }
     
     /**
@@ -77,93 +90,66 @@ public:
      */
     float process() {
         float output = 0.0f;
-        float samplesPerMs = sampleRate / 1000.0f;
+        processBlock(&output, 1);
+        return output;
+    }
+    
+    /**
+     * Render a block of envelope values.
+     * 
+     * Frames after the envelope has finished are filled with 0.0.
+     * 
+     * @param output Buffer for numFrames values (0.0 - 1.0)
+     * @param numFrames The number of frames to render
+     * @return The number of frames rendered while the envelope was active,
+     *         including the one on which it finished
+     */
+    int processBlock(float* output, int numFrames) {
+        // Loads first, so that stepping per sample stays cheap when nothing is posted
+        if (triggerPending.load(std::memory_order_relaxed) && triggerPending.exchange(false)) {
+            velocity = pendingVelocity.load();
+            
+            // If already have some level (e.g., legato notes), start from there
+            // Otherwise, reset to zero
+            if (currentLevel <= 0.001f) {
+                currentLevel = 0.0f;
+            }
+            startStage(State::Attack);
+        }
+        if (releasePending.load(std::memory_order_relaxed) && releasePending.exchange(false)
+            && currentState != State::Idle) {
+            startStage(State::Release);
+        }
         
-        switch (currentState) {
-            case State::Attack: {
-                // Convert to milliseconds for more precise short attacks
-                float attackMs = attackTime * 1000.0f;
-                currentTime += 1.0f / samplesPerMs;
-                
-                if (attackMs <= 0.0f) {
-                    // Instant attack
-                    currentLevel = 1.0f * velocity;
-                    currentState = State::Decay;
-                    currentTime = 0.0f;
-                } else {
-                    // Apply attack curve
-                    float attackProgress = currentTime / attackMs;
-                    if (attackProgress >= 1.0f) {
-                        currentLevel = 1.0f * velocity;
-                        currentState = State::Decay;
-                        currentTime = 0.0f;
-                    } else {
-                        currentLevel = applyCurve(attackProgress, attackCurve) * velocity;
-                    }
-                }
-                output = currentLevel;
-                break;
+        int frame = 0;
+        while (frame < numFrames && currentState != State::Idle) {
+            if (currentState == State::Sustain) {
+                currentLevel = sustainLevel * velocity;
+                std::fill(output + frame, output + numFrames, currentLevel);
+                return numFrames;
             }
-                
-            case State::Decay: {
-                float decayMs = decayTime * 1000.0f;
-                currentTime += 1.0f / samplesPerMs;
-                
-                if (decayMs <= 0.0f) {
-                    // Instant decay
-                    currentLevel = sustainLevel * velocity;
-                    currentState = State::Sustain;
-                } else {
-                    // Apply decay curve
-                    float decayProgress = currentTime / decayMs;
-                    if (decayProgress >= 1.0f) {
-                        currentLevel = sustainLevel * velocity;
-                        currentState = State::Sustain;
-                    } else {
-                        float decayCurveValue = applyCurve(decayProgress, decayCurve);
-                        currentLevel = (1.0f - decayCurveValue * (1.0f - sustainLevel)) * velocity;
-                    }
-                }
-                output = currentLevel;
-                break;
+            
+            const Segment& segment = segments[segmentIndex];
+            const int count = std::min(segmentRemaining, numFrames - frame);
+            const float multiplier = segment.multiplier;
+            const float offset = segment.offset;
+            float level = currentLevel;
+            for (int i = 0; i < count; ++i) {
+                level = level * multiplier + offset;
+                output[frame + i] = level;
             }
-                
-            case State::Sustain:
-                currentLevel = sustainLevel * velocity;
-                output = currentLevel;
-                break;
-                
-            case State::Release: {
-                float releaseMs = releaseTime * 1000.0f;
-                currentTime += 1.0f / samplesPerMs;
-                
-                if (releaseMs <= 0.0f) {
-                    // Instant release
-                    currentLevel = 0.0f;
-                    currentState = State::Idle;
-                } else {
-                    // Apply release curve
-                    float releaseProgress = currentTime / releaseMs;
-                    if (releaseProgress >= 1.0f) {
-                        currentLevel = 0.0f;
-                        currentState = State::Idle;
-                    } else {
-                        float releaseCurveValue = applyCurve(releaseProgress, releaseCurve);
-                        currentLevel = releaseLevel * (1.0f - releaseCurveValue);
-                    }
-                }
-                output = currentLevel;
-                break;
+            frame += count;
+            segmentRemaining -= count;
+            currentLevel = level;
+            
+            if (segmentRemaining == 0) {
+                // Land exactly on the curve, so rounding does not accumulate
+                currentLevel = output[frame - 1] = segment.end;
+                nextSegment();
             }
-                
-            case State::Idle:
-            default:
-                currentLevel = 0.0f;
-                output = 0.0f;
-                break;
         }
-        
-        return output;
+        std::fill(output + frame, output + numFrames, 0.0f);
+        return frame;
     }
     
     /**
@@ -241,10 +227,10 @@ public:
     /**
      * Check if the envelope is currently active.
      * 
-     * @return True if the envelope is active, false otherwise
+     * @return True if the envelope is active or a note is waiting to start it, false otherwise
      */
     bool isActive() const {
-        return currentState != State::Idle;
+        return currentState != State::Idle || triggerPending.load();
     }
     
     /**
@@ -257,6 +243,133 @@ public:
     }
     
 private:
+    /**
+     * One recursive piece of a stage.
+     */
+    struct Segment {
+        float multiplier;
+        float offset;
+        float end;  // Level on the last sample
+        int length; // In samples
+    };
+    
+    /**
+     * Enter a stage and precompute its segments from the current level.
+     * 
+     * @param stage The stage to enter
+     */
+    void startStage(State stage) {
+        currentState = stage;
+        switch (stage) {
+            case State::Attack:
+                buildSegments(attackTime, velocity, attackCurve);
+                break;
+            case State::Decay:
+                buildSegments(decayTime, sustainLevel * velocity, decayCurve);
+                break;
+            case State::Release:
+                buildSegments(releaseTime, 0.0f, releaseCurve);
+                break;
+            default:
+                segmentCount = 0;
+                break;
+        }
+    }
+    
+    /**
+     * Move on to the next segment, or the next stage after the last one.
+     */
+    void nextSegment() {
+        if (++segmentIndex < segmentCount) {
+            segmentRemaining = segments[segmentIndex].length;
+            return;
+        }
+        switch (currentState) {
+            case State::Attack:
+                startStage(State::Decay);
+                break;
+            case State::Decay:
+                currentLevel = sustainLevel * velocity;
+                currentState = State::Sustain;
+                break;
+            default:
+                currentLevel = 0.0f;
+                currentState = State::Idle;
+                break;
+        }
+    }
+    
+    /**
+     * Split a stage from the current level to a target into segments.
+     * 
+     * Sample n of an N-sample stage lands on curve(n / N), as the stage
+     * progress was defined when it was tracked per sample. Segment
+     * boundaries are spaced quadratically, shortest first, where the
+     * logarithmic curve bends hardest.
+     * 
+     * @param time The stage length in seconds
+     * @param target The level at the end of the stage
+     * @param curve The curve type of the stage
+     */
+    void buildSegments(float time, float target, CurveType curve) {
+        const float start = currentLevel;
+        const float span = target - start;
+        const int total = std::max(1, static_cast<int>(std::lround(time * static_cast<float>(sampleRate))));
+        const float toProgress = 1.0f / static_cast<float>(total);
+        
+        segmentCount = 0;
+        int boundary = 0;
+        float level = start;
+        for (int i = 1; i <= kSegments; ++i) {
+            float position = static_cast<float>(i) / static_cast<float>(kSegments);
+            int next = (i == kSegments) ? total
+                                        : static_cast<int>(std::lround(position * position * static_cast<float>(total)));
+            if (next <= boundary) {
+                continue;
+            }
+            float middle = start + span * applyCurve(0.5f * static_cast<float>(boundary + next) * toProgress, curve);
+            float end = (next == total) ? target : start + span * applyCurve(static_cast<float>(next) * toProgress, curve);
+            segments[segmentCount++] = fitSegment(level, middle, end, next - boundary);
+            boundary = next;
+            level = end;
+            if (next == total) {
+                break;
+            }
+        }
+        segmentIndex = 0;
+        segmentRemaining = segments[0].length;
+    }
+    
+    /**
+     * Fit a one-pole curve through three points of a segment.
+     * 
+     * A one-pole curve from 0 to 1 with total exponent k is
+     * (e^(k p) - 1) / (e^k - 1), which passes 1 / (1 + e^(k/2)) halfway, so
+     * the midpoint fixes k. Stepping p by 1/length multiplies e^(k p) by
+     * r = e^(k/length), which becomes the multiplier of the recursion.
+     * 
+     * @param from The level before the first sample
+     * @param middle The level halfway through
+     * @param to The level on the last sample
+     * @param length The length in samples
+     */
+    static Segment fitSegment(float from, float middle, float to, int length) {
+        const double span = static_cast<double>(to) - from;
+        Segment segment{1.0f, static_cast<float>(span / length), to, length};
+        if (std::abs(span) < 1e-6) {
+            return segment;
+        }
+        double halfway = std::clamp((static_cast<double>(middle) - from) / span, 1e-4, 1.0 - 1e-4);
+        double k = 2.0 * std::log(1.0 / halfway - 1.0);
+        if (std::abs(k) < 1e-3) {
+            return segment; // Straight enough for a plain ramp
+        }
+        double rMinusOne = std::expm1(k / length);
+        segment.multiplier = static_cast<float>(1.0 + rMinusOne);
+        segment.offset = static_cast<float>(-rMinusOne * from + span * rMinusOne / std::expm1(k));
+        return segment;
+    }
+    
     /**
      * Apply a curve function to a linear progress value.
      * 
@@ -264,7 +377,7 @@ private:
      * @param curve The curve type to apply
      * @return The curved value (0.0 - 1.0)
      */
-    float applyCurve(float value, CurveType curve) {
+    static float applyCurve(float value, CurveType curve) {
         // Ensure value is in [0,1] range
         value = std::clamp(value, 0.0f, 1.0f);
         
@@ -282,7 +395,7 @@ private:
                 
             case CurveType::SCurve:
                 // Smooth S-curve using sine function
-                return (std::sin((value - 0.5f) * M_PI) * 0.5f) + 0.5f;
+                return (fastmath::sin2pi((value - 0.5f) * 0.5f) * 0.5f) + 0.5f;
                 
             default:
                 return value;
@@ -300,9 +413,18 @@ private:
     
     State currentState;
     float currentLevel;
-    float currentTime;
-    float releaseLevel;
     float velocity;
+    
+    // Segments of the current stage
+    Segment segments[kSegments];
+    int segmentCount;
+    int segmentIndex;
+    int segmentRemaining; // Samples left in the current segment
+    
+    // Note events posted for the next block
+    std::atomic<float> pendingVelocity;
+    std::atomic<bool> triggerPending;
+    std::atomic<bool> releasePending;
 };
 
 #endif // ENVELOPE_H
\ No newline at end of file
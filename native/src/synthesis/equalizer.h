@@ -0,0 +1,397 @@
+#ifndef EQUALIZER_H
+#define EQUALIZER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+
+/**
+ * Master-bus parametric equalizer: up to eight biquad bands in series.
+ *
+ * The cascade is processed across channels and bands at once. Band b of
+ * channel c lives in lane 2b + c and, on every sample, filters what band
+ * b - 1 produced on the previous sample. All sixteen lanes are then
+ * independent, so one loop runs the whole cascade for both channels with
+ * SIMD, at the cost of a fixed latency of kLatency samples.
+ *
+ * Band settings are written from the control thread and picked up by
+ * update() once per audio block; coefficients are recomputed only for bands
+ * that changed. A change of band type crossfades from the old filter to the
+ * new one over kFadeSamples, so switching e.g. a peak to a high-pass does
+ * not click.
+ */
+class Equalizer {
+public:
+    static constexpr int kBands = 8;
+    static constexpr int kLanes = kBands * 2;
+    static constexpr int kLatency = kBands - 1; // Samples
+    static constexpr int kFadeSamples = 1024;
+
+    enum class BandType {
+        Off,
+        Peak,
+        LowShelf,
+        HighShelf,
+        LowPass,
+        HighPass
+    };
+
+    /**
+     * Normalized biquad coefficients (a0 = 1).
+     */
+    struct Biquad {
+        float b0;
+        float b1;
+        float b2;
+        float a1;
+        float a2;
+    };
+
+    Equalizer() : sampleRate(44100), fadeRemaining(0) {
+        static const float defaultFrequencies[kBands] = {
+            60.0f, 150.0f, 400.0f, 1000.0f, 2500.0f, 6000.0f, 10000.0f, 16000.0f
+        };
+        for (int b = 0; b < kBands; ++b) {
+            types[b].store(static_cast<int>(BandType::Off));
+            frequencies[b].store(defaultFrequencies[b]);
+            gains[b].store(0.0f);
+            qs[b].store(0.707f);
+            appliedTypes[b] = BandType::Off;
+        }
+        const Biquad passthrough = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+        for (int lane = 0; lane < kLanes; ++lane) {
+            setLane(current, lane, passthrough);
+            setLane(fading, lane, passthrough);
+            fadeWeight[lane] = 1.0f;
+            fadeStep[lane] = 0.0f;
+        }
+        reset();
+        dirtyBands.store(0);
+    }
+
+    /**
+     * Set the sample rate. Call before processing starts.
+     *
+     * @param sr The sample rate
+     */
+    void setSampleRate(int sr) {
+        sampleRate = (sr > 0) ? sr : 44100;
+        dirtyBands.fetch_or((1u << kBands) - 1);
+    }
+
+    /**
+     * Set a band's filter type.
+     *
+     * @param band The band index (0 - kBands-1)
+     * @param type The band type as integer (cast from BandType)
+     */
+    void setBandType(int band, int type) {
+        if (band < 0 || band >= kBands) {
+            return;
+        }
+        types[band].store(std::clamp(type, 0, static_cast<int>(BandType::HighPass)));
+        dirtyBands.fetch_or(1u << band);
+    }
+
+    /**
+     * Set a band's centre or corner frequency.
+     *
+     * @param band The band index
+     * @param frequency The frequency in Hz (20 - 20000)
+     */
+    void setBandFrequency(int band, float frequency) {
+        if (band < 0 || band >= kBands) {
+            return;
+        }
+        frequencies[band].store(std::clamp(frequency, 20.0f, 20000.0f));
+        dirtyBands.fetch_or(1u << band);
+    }
+
+    /**
+     * Set a band's gain (peak and shelf bands).
+     *
+     * @param band The band index
+     * @param gainDb The gain in dB (-24 - +24)
+     */
+    void setBandGain(int band, float gainDb) {
+        if (band < 0 || band >= kBands) {
+            return;
+        }
+        gains[band].store(std::clamp(gainDb, -24.0f, 24.0f));
+        dirtyBands.fetch_or(1u << band);
+    }
+
+    /**
+     * Set a band's Q (bandwidth of peaks, slope of shelves and resonance of
+     * the pass filters).
+     *
+     * @param band The band index
+     * @param q The Q value (0.1 - 18)
+     */
+    void setBandQ(int band, float q) {
+        if (band < 0 || band >= kBands) {
+            return;
+        }
+        qs[band].store(std::clamp(q, 0.1f, 18.0f));
+        dirtyBands.fetch_or(1u << band);
+    }
+
+    /**
+     * Apply changed band settings. Call from the audio thread once per block.
+     */
+    void update() {
+        uint32_t dirty = dirtyBands.exchange(0);
+        for (int b = 0; b < kBands && dirty != 0; ++b) {
+            if (!(dirty & (1u << b))) {
+                continue;
+            }
+            BandType type = static_cast<BandType>(types[b].load());
+            Biquad coefficients = computeBand(type, frequencies[b].load(), gains[b].load(),
+                                              qs[b].load(), sampleRate);
+            if (type != appliedTypes[b]) {
+                startFade(b);
+                appliedTypes[b] = type;
+            }
+            setLane(current, 2 * b, coefficients);
+            setLane(current, 2 * b + 1, coefficients);
+        }
+        flushDenormals();
+    }
+
+    /**
+     * Process one stereo sample (delayed by kLatency samples).
+     *
+     * @param left The left sample, replaced by the equalized output
+     * @param right The right sample, replaced by the equalized output
+     */
+    void processStereo(float& left, float& right) {
+        // Each band takes the previous band's output from the last sample
+        alignas(32) float input[kLanes];
+        input[0] = left;
+        input[1] = right;
+        for (int lane = 2; lane < kLanes; ++lane) {
+            input[lane] = output[lane - 2];
+        }
+
+        for (int lane = 0; lane < kLanes; ++lane) {
+            output[lane] = tick(current, currentState, lane, input[lane]);
+        }
+
+        if (fadeRemaining > 0) {
+            for (int lane = 0; lane < kLanes; ++lane) {
+                const float old = tick(fading, fadingState, lane, input[lane]);
+                output[lane] = old + (output[lane] - old) * fadeWeight[lane];
+                fadeWeight[lane] = std::min(fadeWeight[lane] + fadeStep[lane], 1.0f);
+            }
+            --fadeRemaining;
+        }
+
+        left = output[kLanes - 2];
+        right = output[kLanes - 1];
+    }
+
+    /**
+     * Reset all filter state.
+     */
+    void reset() {
+        std::fill(currentState.z1, currentState.z1 + kLanes, 0.0f);
+        std::fill(currentState.z2, currentState.z2 + kLanes, 0.0f);
+        std::fill(fadingState.z1, fadingState.z1 + kLanes, 0.0f);
+        std::fill(fadingState.z2, fadingState.z2 + kLanes, 0.0f);
+        std::fill(output, output + kLanes, 0.0f);
+    }
+
+    /**
+     * Magnitude response of the current settings, for drawing the EQ curve.
+     *
+     * Evaluated from the band settings rather than the audio-thread state,
+     * so it may be called from any thread.
+     *
+     * @param magnitudesDb Receives numPoints magnitudes in dB
+     * @param numPoints The number of points, spaced logarithmically
+     * @param minFrequency The frequency of the first point in Hz
+     * @param maxFrequency The frequency of the last point in Hz
+     */
+    void getMagnitudeResponse(float* magnitudesDb, int numPoints, float minFrequency, float maxFrequency) const {
+        if (!magnitudesDb || numPoints <= 0) {
+            return;
+        }
+        Biquad bands[kBands];
+        for (int b = 0; b < kBands; ++b) {
+            bands[b] = computeBand(static_cast<BandType>(types[b].load()), frequencies[b].load(),
+                                   gains[b].load(), qs[b].load(), sampleRate);
+        }
+        minFrequency = std::max(minFrequency, 1.0f);
+        maxFrequency = std::max(maxFrequency, minFrequency);
+        const double ratio = (numPoints > 1) ? std::log(maxFrequency / minFrequency) / (numPoints - 1) : 0.0;
+        for (int i = 0; i < numPoints; ++i) {
+            double frequency = minFrequency * std::exp(ratio * i);
+            double w = 2.0 * 3.14159265358979323846 * std::min(frequency, 0.5 * sampleRate) / sampleRate;
+            std::complex<double> z1 = std::polar(1.0, -w);
+            std::complex<double> z2 = z1 * z1;
+            double magnitude = 1.0;
+            for (const Biquad& c : bands) {
+                std::complex<double> numerator = static_cast<double>(c.b0) + static_cast<double>(c.b1) * z1
+                                               + static_cast<double>(c.b2) * z2;
+                std::complex<double> denominator = 1.0 + static_cast<double>(c.a1) * z1
+                                                 + static_cast<double>(c.a2) * z2;
+                magnitude *= std::abs(numerator) / std::max(std::abs(denominator), 1e-12);
+            }
+            magnitudesDb[i] = static_cast<float>(20.0 * std::log10(std::max(magnitude, 1e-6)));
+        }
+    }
+
+    /**
+     * Compute a band's coefficients (RBJ audio EQ cookbook).
+     *
+     * @param type The band type
+     * @param frequency The frequency in Hz
+     * @param gainDb The gain in dB (peak and shelf bands)
+     * @param q The Q value
+     * @param sampleRate The sample rate
+     * @return The normalized coefficients; Off is a passthrough
+     */
+    static Biquad computeBand(BandType type, float frequency, float gainDb, float q, int sampleRate) {
+        if (type == BandType::Off) {
+            return {1.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+        }
+        const double w0 = 2.0 * 3.14159265358979323846 * std::min(frequency, 0.49f * sampleRate) / sampleRate;
+        const double cosW = std::cos(w0);
+        const double alpha = std::sin(w0) / (2.0 * std::max(q, 0.1f));
+        const double A = std::pow(10.0, gainDb / 40.0);
+        const double rootA = std::sqrt(A);
+        double b0, b1, b2, a0, a1, a2;
+        switch (type) {
+            case BandType::Peak:
+                b0 = 1.0 + alpha * A;
+                b1 = -2.0 * cosW;
+                b2 = 1.0 - alpha * A;
+                a0 = 1.0 + alpha / A;
+                a1 = -2.0 * cosW;
+                a2 = 1.0 - alpha / A;
+                break;
+            case BandType::LowShelf:
+                b0 = A * ((A + 1.0) - (A - 1.0) * cosW + 2.0 * rootA * alpha);
+                b1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cosW);
+                b2 = A * ((A + 1.0) - (A - 1.0) * cosW - 2.0 * rootA * alpha);
+                a0 = (A + 1.0) + (A - 1.0) * cosW + 2.0 * rootA * alpha;
+                a1 = -2.0 * ((A - 1.0) + (A + 1.0) * cosW);
+                a2 = (A + 1.0) + (A - 1.0) * cosW - 2.0 * rootA * alpha;
+                break;
+            case BandType::HighShelf:
+                b0 = A * ((A + 1.0) + (A - 1.0) * cosW + 2.0 * rootA * alpha);
+                b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cosW);
+                b2 = A * ((A + 1.0) + (A - 1.0) * cosW - 2.0 * rootA * alpha);
+                a0 = (A + 1.0) - (A - 1.0) * cosW + 2.0 * rootA * alpha;
+                a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cosW);
+                a2 = (A + 1.0) - (A - 1.0) * cosW - 2.0 * rootA * alpha;
+                break;
+            case BandType::LowPass:
+                b0 = 0.5 * (1.0 - cosW);
+                b1 = 1.0 - cosW;
+                b2 = 0.5 * (1.0 - cosW);
+                a0 = 1.0 + alpha;
+                a1 = -2.0 * cosW;
+                a2 = 1.0 - alpha;
+                break;
+            case BandType::HighPass:
+            default:
+                b0 = 0.5 * (1.0 + cosW);
+                b1 = -(1.0 + cosW);
+                b2 = 0.5 * (1.0 + cosW);
+                a0 = 1.0 + alpha;
+                a1 = -2.0 * cosW;
+                a2 = 1.0 - alpha;
+                break;
+        }
+        return {static_cast<float>(b0 / a0), static_cast<float>(b1 / a0), static_cast<float>(b2 / a0),
+                static_cast<float>(a1 / a0), static_cast<float>(a2 / a0)};
+    }
+
+private:
+    /**
+     * Per-lane coefficients, structure-of-arrays.
+     */
+    struct LaneCoefficients {
+        alignas(32) float b0[kLanes];
+        alignas(32) float b1[kLanes];
+        alignas(32) float b2[kLanes];
+        alignas(32) float a1[kLanes];
+        alignas(32) float a2[kLanes];
+    };
+
+    /**
+     * Per-lane transposed direct form II state.
+     */
+    struct LaneState {
+        alignas(32) float z1[kLanes];
+        alignas(32) float z2[kLanes];
+    };
+
+    static void setLane(LaneCoefficients& c, int lane, const Biquad& biquad) {
+        c.b0[lane] = biquad.b0;
+        c.b1[lane] = biquad.b1;
+        c.b2[lane] = biquad.b2;
+        c.a1[lane] = biquad.a1;
+        c.a2[lane] = biquad.a2;
+    }
+
+    static inline float tick(const LaneCoefficients& c, LaneState& s, int lane, float x) {
+        const float y = c.b0[lane] * x + s.z1[lane];
+        s.z1[lane] = c.b1[lane] * x - c.a1[lane] * y + s.z2[lane];
+        s.z2[lane] = c.b2[lane] * x - c.a2[lane] * y;
+        return y;
+    }
+
+    /**
+     * Move a band's running filter to the fading set and start the new one
+     * from silence, ramping between them over kFadeSamples.
+     */
+    void startFade(int band) {
+        for (int lane = 2 * band; lane < 2 * band + 2; ++lane) {
+            fading.b0[lane] = current.b0[lane];
+            fading.b1[lane] = current.b1[lane];
+            fading.b2[lane] = current.b2[lane];
+            fading.a1[lane] = current.a1[lane];
+            fading.a2[lane] = current.a2[lane];
+            fadingState.z1[lane] = currentState.z1[lane];
+            fadingState.z2[lane] = currentState.z2[lane];
+            currentState.z1[lane] = 0.0f;
+            currentState.z2[lane] = 0.0f;
+            fadeWeight[lane] = 0.0f;
+            fadeStep[lane] = 1.0f / kFadeSamples;
+        }
+        fadeRemaining = kFadeSamples;
+    }
+
+    void flushDenormals() {
+        for (int lane = 0; lane < kLanes; ++lane) {
+            currentState.z1[lane] = (std::abs(currentState.z1[lane]) < 1e-15f) ? 0.0f : currentState.z1[lane];
+            currentState.z2[lane] = (std::abs(currentState.z2[lane]) < 1e-15f) ? 0.0f : currentState.z2[lane];
+        }
+    }
+
+    int sampleRate;
+
+    // Band settings, written by the control thread
+    std::atomic<int> types[kBands];
+    std::atomic<float> frequencies[kBands];
+    std::atomic<float> gains[kBands];
+    std::atomic<float> qs[kBands];
+    std::atomic<uint32_t> dirtyBands;
+
+    // Audio thread
+    BandType appliedTypes[kBands];
+    LaneCoefficients current;
+    LaneCoefficients fading;
+    LaneState currentState;
+    LaneState fadingState;
+    alignas(32) float fadeWeight[kLanes];
+    alignas(32) float fadeStep[kLanes];
+    alignas(32) float output[kLanes];
+    int fadeRemaining;
+};
+
+#endif // EQUALIZER_H
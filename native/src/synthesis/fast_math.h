@@ -0,0 +1,212 @@
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * Fast approximations of the transcendental functions used on the audio path.
+ *
+ * Every approximation is available in three accuracy tiers. Call sites can pick
+ * a tier explicitly (fastmath::sin2pi<fastmath::Precision::High>(x)) or use the
+ * project-wide default, which is set with SYNTH_FAST_MATH_PRECISION
+ * (0 = Low, 1 = Medium, 2 = High). All functions are branch-light and inline so
+ * that loops calling them can be auto-vectorized.
+ *
+ * Approximate maximum errors (see test_fast_math.cpp):
+ *   sin2pi / cos2pi   Low 8e-5,   Medium 1e-6,   High 4e-7 (float limited)
+ *   exp2 (relative)   Low 1e-4,   Medium 4e-6,   High 7e-7
+ *   tanh              Low 2.4e-2, Medium 2e-6,   High 2e-7
+ *
+ * exp2 is exact at whole powers, so centsToRatio(0) == 1 and tanh(0) == 0.
+ */
+namespace fastmath {
+
+enum class Precision {
+    Low,
+    Medium,
+    High
+};
+
+#ifndef SYNTH_FAST_MATH_PRECISION
+#define SYNTH_FAST_MATH_PRECISION 1
+#endif
+
+constexpr Precision kDefaultPrecision =
+    (SYNTH_FAST_MATH_PRECISION <= 0) ? Precision::Low :
+    (SYNTH_FAST_MATH_PRECISION == 1) ? Precision::Medium : Precision::High;
+
+constexpr float kPi = 3.14159265358979323846f;
+constexpr float kTwoPi = 6.28318530717958647692f;
+constexpr float kLog2e = 1.44269504088896340736f;
+
+/**
+ * Sine of a phase expressed in cycles: sin(2 * pi * phase).
+ *
+ * @param phase Phase in cycles (any finite value)
+ * @return The approximated sine
+ */
+template <Precision P = kDefaultPrecision>
+inline float sin2pi(float phase) {
+    // Reduce to [-0.5, 0.5] and fold into [-0.25, 0.25] where the odd
+    // polynomial is fitted.
+    float x = phase - std::floor(phase + 0.5f);
+    float folded = (x > 0.25f) ? 0.5f - x : x;
+    x = (folded < -0.25f) ? -0.5f - folded : folded;
+    float x2 = x * x;
+
+    if (P == Precision::Low) {
+        return x * (6.281520159e+00f + x2 * (-4.110841314e+01f + x2 * 7.374175050e+01f));
+    } else if (P == Precision::Medium) {
+        return x * (6.283167563e+00f + x2 * (-4.133751763e+01f
+                 + x2 * (8.135167794e+01f + x2 * -7.108735993e+01f)));
+    } else {
+        return x * (6.283185189e+00f + x2 * (-4.134166012e+01f
+                 + x2 * (8.160126725e+01f + x2 * (-7.655501996e+01f + x2 * 3.957217464e+01f))));
+    }
+}
+
+/**
+ * Cosine of a phase expressed in cycles: cos(2 * pi * phase).
+ */
+template <Precision P = kDefaultPrecision>
+inline float cos2pi(float phase) {
+    // Reduce before shifting by a quarter cycle to keep the float rounding of
+    // the shifted phase small.
+    float x = phase - std::floor(phase + 0.5f);
+    return sin2pi<P>(0.25f - std::abs(x));
+}
+
+/**
+ * Sine of an angle in radians.
+ */
+template <Precision P = kDefaultPrecision>
+inline float sin(float radians) {
+    return sin2pi<P>(radians * (1.0f / kTwoPi));
+}
+
+/**
+ * Cosine of an angle in radians.
+ */
+template <Precision P = kDefaultPrecision>
+inline float cos(float radians) {
+    return cos2pi<P>(radians * (1.0f / kTwoPi));
+}
+
+/**
+ * Base-2 exponential.
+ *
+ * @param x The exponent, clamped to [-126, 127]
+ * @return 2^x
+ */
+template <Precision P = kDefaultPrecision>
+inline float exp2(float x) {
+    x = (x < -126.0f) ? -126.0f : ((x > 127.0f) ? 127.0f : x);
+    float whole = std::floor(x);
+    float f = x - whole;
+
+    float poly;
+    if (P == Precision::Low) {
+        poly = 1.0f + f * (6.954243475e-01f + f * (2.263076823e-01f + f * 7.826797019e-02f));
+    } else if (P == Precision::Medium) {
+        poly = 1.0f + f * (6.930321208e-01f + f * (2.413797630e-01f
+             + f * (5.203236897e-02f + f * 1.355574726e-02f)));
+    } else {
+        poly = 1.000000003e+00f + f * (6.931469285e-01f + f * (2.402305040e-01f
+             + f * (5.548041830e-02f + f * (9.684595490e-03f + f * (1.238769088e-03f
+             + f * 2.187793180e-04f)))));
+    }
+
+    // Scale by 2^whole by building the exponent bits directly.
+    int32_t bits = (static_cast<int32_t>(whole) + 127) << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return poly * scale;
+}
+
+/**
+ * Natural exponential, via exp2.
+ */
+template <Precision P = kDefaultPrecision>
+inline float exp(float x) {
+    return exp2<P>(x * kLog2e);
+}
+
+/**
+ * Hyperbolic tangent, saturating to +/-1.
+ */
+template <Precision P = kDefaultPrecision>
+inline float tanh(float x) {
+    if (P == Precision::Low) {
+        // Rational approximation, exact at +/-3 where it meets the clamp
+        x = (x < -3.0f) ? -3.0f : ((x > 3.0f) ? 3.0f : x);
+        float x2 = x * x;
+        return x * (27.0f + x2) / (27.0f + 9.0f * x2);
+    } else {
+        x = (x < -9.0f) ? -9.0f : ((x > 9.0f) ? 9.0f : x);
+        float e = exp2<P>(2.0f * kLog2e * x);
+        return (e - 1.0f) / (e + 1.0f);
+    }
+}
+
+/**
+ * Frequency ratio for a detune in cents: 2^(cents / 1200).
+ */
+template <Precision P = kDefaultPrecision>
+inline float centsToRatio(float cents) {
+    return exp2<P>(cents * (1.0f / 1200.0f));
+}
+
+/**
+ * Frequency ratio for a transposition in semitones: 2^(semitones / 12).
+ */
+template <Precision P = kDefaultPrecision>
+inline float semitonesToRatio(float semitones) {
+    return exp2<P>(semitones * (1.0f / 12.0f));
+}
+
+/**
+ * Table-based sine for call sites that prefer a memory lookup to a polynomial
+ * (e.g. phase-indexed shapers). Linear interpolation over kSineTableSize
+ * points gives a maximum error of about 5e-6.
+ */
+constexpr int kSineTableSize = 1024;
+
+inline const float* sineTable() {
+    struct Table {
+        float values[kSineTableSize + 1];
+        Table() {
+            for (int i = 0; i <= kSineTableSize; ++i) {
+                values[i] = static_cast<float>(std::sin(2.0 * 3.14159265358979323846 * i / kSineTableSize));
+            }
+        }
+    };
+    static const Table table;
+    return table.values;
+}
+
+/**
+ * Table-based sin(2 * pi * phase).
+ *
+ * @param phase Phase in cycles (any finite value)
+ */
+inline float sin2piLookup(float phase) {
+    const float* table = sineTable();
+    float position = (phase - std::floor(phase)) * static_cast<float>(kSineTableSize);
+    int index = static_cast<int>(position);
+    index = (index >= kSineTableSize) ? kSineTableSize - 1 : index;
+    float fraction = position - static_cast<float>(index);
+    return table[index] + fraction * (table[index + 1] - table[index]);
+}
+
+/**
+ * Table-based cos(2 * pi * phase).
+ */
+inline float cos2piLookup(float phase) {
+    return sin2piLookup(phase + 0.25f);
+}
+
+} // namespace fastmath
+
+#endif // FAST_MATH_H
@@ -3,12 +3,34 @@
 
 #include <cmath>
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+#include "fast_math.h"
+
+class FilterCoefficientTable;
 
 /**
- * A multi-mode filter class implementing a state-variable filter.
+ * A multi-mode filter class offering three filter models.
+ * 
+ * - Chamberlin state-variable filter (LowPass ... HighShelf): the cheapest,
+ *   but only stable below about a sixth of the sample rate, so resonance
+ *   is limited to 0.99.
+ * - Zero-delay-feedback (topology-preserving transform) state-variable
+ *   filter (TptLowPass ... TptNotch): stable at any cutoff and resonance.
+ * - 4-pole ladder lowpass (Ladder, LadderNonlinear), solved with zero-delay
+ *   feedback. The linear version is cheap enough for high voice counts;
+ *   the nonlinear one saturates the ladder input with tanh, which drives
+ *   and limits the resonance.
  * 
- * This filter provides low-pass, high-pass, band-pass, and notch filtering
- * using a state-variable filter architecture.
+ * The per-sample steps are static so that FilterBank can run the same
+ * code across many voices. Coefficients come from a FilterCoefficientTable
+ * shared by every filter at the same sample rate, so cutoff and resonance
+ * can be modulated at audio rate without evaluating sin/tan/sqrt.
  */
 class Filter {
 public:
@@ -18,12 +40,96 @@ public:
         BandPass,
         Notch,
         LowShelf,
-        HighShelf
+        HighShelf,
+        TptLowPass,
+        TptHighPass,
+        TptBandPass,
+        TptNotch,
+        Ladder,
+        LadderNonlinear
     };
     
+    /**
+     * Filter families; switching between them resets the filter state.
+     */
+    enum class Model {
+        Chamberlin,
+        Tpt,
+        Ladder
+    };
+    
+    /**
+     * Filter coefficients for every model, shared with FilterBank.
+     * 
+     * The primary fields are smooth functions of cutoff and resonance and
+     * are interpolated linearly between two settings; the derived fields
+     * are then recomputed from them, which keeps the zero-delay-feedback
+     * solutions exact (and so stable) for any interpolated setting.
+     */
+    struct Coefficients {
+        // Chamberlin state-variable filter
+        float f;     // Frequency coefficient
+        float q;     // Resonance coefficient
+        float scale; // Input scale factor
+        
+        // TPT state-variable filter
+        float g;     // Prewarped integrator gain tan(pi fc / fs)
+        float k;     // Damping (2 = no resonance, 0 = self-oscillation)
+        float a1;    // Derived: 1 / (1 + g (g + k))
+        float a2;    // Derived: g a1
+        float a3;    // Derived: g a2
+        
+        // Ladder
+        float ladderG;        // One-pole gain g / (1 + g)
+        float ladderK;        // Feedback (0 - 4)
+        float ladderDrive;    // Input gain compensating the resonance loss
+        float ladderFeedback; // Derived: 1 / (1 + k G^4), solves the feedback loop
+        
+        /**
+         * Recompute the derived fields from the primary ones.
+         */
+        void derive() {
+            a1 = 1.0f / (1.0f + g * (g + k));
+            a2 = g * a1;
+            a3 = g * a2;
+            float G2 = ladderG * ladderG;
+            ladderFeedback = 1.0f / (1.0f + ladderK * G2 * G2);
+        }
+        
+        /**
+         * @return a + (b - a) * t for the primary fields; the derived
+         *         fields are left unset (see lerp)
+         */
+        static Coefficients blend(const Coefficients& a, const Coefficients& b, float t) {
+            Coefficients c;
+            c.f = a.f + (b.f - a.f) * t;
+            c.q = a.q + (b.q - a.q) * t;
+            c.scale = a.scale + (b.scale - a.scale) * t;
+            c.g = a.g + (b.g - a.g) * t;
+            c.k = a.k + (b.k - a.k) * t;
+            c.ladderG = a.ladderG + (b.ladderG - a.ladderG) * t;
+            c.ladderK = a.ladderK + (b.ladderK - a.ladderK) * t;
+            c.ladderDrive = a.ladderDrive + (b.ladderDrive - a.ladderDrive) * t;
+            return c;
+        }
+        
+        /**
+         * @return The primary fields interpolated, with derived fields to match
+         */
+        static Coefficients lerp(const Coefficients& a, const Coefficients& b, float t) {
+            Coefficients c = blend(a, b, t);
+            c.derive();
+            return c;
+        }
+    };
+    
+    static constexpr int kTypeCount = static_cast<int>(FilterType::LadderNonlinear) + 1;
+    static constexpr int kStateSize = 4;
+    
     Filter() : sampleRate(44100), cutoff(1000.0f), resonance(0.5f),
-               type(FilterType::LowPass), lowpass(0.0f), highpass(0.0f),
-               bandpass(0.0f), notch(0.0f), peak(0.0f), gain(1.0f) {
+               type(FilterType::LowPass), gain(1.0f) {
+        reset();
+        updateTable();
         calculateCoefficients();
     }
     
@@ -36,34 +142,35 @@ public:
      * @return The filtered output sample
      */
     float process(float input) {
-        // State variable filter algorithm
-        
-        // Calculation of state-variable filter components
-        lowpass = lowpass + f * bandpass;
-        highpass = scale * input - lowpass - q * bandpass;
-        bandpass = bandpass + f * highpass;
-        notch = highpass + lowpass;
-        peak = lowpass - highpass;
-        
-        // Select output based on filter type
-        switch (type) {
-            case FilterType::LowPass:
-                return lowpass;
-            case FilterType::HighPass:
-                return highpass;
-            case FilterType::BandPass:
-                return bandpass;
-            case FilterType::Notch:
-                return notch;
-            case FilterType::LowShelf:
-                return input + (lowpass - input) * gain;
-            case FilterType::HighShelf:
-                return input + (highpass - input) * gain;
-            default:
-                return lowpass;
-        }
+        return tick(input, state);
+    }
+    
+    /**
+     * Process one stereo sample through the filter.
+     * 
+     * Both channels share the coefficients but keep separate state.
+     * 
+     * @param left The left input sample, replaced by the filtered output
+     * @param right The right input sample, replaced by the filtered output
+     */
+    void processStereo(float& left, float& right) {
+        left = tick(left, state);
+        right = tick(right, stateRight);
     }
     
+    /**
+     * Process a block of mono samples with a cutoff for every sample.
+     * 
+     * Coefficients are looked up per sample in the shared coefficient
+     * table, at the current resonance; the type is resolved once per block.
+     * The stored cutoff is left unchanged.
+     * 
+     * @param samples The samples to filter in place
+     * @param cutoffs The cutoff frequency in Hz for each sample
+     * @param numFrames The number of samples
+     */
+    void processModulated(float* samples, const float* cutoffs, int numFrames);
+    
     /**
      * Set the sample rate.
      * 
@@ -71,6 +178,7 @@ public:
      */
     void setSampleRate(int sr) {
         sampleRate = sr;
+        updateTable();
         calculateCoefficients();
     }
     
@@ -100,7 +208,11 @@ public:
      * @param t The filter type as integer (cast from FilterType enum)
      */
     void setType(int t) {
-        type = static_cast<FilterType>(t);
+        FilterType newType = static_cast<FilterType>(std::clamp(t, 0, kTypeCount - 1));
+        if (modelOf(newType) != modelOf(type)) {
+            reset();
+        }
+        type = newType;
     }
     
     /**
@@ -116,7 +228,8 @@ public:
      * Reset the filter state.
      */
     void reset() {
-        lowpass = highpass = bandpass = notch = peak = 0.0f;
+        std::fill(state, state + kStateSize, 0.0f);
+        std::fill(stateRight, stateRight + kStateSize, 0.0f);
     }
     
     /**
@@ -155,11 +268,159 @@ public:
         return gain;
     }
     
-private:
     /**
-     * Calculate filter coefficients based on current settings.
+     * Get the coefficients for the current cutoff, resonance and sample rate.
+     * 
+     * @return The coefficients of every filter model
+     */
+    const Coefficients& getCoefficients() const {
+        return coefficients;
+    }
+    
+    /**
+     * Get the coefficient table for the current sample rate.
+     * 
+     * @return The shared table (valid while this filter keeps its sample rate)
+     */
+    const FilterCoefficientTable* getCoefficientTable() const {
+        return table.get();
+    }
+    
+    /**
+     * Call visitor with the filter type as a compile-time constant
+     * (std::integral_constant<FilterType, T>), so a block loop can be
+     * instantiated per type and selected once rather than per sample.
+     * 
+     * @param t The filter type
+     * @param visitor A generic callable
      */
-    void calculateCoefficients() {
+    template <typename Visitor>
+    static void dispatch(FilterType t, Visitor&& visitor) {
+        switch (t) {
+            case FilterType::LowPass:         visitor(std::integral_constant<FilterType, FilterType::LowPass>()); break;
+            case FilterType::HighPass:        visitor(std::integral_constant<FilterType, FilterType::HighPass>()); break;
+            case FilterType::BandPass:        visitor(std::integral_constant<FilterType, FilterType::BandPass>()); break;
+            case FilterType::Notch:           visitor(std::integral_constant<FilterType, FilterType::Notch>()); break;
+            case FilterType::LowShelf:        visitor(std::integral_constant<FilterType, FilterType::LowShelf>()); break;
+            case FilterType::HighShelf:       visitor(std::integral_constant<FilterType, FilterType::HighShelf>()); break;
+            case FilterType::TptLowPass:      visitor(std::integral_constant<FilterType, FilterType::TptLowPass>()); break;
+            case FilterType::TptHighPass:     visitor(std::integral_constant<FilterType, FilterType::TptHighPass>()); break;
+            case FilterType::TptBandPass:     visitor(std::integral_constant<FilterType, FilterType::TptBandPass>()); break;
+            case FilterType::TptNotch:        visitor(std::integral_constant<FilterType, FilterType::TptNotch>()); break;
+            case FilterType::Ladder:          visitor(std::integral_constant<FilterType, FilterType::Ladder>()); break;
+            case FilterType::LadderNonlinear: visitor(std::integral_constant<FilterType, FilterType::LadderNonlinear>()); break;
+            default:                          visitor(std::integral_constant<FilterType, FilterType::LowPass>()); break;
+        }
+    }
+    
+    /**
+     * Get the model a filter type belongs to.
+     * 
+     * @param t The filter type
+     * @return The filter model
+     */
+    static Model modelOf(FilterType t) {
+        if (t >= FilterType::Ladder) {
+            return Model::Ladder;
+        }
+        return (t >= FilterType::TptLowPass) ? Model::Tpt : Model::Chamberlin;
+    }
+    
+    /**
+     * Run one filter step for a type chosen at compile time.
+     * 
+     * Branch-free apart from the compile-time selection, so a loop over
+     * independent states vectorizes.
+     * 
+     * @param input The input sample
+     * @param s0 ... s3 The channel's filter state (the SVFs use s0 and s1)
+     * @param c The coefficients
+     * @param g The shelf gain
+     * @return The filtered sample
+     */
+    template <FilterType Type>
+    static inline float step(float input, float& s0, float& s1, float& s2, float& s3,
+                             const Coefficients& c, float g) {
+        if constexpr (Type >= FilterType::Ladder) {
+            // Zero-delay-feedback solution of the 4-pole loop:
+            // y4 = G^4 u + S, with S the contribution of the stage states
+            const float G = c.ladderG;
+            const float beta = 1.0f - G;
+            const float S = beta * (G * (G * (G * s0 + s1) + s2) + s3);
+            float u = (input * c.ladderDrive - c.ladderK * S) * c.ladderFeedback;
+            if constexpr (Type == FilterType::LadderNonlinear) {
+                // Rational tanh approximation: it reaches +/-1 at +/-3 and stays at or
+                // beyond it, so clamping the result (rather than the argument, as
+                // fastmath::tanh does) saturates identically and keeps the loop vectorizable
+                const float u2 = u * u;
+                u = u * (27.0f + u2) / (27.0f + 9.0f * u2);
+                u = std::min(std::max(u, -1.0f), 1.0f);
+            }
+            float v = (u - s0) * G;
+            const float y1 = v + s0;
+            s0 = y1 + v;
+            v = (y1 - s1) * G;
+            const float y2 = v + s1;
+            s1 = y2 + v;
+            v = (y2 - s2) * G;
+            const float y3 = v + s2;
+            s2 = y3 + v;
+            v = (y3 - s3) * G;
+            const float y4 = v + s3;
+            s3 = y4 + v;
+            return y4;
+        } else if constexpr (Type >= FilterType::TptLowPass) {
+            // Trapezoidal integrators, s0/s1 hold the integrator states
+            const float v3 = input - s1;
+            const float v1 = c.a1 * s0 + c.a2 * v3;
+            const float v2 = s1 + c.a2 * s0 + c.a3 * v3;
+            s0 = 2.0f * v1 - s0;
+            s1 = 2.0f * v2 - s1;
+            const float high = input - c.k * v1 - v2;
+            if constexpr (Type == FilterType::TptHighPass) {
+                return high;
+            } else if constexpr (Type == FilterType::TptBandPass) {
+                return v1;
+            } else if constexpr (Type == FilterType::TptNotch) {
+                return high + v2;
+            } else {
+                return v2;
+            }
+        } else {
+            // Chamberlin state-variable filter, s0 = lowpass, s1 = bandpass
+            const float lp = s0 + c.f * s1;
+            const float hp = c.scale * input - lp - c.q * s1;
+            const float bp = s1 + c.f * hp;
+            s0 = lp;
+            s1 = bp;
+            if constexpr (Type == FilterType::HighPass) {
+                return hp;
+            } else if constexpr (Type == FilterType::BandPass) {
+                return bp;
+            } else if constexpr (Type == FilterType::Notch) {
+                return hp + lp;
+            } else if constexpr (Type == FilterType::LowShelf) {
+                return input + (lp - input) * g;
+            } else if constexpr (Type == FilterType::HighShelf) {
+                return input + (hp - input) * g;
+            } else {
+                return lp;
+            }
+        }
+    }
+    
+    /**
+     * Compute the coefficients of every model exactly (used to build the
+     * coefficient tables).
+     * 
+     * @param cutoff The cutoff frequency in Hz
+     * @param resonance The resonance (0.0 - 1.0)
+     * @param sampleRate The sample rate
+     * @return The coefficients
+     */
+    static Coefficients computeCoefficients(float cutoff, float resonance, int sampleRate) {
+        Coefficients c;
+        
         // Limit cutoff frequency to Nyquist
         float nyquist = sampleRate * 0.5f;
         float safeFreq = std::min(cutoff, nyquist - 1.0f);
@@ -169,33 +430,210 @@ private:
         
         // State variable filter coefficient calculations
         // f = 2.0f * sin(M_PI * normalizedFreq);
-        f = 2.0f * std::sin(M_PI * normalizedFreq);
+        c.f = 2.0f * fastmath::sin2pi(0.5f * normalizedFreq);
         
         // Resonance (q) calculation with safety limit
         float safeResonance = std::min(resonance, 0.99f);
-        q = 1.0f - safeResonance;
+        c.q = 1.0f - safeResonance;
         
         // Scale to normalize volume changes with high resonance
-        scale = 1.0f / (1.0f + std::sqrt(q));
+        c.scale = 1.0f / (1.0f + std::sqrt(c.q));
+        
+        // Prewarped integrator gain, kept just below Nyquist
+        c.g = std::tan(fastmath::kPi * 0.5f * std::min(normalizedFreq, 0.98f));
+        
+        // TPT SVF: the full resonance range is stable
+        c.k = 2.0f - 1.99f * resonance;
+        
+        // Ladder: k = 4 is the self-oscillation threshold of the linear ladder
+        c.ladderG = c.g / (1.0f + c.g);
+        c.ladderK = 3.98f * resonance;
+        c.ladderDrive = 1.0f + 0.5f * c.ladderK;
+        
+        c.derive();
+        return c;
+    }
+
+private:
+    /**
+     * Run one filter step on the given channel state.
+     * 
+     * @param input The input sample
+     * @param s The channel's filter state
+     * @return The output for the selected filter type
+     */
+    float tick(float input, float* s) const {
+        const Coefficients& c = coefficients;
+        switch (type) {
+            case FilterType::LowPass:         return step<FilterType::LowPass>(input, s[0], s[1], s[2], s[3], c, gain);
+            case FilterType::HighPass:        return step<FilterType::HighPass>(input, s[0], s[1], s[2], s[3], c, gain);
+            case FilterType::BandPass:        return step<FilterType::BandPass>(input, s[0], s[1], s[2], s[3], c, gain);
+            case FilterType::Notch:           return step<FilterType::Notch>(input, s[0], s[1], s[2], s[3], c, gain);
+            case FilterType::LowShelf:        return step<FilterType::LowShelf>(input, s[0], s[1], s[2], s[3], c, gain);
+            case FilterType::HighShelf:       return step<FilterType::HighShelf>(input, s[0], s[1], s[2], s[3], c, gain);
+            case FilterType::TptLowPass:      return step<FilterType::TptLowPass>(input, s[0], s[1], s[2], s[3], c, gain);
+            case FilterType::TptHighPass:     return step<FilterType::TptHighPass>(input, s[0], s[1], s[2], s[3], c, gain);
+            case FilterType::TptBandPass:     return step<FilterType::TptBandPass>(input, s[0], s[1], s[2], s[3], c, gain);
+            case FilterType::TptNotch:        return step<FilterType::TptNotch>(input, s[0], s[1], s[2], s[3], c, gain);
+            case FilterType::Ladder:          return step<FilterType::Ladder>(input, s[0], s[1], s[2], s[3], c, gain);
+            case FilterType::LadderNonlinear: return step<FilterType::LadderNonlinear>(input, s[0], s[1], s[2], s[3], c, gain);
+            default:                          return step<FilterType::LowPass>(input, s[0], s[1], s[2], s[3], c, gain);
+        }
     }
     
+    /**
+     * Fetch the shared coefficient table for the current sample rate.
+     */
+    void updateTable();
+    
+    /**
+     * Calculate filter coefficients based on current settings.
+     */
+    void calculateCoefficients();
+    
     int sampleRate;
     float cutoff;
     float resonance;
     FilterType type;
     float gain;
     
-    // Filter state variables
-    float lowpass;
-    float highpass;
-    float bandpass;
-    float notch;
-    float peak;
+    // Filter state (left / mono channel, right channel)
+    float state[kStateSize];
+    float stateRight[kStateSize];
     
     // Filter coefficients
-    float f;  // Frequency coefficient
-    float q;  // Resonance coefficient
-    float scale; // Scale factor
+    Coefficients coefficients;
+    std::shared_ptr<const FilterCoefficientTable> table;
+};
+
+/**
+ * Filter coefficients precomputed for one sample rate.
+ * 
+ * Rows are spaced kStepsPerOctave per octave of cutoff from kMinCutoff to
+ * kMaxCutoff, columns kResonanceSteps apart over resonance 0 - 1. A lookup
+ * interpolates bilinearly between the four surrounding entries, which keeps
+ * the coefficients within a fraction of a percent of the exact values.
+ * 
+ * Tables are built once per sample rate, on the thread that first asks for
+ * it (normally from setSampleRate), and shared by every filter at that rate.
+ */
+class FilterCoefficientTable {
+public:
+    static constexpr float kMinCutoff = 20.0f;
+    static constexpr float kMaxCutoff = 20000.0f;
+    static constexpr int kStepsPerOctave = 16;
+    static constexpr int kCutoffRows = 161;    // log2(1000) octaves, rounded up, plus one
+    static constexpr int kResonanceSteps = 16;
+    static constexpr int kResonanceColumns = kResonanceSteps + 1;
+    
+    /**
+     * Get the table for a sample rate, building it if needed.
+     * 
+     * @param sampleRate The sample rate
+     * @return The shared table
+     */
+    static std::shared_ptr<const FilterCoefficientTable> forSampleRate(int sampleRate) {
+        static std::mutex mutex;
+        static std::map<int, std::shared_ptr<const FilterCoefficientTable>> tables;
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& entry = tables[sampleRate];
+        if (!entry) {
+            entry = std::shared_ptr<const FilterCoefficientTable>(new FilterCoefficientTable(sampleRate));
+        }
+        return entry;
+    }
+    
+    /**
+     * Look up the coefficients for a cutoff in Hz.
+     * 
+     * @param cutoff The cutoff frequency in Hz
+     * @param resonance The resonance (0.0 - 1.0)
+     * @return The interpolated coefficients
+     */
+    Filter::Coefficients lookup(float cutoff, float resonance) const {
+        return lookupOctave(octavesAboveMin(cutoff), resonance);
+    }
+    
+    /**
+     * Look up the coefficients for a cutoff given in octaves above
+     * kMinCutoff, the natural unit for envelope and LFO modulation.
+     * 
+     * @param octave The cutoff in octaves above kMinCutoff
+     * @param resonance The resonance (0.0 - 1.0)
+     * @return The interpolated coefficients
+     */
+    Filter::Coefficients lookupOctave(float octave, float resonance) const {
+        float row = std::clamp(octave * static_cast<float>(kStepsPerOctave), 0.0f,
+                               static_cast<float>(kCutoffRows - 1));
+        int r = std::min(static_cast<int>(row), kCutoffRows - 2);
+        float rowFraction = row - static_cast<float>(r);
+        
+        float column = std::clamp(resonance, 0.0f, 1.0f) * static_cast<float>(kResonanceSteps);
+        int c = std::min(static_cast<int>(column), kResonanceSteps - 1);
+        float columnFraction = column - static_cast<float>(c);
+        
+        const Filter::Coefficients* low = &entries[r * kResonanceColumns + c];
+        const Filter::Coefficients* high = low + kResonanceColumns;
+        return Filter::Coefficients::lerp(Filter::Coefficients::blend(low[0], low[1], columnFraction),
+                                          Filter::Coefficients::blend(high[0], high[1], columnFraction),
+                                          rowFraction);
+    }
+    
+    /**
+     * Cutoff in octaves above kMinCutoff. Uses a polynomial log2 accurate to
+     * about 0.2 cents, so no library call is made per sample.
+     * 
+     * @param cutoff The cutoff frequency in Hz
+     * @return log2(cutoff / kMinCutoff)
+     */
+    static float octavesAboveMin(float cutoff) {
+        float x = std::max(cutoff, kMinCutoff) * (1.0f / kMinCutoff);
+        int32_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        int exponent = ((bits >> 23) & 0xFF) - 127;
+        bits = (bits & 0x007FFFFF) | 0x3F800000;
+        float mantissa;
+        std::memcpy(&mantissa, &bits, sizeof(mantissa));
+        // log2(1 + m) on [0, 1), exact at both ends
+        float m = mantissa - 1.0f;
+        float poly = m + m * (m - 1.0f) * (-0.438073245f + m * (0.236693417f - 0.0803073039f * m));
+        return static_cast<float>(exponent) + poly;
+    }
+    
+private:
+    explicit FilterCoefficientTable(int sampleRate) : entries(kCutoffRows * kResonanceColumns) {
+        for (int r = 0; r < kCutoffRows; ++r) {
+            float cutoff = kMinCutoff * std::exp2(static_cast<float>(r) / kStepsPerOctave);
+            for (int c = 0; c < kResonanceColumns; ++c) {
+                float resonance = static_cast<float>(c) / kResonanceSteps;
+                entries[r * kResonanceColumns + c] = Filter::computeCoefficients(cutoff, resonance, sampleRate);
+            }
+        }
+    }
+    
+    std::vector<Filter::Coefficients> entries;
 };
 
-#endif // FILTER_H
\ No newline at end of file
+inline void Filter::updateTable() {
+    table = FilterCoefficientTable::forSampleRate(sampleRate);
+}
+
+inline void Filter::calculateCoefficients() {
+    coefficients = table->lookup(cutoff, resonance);
+}
+
+inline void Filter::processModulated(float* samples, const float* cutoffs, int numFrames) {
+    const FilterCoefficientTable& lookupTable = *table;
+    const float res = resonance;
+    const float g = gain;
+    float* s = state;
+    dispatch(type, [&](auto typeConstant) {
+        constexpr FilterType Type = decltype(typeConstant)::value;
+        for (int n = 0; n < numFrames; ++n) {
+            const Coefficients c = lookupTable.lookup(cutoffs[n], res);
+            samples[n] = step<Type>(samples[n], s[0], s[1], s[2], s[3], c, g);
+        }
+    });
+}
+
+#endif // FILTER_H
@@ -0,0 +1,219 @@
+#ifndef FILTER_BANK_H
+#define FILTER_BANK_H
+
+#include <algorithm>
+#include <cmath>
+#include "filter.h"
+
+/**
+ * Per-voice filters, processed side by side.
+ *
+ * The bank holds one filter per channel of every voice ("lanes": voice v
+ * uses lane 2v for left and 2v + 1 for right) in structure-of-arrays form.
+ * Audio is exchanged through an interleaved block buffer, frame-major with
+ * kLanes floats per frame, so each step of the filter recursion runs across
+ * kGroup lanes at once and the compiler turns it into 4/8-wide SIMD.
+ *
+ * The filter type is chosen once per block: process() dispatches to a
+ * kernel templated on the filter type, so the per-sample loop has no
+ * branches. Coefficients are shared by every lane and taken from a Filter,
+ * which keeps the user-facing cutoff/resonance/type settings; they are
+ * interpolated linearly across each block, so cutoff changes do not step.
+ * For audio-rate modulation, process() also accepts a cutoff per frame,
+ * looked up in the filter's shared coefficient table.
+ */
+class FilterBank {
+public:
+    static constexpr int kMaxVoices = 16;
+    static constexpr int kLanes = kMaxVoices * 2;
+    static constexpr int kGroup = 8;       // Lanes per SIMD step (one AVX register)
+    static constexpr int kBlockSize = 64;  // Frames per block
+
+    FilterBank() : activeLanes(kGroup), type(Filter::FilterType::LowPass), gain(1.0f),
+                   resonance(0.5f), table(nullptr) {
+        coefficients = targetCoefficients = Filter::computeCoefficients(1000.0f, 0.5f, 44100);
+        reset();
+        std::fill(&buffer[0][0], &buffer[0][0] + kBlockSize * kLanes, 0.0f);
+    }
+
+    /**
+     * Set how many voices are filtered. Lanes beyond the last voice are
+     * skipped, in whole kGroup steps.
+     *
+     * @param voices The number of voices (clamped to 1 - kMaxVoices)
+     */
+    void setVoiceCount(int voices) {
+        int lanes = std::clamp(voices, 1, kMaxVoices) * 2;
+        activeLanes = (lanes + kGroup - 1) / kGroup * kGroup;
+    }
+
+    /**
+     * Take the type, gain and coefficients of a filter for the next block.
+     *
+     * The coefficients are reached at the end of the block. A change of
+     * filter model resets the state and jumps straight to them.
+     *
+     * @param filter The filter holding the current settings
+     */
+    void setParameters(const Filter& filter) {
+        Filter::FilterType newType = filter.getType();
+        targetCoefficients = filter.getCoefficients();
+        if (Filter::modelOf(newType) != Filter::modelOf(type)) {
+            reset();
+            coefficients = targetCoefficients;
+        }
+        type = newType;
+        gain = filter.getGain();
+        resonance = filter.getResonance();
+        table = filter.getCoefficientTable();
+    }
+
+    /**
+     * Interleaved input/output for one frame of the current block.
+     *
+     * Write each voice's left/right samples to lanes 2v and 2v + 1 before
+     * process(), and read the filtered samples back from the same place.
+     *
+     * @param frame The frame within the block (0 - kBlockSize-1)
+     * @return kLanes floats
+     */
+    float* frame(int frame) {
+        return buffer[frame];
+    }
+
+    /**
+     * Clear one frame's input for all lanes.
+     *
+     * @param frame The frame within the block
+     */
+    void clearFrame(int frame) {
+        std::fill(buffer[frame], buffer[frame] + kLanes, 0.0f);
+    }
+
+    /**
+     * Filter the first numFrames frames of the block buffer in place.
+     *
+     * @param numFrames The number of frames (at most kBlockSize)
+     */
+    void process(int numFrames) {
+        numFrames = std::min(numFrames, kBlockSize);
+        if (numFrames <= 0) {
+            return;
+        }
+        const float ramp = 1.0f / static_cast<float>(numFrames);
+        for (int n = 0; n < numFrames; ++n) {
+            frameCoefficients[n] = Filter::Coefficients::lerp(coefficients, targetCoefficients,
+                                                              static_cast<float>(n + 1) * ramp);
+        }
+        coefficients = targetCoefficients;
+        run(numFrames);
+    }
+
+    /**
+     * Filter the first numFrames frames of the block buffer in place, with
+     * a cutoff for every frame (shared by all lanes) at the current
+     * resonance. The ramp of process(int) resumes from the last cutoff.
+     *
+     * @param numFrames The number of frames (at most kBlockSize)
+     * @param cutoffs The cutoff frequency in Hz for each frame
+     */
+    void process(int numFrames, const float* cutoffs) {
+        numFrames = std::min(numFrames, kBlockSize);
+        if (numFrames <= 0 || !table) {
+            process(numFrames);
+            return;
+        }
+        for (int n = 0; n < numFrames; ++n) {
+            frameCoefficients[n] = table->lookup(cutoffs[n], resonance);
+        }
+        coefficients = frameCoefficients[numFrames - 1];
+        run(numFrames);
+    }
+
+    /**
+     * Reset the state of every lane.
+     */
+    void reset() {
+        for (auto& s : state) {
+            std::fill(s, s + kLanes, 0.0f);
+        }
+    }
+
+    /**
+     * Reset the state of one voice's lanes.
+     *
+     * @param voice The voice index
+     */
+    void resetVoice(int voice) {
+        if (voice < 0 || voice >= kMaxVoices) {
+            return;
+        }
+        for (auto& s : state) {
+            s[2 * voice] = s[2 * voice + 1] = 0.0f;
+        }
+    }
+
+private:
+    /**
+     * Run the kernel for the current type over frameCoefficients.
+     */
+    void run(int numFrames) {
+        Filter::dispatch(type, [&](auto typeConstant) {
+            processBlock<decltype(typeConstant)::value>(numFrames);
+        });
+        flushDenormals();
+    }
+
+    /**
+     * Filter::step across the active lanes, with one set of coefficients
+     * per frame.
+     */
+    template <Filter::FilterType Type>
+    void processBlock(int numFrames) {
+        const float g = gain;
+        float* s0 = state[0];
+        float* s1 = state[1];
+        float* s2 = state[2];
+        float* s3 = state[3];
+        for (int n = 0; n < numFrames; ++n) {
+            const Filter::Coefficients c = frameCoefficients[n];
+            float* io = buffer[n];
+            for (int base = 0; base < activeLanes; base += kGroup) {
+                for (int i = 0; i < kGroup; ++i) {
+                    const int lane = base + i;
+                    io[lane] = Filter::step<Type>(io[lane], s0[lane], s1[lane], s2[lane], s3[lane], c, g);
+                }
+            }
+        }
+    }
+
+    /**
+     * Zero states that have decayed below audibility, so silent voices do
+     * not fall into denormal arithmetic. Once per block is enough: a state
+     * above the threshold cannot decay into the denormal range within one.
+     */
+    void flushDenormals() {
+        for (auto& s : state) {
+            for (int lane = 0; lane < activeLanes; ++lane) {
+                s[lane] = (std::abs(s[lane]) < 1e-15f) ? 0.0f : s[lane];
+            }
+        }
+    }
+
+    int activeLanes;
+    Filter::FilterType type;
+    float gain;
+    float resonance;
+    const FilterCoefficientTable* table;     // Owned by the Filter passed to setParameters
+    Filter::Coefficients coefficients;       // At the start of the next block
+    Filter::Coefficients targetCoefficients; // At its end
+    Filter::Coefficients frameCoefficients[kBlockSize];
+
+    // Per-lane filter state (Filter::kStateSize values per lane)
+    alignas(32) float state[Filter::kStateSize][kLanes];
+
+    // Interleaved block buffer: kLanes floats per frame
+    alignas(32) float buffer[kBlockSize][kLanes];
+};
+
+#endif // FILTER_BANK_H
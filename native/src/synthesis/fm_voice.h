@@ -0,0 +1,362 @@
+#ifndef FM_VOICE_H
+#define FM_VOICE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include "fast_math.h"
+
+/**
+ * Six-operator phase-modulation voice.
+ *
+ * Operator state is kept as structure-of-arrays and the voice renders in blocks
+ * of kBlockSize samples. Operators are rendered one at a time over the whole
+ * block, modulators before the operators they feed, so every per-operator loop
+ * runs across samples and vectorizes (the self-feedback operator is the only
+ * one with a sample-to-sample dependency). Operator envelopes run at control
+ * rate: they are advanced once per block and ramped linearly across it.
+ *
+ * Algorithms follow the DX convention that an operator is only modulated by
+ * operators with a higher index, so rendering from operator 5 down to 0 is a
+ * valid topological order. Four-operator patches use operators 0-3 and leave
+ * the levels of 4 and 5 at zero; silent operators are skipped.
+ */
+class FMVoice {
+public:
+    static constexpr int kNumOperators = 6;
+    static constexpr int kNumAlgorithms = 8;
+    static constexpr int kBlockSize = 32;
+    static constexpr int kFeedbackOperator = kNumOperators - 1;
+
+    FMVoice() : sampleRate(44100), baseIncrement(0.0f), algorithm(0), feedback(0.0f),
+                feedbackHistory1(0.0f), feedbackHistory2(0.0f), blockPosition(kBlockSize) {
+        for (int op = 0; op < kNumOperators; ++op) {
+            ratio[op] = 1.0f;
+            level[op] = (op == 0) ? 1.0f : 0.0f;
+            phase[op] = 0.0f;
+            envLevel[op] = 0.0f;
+            envStage[op] = EnvStage::Idle;
+            attack[op] = 0.01f;
+            decay[op] = 0.1f;
+            sustain[op] = 1.0f;
+            release[op] = 0.3f;
+        }
+        std::fill(std::begin(block), std::end(block), 0.0f);
+    }
+
+    void setSampleRate(int sr) {
+        sampleRate = (sr > 0) ? sr : 44100;
+    }
+
+    /**
+     * Set the carrier phase increment (frequency / sample rate, detune applied).
+     */
+    void setBaseIncrement(float increment) {
+        baseIncrement = increment;
+    }
+
+    /**
+     * Select the operator routing.
+     *
+     * @param index The algorithm index (0 - kNumAlgorithms-1)
+     */
+    void setAlgorithm(int index) {
+        algorithm = std::clamp(index, 0, kNumAlgorithms - 1);
+    }
+
+    /**
+     * Set the self-feedback amount of the top operator.
+     *
+     * @param amount Feedback amount (0.0 - 1.0)
+     */
+    void setFeedback(float amount) {
+        feedback = std::clamp(amount, 0.0f, 1.0f);
+    }
+
+    void setOperatorRatio(int op, float r) {
+        if (op < 0 || op >= kNumOperators) return;
+        ratio[op] = std::clamp(r, 0.0f, 32.0f);
+    }
+
+    void setOperatorLevel(int op, float l) {
+        if (op < 0 || op >= kNumOperators) return;
+        level[op] = std::clamp(l, 0.0f, 1.0f);
+    }
+
+    void setOperatorAttack(int op, float seconds) {
+        if (op < 0 || op >= kNumOperators) return;
+        attack[op] = std::max(seconds, 0.0005f);
+    }
+
+    void setOperatorDecay(int op, float seconds) {
+        if (op < 0 || op >= kNumOperators) return;
+        decay[op] = std::max(seconds, 0.0005f);
+    }
+
+    void setOperatorSustain(int op, float l) {
+        if (op < 0 || op >= kNumOperators) return;
+        sustain[op] = std::clamp(l, 0.0f, 1.0f);
+    }
+
+    void setOperatorRelease(int op, float seconds) {
+        if (op < 0 || op >= kNumOperators) return;
+        release[op] = std::max(seconds, 0.0005f);
+    }
+
+    int getAlgorithm() const {
+        return algorithm;
+    }
+
+    /**
+     * Start all operator envelopes and reset the operator phases.
+     */
+    void noteOn() {
+        for (int op = 0; op < kNumOperators; ++op) {
+            envStage[op] = EnvStage::Attack;
+            phase[op] = 0.0f;
+        }
+        feedbackHistory1 = 0.0f;
+        feedbackHistory2 = 0.0f;
+    }
+
+    /**
+     * Move all operator envelopes into their release stage.
+     */
+    void noteOff() {
+        for (int op = 0; op < kNumOperators; ++op) {
+            if (envStage[op] != EnvStage::Idle) {
+                envStage[op] = EnvStage::Release;
+            }
+        }
+    }
+
+    /**
+     * Get the next sample, rendering a new block when the previous one is used up.
+     */
+    float nextSample() {
+        if (blockPosition >= kBlockSize) {
+            renderBlock(block, kBlockSize);
+            blockPosition = 0;
+        }
+        return block[blockPosition++];
+    }
+
+    /**
+     * Render numFrames samples into output.
+     */
+    void render(float* output, int numFrames) {
+        // Drain what is left of the sample-by-sample block first so both paths stay in sync
+        while (numFrames > 0 && blockPosition < kBlockSize) {
+            *output++ = block[blockPosition++];
+            --numFrames;
+        }
+        while (numFrames > 0) {
+            int count = std::min(numFrames, static_cast<int>(kBlockSize));
+            renderBlock(output, count);
+            output += count;
+            numFrames -= count;
+        }
+    }
+
+private:
+    enum class EnvStage : uint8_t {
+        Idle,
+        Attack,
+        Decay,
+        Sustain,
+        Release
+    };
+
+    /**
+     * Routing for one algorithm: for each operator, a bit mask of the
+     * operators modulating it, plus the mask of operators heard as carriers.
+     */
+    struct Algorithm {
+        uint8_t modulators[kNumOperators];
+        uint8_t carriers;
+    };
+
+    static const Algorithm& algorithmAt(int index) {
+        static const Algorithm algorithms[kNumAlgorithms] = {
+            // 0: single stack 5 > 4 > 3 > 2 > 1 > 0
+            {{1 << 1, 1 << 2, 1 << 3, 1 << 4, 1 << 5, 0}, 1 << 0},
+            // 1: two three-operator stacks 2 > 1 > 0 and 5 > 4 > 3
+            {{1 << 1, 1 << 2, 0, 1 << 4, 1 << 5, 0}, (1 << 0) | (1 << 3)},
+            // 2: three pairs 1 > 0, 3 > 2, 5 > 4
+            {{1 << 1, 0, 1 << 3, 0, 1 << 5, 0}, (1 << 0) | (1 << 2) | (1 << 4)},
+            // 3: operators 1 and 2 both into 0, plus stack 5 > 4 > 3
+            {{(1 << 1) | (1 << 2), 0, 0, 1 << 4, 1 << 5, 0}, (1 << 0) | (1 << 3)},
+            // 4: operator 5 into five carriers
+            {{1 << 5, 1 << 5, 1 << 5, 1 << 5, 1 << 5, 0}, 0x1F},
+            // 5: stack 3 > 2 > 1 > 0 with 4 and 5 as plain carriers
+            {{1 << 1, 1 << 2, 1 << 3, 0, 0, 0}, (1 << 0) | (1 << 4) | (1 << 5)},
+            // 6: pair 1 > 0 with 2 - 5 as plain carriers
+            {{1 << 1, 0, 0, 0, 0, 0}, 0x3D},
+            // 7: all carriers (additive)
+            {{0, 0, 0, 0, 0, 0}, 0x3F}
+        };
+        return algorithms[index];
+    }
+
+    // Phase deviation in cycles per unit of modulator output
+    static constexpr float kModulationDepth = 1.5f;
+    // Phase deviation in cycles at full feedback
+    static constexpr float kFeedbackDepth = 0.25f;
+
+    /**
+     * Advance one operator envelope by a block and return its level at the end.
+     */
+    float advanceEnvelope(int op, float blockSeconds) {
+        float value = envLevel[op];
+        switch (envStage[op]) {
+            case EnvStage::Attack:
+                value += blockSeconds / attack[op];
+                if (value >= 1.0f) {
+                    value = 1.0f;
+                    envStage[op] = EnvStage::Decay;
+                }
+                break;
+            case EnvStage::Decay: {
+                // Exponential approach, about -60 dB of the distance after 'decay' seconds
+                float coeff = fastmath::exp(-6.9f * blockSeconds / decay[op]);
+                value = sustain[op] + (value - sustain[op]) * coeff;
+                if (value - sustain[op] < 0.0005f) {
+                    value = sustain[op];
+                    envStage[op] = EnvStage::Sustain;
+                }
+                break;
+            }
+            case EnvStage::Sustain:
+                value = sustain[op];
+                break;
+            case EnvStage::Release: {
+                float coeff = fastmath::exp(-6.9f * blockSeconds / release[op]);
+                value *= coeff;
+                if (value < 0.0001f) {
+                    value = 0.0f;
+                    envStage[op] = EnvStage::Idle;
+                }
+                break;
+            }
+            case EnvStage::Idle:
+            default:
+                value = 0.0f;
+                break;
+        }
+        envLevel[op] = value;
+        return value;
+    }
+
+    void renderBlock(float* output, int numFrames) {
+        const Algorithm& algo = algorithmAt(algorithm);
+        const float blockSeconds = static_cast<float>(numFrames) / static_cast<float>(sampleRate);
+        const float invFrames = 1.0f / static_cast<float>(numFrames);
+
+        int carrierCount = 0;
+        for (int i = 0; i < numFrames; ++i) {
+            output[i] = 0.0f;
+        }
+
+        for (int op = kNumOperators - 1; op >= 0; --op) {
+            float startGain = envLevel[op] * level[op];
+            float endGain = advanceEnvelope(op, blockSeconds) * level[op];
+            float increment = baseIncrement * ratio[op];
+            float* out = operatorOutput[op];
+            bool isCarrier = (algo.carriers >> op) & 1;
+            carrierCount += isCarrier ? 1 : 0;
+
+            if (startGain <= 0.0f && endGain <= 0.0f) {
+                // Silent operator: keep its phase running, contribute nothing
+                for (int i = 0; i < numFrames; ++i) {
+                    out[i] = 0.0f;
+                }
+                phase[op] = wrap(phase[op] + increment * static_cast<float>(numFrames));
+                continue;
+            }
+
+            // Sum of the modulator outputs feeding this operator
+            for (int i = 0; i < numFrames; ++i) {
+                modulation[i] = 0.0f;
+            }
+            for (int m = op + 1; m < kNumOperators; ++m) {
+                if ((algo.modulators[op] >> m) & 1) {
+                    const float* src = operatorOutput[m];
+                    for (int i = 0; i < numFrames; ++i) {
+                        modulation[i] += src[i];
+                    }
+                }
+            }
+
+            const float p0 = phase[op];
+            const float gainStep = (endGain - startGain) * invFrames;
+
+            if (op == kFeedbackOperator && feedback > 0.0f) {
+                // Self-feedback averages the last two outputs (as on the DX7) to tame the
+                // sample-to-sample dependency; this loop is necessarily serial.
+                float fbScale = feedback * kFeedbackDepth;
+                float y1 = feedbackHistory1;
+                float y2 = feedbackHistory2;
+                for (int i = 0; i < numFrames; ++i) {
+                    float p = p0 + increment * static_cast<float>(i)
+                            + kModulationDepth * modulation[i] + fbScale * (y1 + y2);
+                    float y = fastmath::sin2pi(p) * (startGain + gainStep * static_cast<float>(i));
+                    out[i] = y;
+                    y2 = y1;
+                    y1 = y;
+                }
+                feedbackHistory1 = y1;
+                feedbackHistory2 = y2;
+            } else {
+                for (int i = 0; i < numFrames; ++i) {
+                    float p = p0 + increment * static_cast<float>(i) + kModulationDepth * modulation[i];
+                    out[i] = fastmath::sin2pi(p) * (startGain + gainStep * static_cast<float>(i));
+                }
+            }
+
+            phase[op] = wrap(p0 + increment * static_cast<float>(numFrames));
+
+            if (isCarrier) {
+                for (int i = 0; i < numFrames; ++i) {
+                    output[i] += out[i];
+                }
+            }
+        }
+
+        if (carrierCount > 1) {
+            float norm = 1.0f / static_cast<float>(carrierCount);
+            for (int i = 0; i < numFrames; ++i) {
+                output[i] *= norm;
+            }
+        }
+    }
+
+    static inline float wrap(float p) {
+        return p - std::floor(p);
+    }
+
+    int sampleRate;
+    float baseIncrement;
+    int algorithm;
+    float feedback;
+    float feedbackHistory1;
+    float feedbackHistory2;
+
+    // Operator state (structure-of-arrays)
+    alignas(32) float ratio[kNumOperators];
+    alignas(32) float level[kNumOperators];
+    alignas(32) float phase[kNumOperators];
+    alignas(32) float envLevel[kNumOperators];
+    alignas(32) float attack[kNumOperators];
+    alignas(32) float decay[kNumOperators];
+    alignas(32) float sustain[kNumOperators];
+    alignas(32) float release[kNumOperators];
+    EnvStage envStage[kNumOperators];
+
+    // Block buffers
+    alignas(32) float operatorOutput[kNumOperators][kBlockSize];
+    alignas(32) float modulation[kBlockSize];
+    alignas(32) float block[kBlockSize];
+    int blockPosition;
+};
+
+#endif // FM_VOICE_H
@@ -0,0 +1,162 @@
+#ifndef FRACTIONAL_DELAY_H
+#define FRACTIONAL_DELAY_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "fast_math.h"
+
+/**
+ * Multi-channel delay line read at fractional positions, shared by the
+ * modulated delay effects.
+ *
+ * Frames are stored interleaved in one ring whose length is a power of
+ * two, so positions wrap with a mask and the taps of every channel sit
+ * next to each other. Delays are counted back from the next frame to be
+ * pushed: a delay of d returns the input of d frames ago.
+ *
+ * @tparam kChannels The number of interleaved channels
+ */
+template <int kChannels>
+class FractionalDelay {
+public:
+    FractionalDelay() : mask(0), writeIndex(0) {}
+
+    /**
+     * Size the ring for a maximum delay. Not realtime safe.
+     *
+     * @param maxDelay The longest delay that will be read, in samples
+     */
+    void setMaxDelay(int maxDelay) {
+        int frames = 1;
+        while (frames < maxDelay + 4) {
+            frames <<= 1;
+        }
+        buffer.assign(static_cast<size_t>(frames) * kChannels, 0.0f);
+        mask = frames - 1;
+        writeIndex = 0;
+    }
+
+    /**
+     * Clear the delay line.
+     */
+    void clear() {
+        std::fill(buffer.begin(), buffer.end(), 0.0f);
+    }
+
+    /**
+     * Append one frame.
+     *
+     * @param frame kChannels samples
+     */
+    inline void push(const float* frame) {
+        float* slot = buffer.data() + writeIndex * kChannels;
+        for (int c = 0; c < kChannels; ++c) {
+            slot[c] = frame[c];
+        }
+        writeIndex = (writeIndex + 1) & mask;
+    }
+
+    /**
+     * Read with cubic (Hermite) interpolation, which keeps the top octave
+     * far flatter than linear interpolation as the delay sweeps.
+     *
+     * @param channel The channel
+     * @param delay The delay in samples (at least 2)
+     * @return The interpolated sample
+     */
+    inline float readCubic(int channel, float delay) const {
+        const int whole = static_cast<int>(delay);
+        const float t = delay - static_cast<float>(whole);
+        // Taps from newest to oldest: one newer than the delay, then three at and beyond it
+        const float newer = at(whole - 1, channel);
+        const float x0 = at(whole, channel);
+        const float x1 = at(whole + 1, channel);
+        const float older = at(whole + 2, channel);
+        const float c1 = 0.5f * (x1 - newer);
+        const float c2 = newer - 2.5f * x0 + 2.0f * x1 - 0.5f * older;
+        const float c3 = 0.5f * (older - newer) + 1.5f * (x0 - x1);
+        return ((c3 * t + c2) * t + c1) * t + x0;
+    }
+
+    /**
+     * Read with first-order allpass interpolation. The magnitude response
+     * stays flat at every fractional delay, so repeated passes through a
+     * feedback loop do not dull the sound; the price is a state variable
+     * per tap, and the delay should move slowly.
+     *
+     * @param channel The channel
+     * @param delay The delay in samples (at least 2)
+     * @param state The tap's previous output, updated
+     * @return The interpolated sample
+     */
+    inline float readAllpass(int channel, float delay, float& state) const {
+        int whole = static_cast<int>(delay);
+        float fraction = delay - static_cast<float>(whole);
+        // Keep the fraction in [0.1, 1.1) so the allpass coefficient stays well inside the unit circle
+        if (fraction < 0.1f) {
+            fraction += 1.0f;
+            whole -= 1;
+        }
+        const float eta = (1.0f - fraction) / (1.0f + fraction);
+        state = eta * (at(whole, channel) - state) + at(whole + 1, channel);
+        return state;
+    }
+
+private:
+    inline float at(int delay, int channel) const {
+        return buffer[((writeIndex - delay) & mask) * kChannels + channel];
+    }
+
+    std::vector<float> buffer; // Interleaved frames
+    int mask;                  // Frames in the ring - 1
+    int writeIndex;            // Frame
+};
+
+/**
+ * Sine LFO evaluated at block rate. Effects take its value at the start and
+ * end of each block and ramp their modulation linearly in between, so the
+ * per-sample cost of modulation is one add.
+ */
+class BlockLfo {
+public:
+    BlockLfo() : phase(0.0f) {}
+
+    /**
+     * @param offset Phase offset in cycles
+     * @return The LFO value (-1.0 - 1.0) at the current phase plus offset
+     */
+    inline float value(float offset = 0.0f) const {
+        return fastmath::sin2pi(phase + offset);
+    }
+
+    /**
+     * Advance the phase.
+     *
+     * @param rate The rate in Hz
+     * @param numFrames The number of frames to advance by
+     * @param sampleRate The sample rate
+     */
+    void advance(float rate, int numFrames, int sampleRate) {
+        phase += rate * static_cast<float>(numFrames) / static_cast<float>(sampleRate);
+        phase -= std::floor(phase);
+    }
+
+    /**
+     * Jump to a phase, for LFOs locked to the transport.
+     *
+     * @param cycles The phase in cycles
+     */
+    void setPhase(double cycles) {
+        phase = static_cast<float>(cycles - std::floor(cycles));
+    }
+
+    void reset() {
+        phase = 0.0f;
+    }
+
+private:
+    float phase; // Cycles (0.0 - 1.0)
+};
+
+#endif // FRACTIONAL_DELAY_H
@@ -0,0 +1,225 @@
+#ifndef MINBLEP_H
+#define MINBLEP_H
+
+#include <cmath>
+#include <complex>
+#include <vector>
+
+/**
+ * Precomputed minimum-phase band-limited step (MinBLEP) residual table.
+ *
+ * The table is built once, on first use, following Brandt's method: a
+ * Blackman-windowed sinc is made minimum phase with the real cepstrum and
+ * integrated into a step. Only the residual (band-limited step minus the
+ * ideal step) is stored, oversampled kOversampling times, so correcting a
+ * discontinuity is a short multiply-add into a per-voice MinBlepBuffer.
+ * Being minimum phase, the correction is causal: nothing has to be added to
+ * samples that were already output.
+ */
+class MinBlepTable {
+public:
+    static constexpr int kZeroCrossings = 16;
+    static constexpr int kOversampling = 64;
+    static constexpr int kLength = 32; // Residual length in output samples
+    static constexpr double kCutoff = 0.85; // Fraction of Nyquist
+
+    /**
+     * Residual of the band-limited step at a time after the discontinuity.
+     *
+     * @param samplesSince Time since the step in samples (>= 0)
+     * @return The residual; zero beyond kLength samples
+     */
+    static inline float residual(float samplesSince) {
+        const float* table = data();
+        float position = samplesSince * static_cast<float>(kOversampling);
+        int index = static_cast<int>(position);
+        if (index >= kLength * kOversampling) {
+            return 0.0f;
+        }
+        float fraction = position - static_cast<float>(index);
+        return table[index] + fraction * (table[index + 1] - table[index]);
+    }
+
+    /**
+     * The raw residual table: kLength * kOversampling + 2 entries, the last one zero.
+     */
+    static const float* data() {
+        return instance().values.data();
+    }
+
+    /**
+     * Force the table to be built (e.g. from a non-realtime thread at startup).
+     */
+    static void prepare() {
+        instance();
+    }
+
+private:
+    MinBlepTable() {
+        const int points = 2 * kZeroCrossings * kOversampling + 1;
+        int fftSize = 1;
+        while (fftSize < 4 * points) {
+            fftSize <<= 1;
+        }
+        const double pi = 3.14159265358979323846;
+
+        // Blackman-windowed sinc. The cutoff sits below Nyquist so the window's
+        // transition band ends before it; a cutoff at Nyquist rings there.
+        std::vector<std::complex<double>> buffer(fftSize, 0.0);
+        for (int i = 0; i < points; ++i) {
+            double x = (static_cast<double>(i) / (points - 1) * 2.0 - 1.0) * kZeroCrossings * kCutoff;
+            double sinc = (x == 0.0) ? 1.0 : std::sin(pi * x) / (pi * x);
+            double r = static_cast<double>(i) / (points - 1);
+            double window = 0.42 - 0.5 * std::cos(2.0 * pi * r) + 0.08 * std::cos(4.0 * pi * r);
+            buffer[i] = sinc * window;
+        }
+
+        // Real cepstrum: log magnitude spectrum back to the quefrency domain
+        fft(buffer, false);
+        for (auto& bin : buffer) {
+            bin = std::log(std::max(std::abs(bin), 1e-100));
+        }
+        fft(buffer, true);
+
+        // Fold the cepstrum to make it causal, which yields the minimum-phase spectrum
+        for (int i = 1; i < fftSize / 2; ++i) {
+            buffer[i] *= 2.0;
+        }
+        for (int i = fftSize / 2 + 1; i < fftSize; ++i) {
+            buffer[i] = 0.0;
+        }
+        fft(buffer, false);
+        for (auto& bin : buffer) {
+            bin = std::exp(bin);
+        }
+        fft(buffer, true);
+
+        // Integrate the minimum-phase impulse into a step and store the residual
+        const int tableSize = kLength * kOversampling + 1;
+        std::vector<double> step(tableSize);
+        double sum = 0.0;
+        for (int i = 0; i < tableSize; ++i) {
+            sum += buffer[i].real();
+            step[i] = sum;
+        }
+        double total = sum;
+        for (int i = tableSize; i < fftSize; ++i) {
+            total += buffer[i].real();
+        }
+        values.resize(tableSize + 1);
+        for (int i = 0; i < tableSize; ++i) {
+            values[i] = static_cast<float>(step[i] / total - 1.0);
+        }
+        // Fade the tail to exactly zero so truncation does not leave a step
+        const int fade = kOversampling * 4;
+        for (int i = 0; i < fade; ++i) {
+            int index = tableSize - 1 - i;
+            values[index] *= static_cast<float>(i) / fade;
+        }
+        values[tableSize] = 0.0f;
+    }
+
+    static const MinBlepTable& instance() {
+        static const MinBlepTable table;
+        return table;
+    }
+
+    /**
+     * In-place radix-2 complex FFT; the inverse is scaled by 1/N.
+     */
+    static void fft(std::vector<std::complex<double>>& data, bool inverse) {
+        const size_t n = data.size();
+        for (size_t i = 1, j = 0; i < n; ++i) {
+            size_t bit = n >> 1;
+            for (; j & bit; bit >>= 1) {
+                j ^= bit;
+            }
+            j ^= bit;
+            if (i < j) {
+                std::swap(data[i], data[j]);
+            }
+        }
+        const double pi = 3.14159265358979323846;
+        for (size_t length = 2; length <= n; length <<= 1) {
+            double angle = 2.0 * pi / static_cast<double>(length) * (inverse ? 1.0 : -1.0);
+            std::complex<double> root(std::cos(angle), std::sin(angle));
+            for (size_t i = 0; i < n; i += length) {
+                std::complex<double> w(1.0, 0.0);
+                for (size_t k = 0; k < length / 2; ++k) {
+                    std::complex<double> even = data[i + k];
+                    std::complex<double> odd = data[i + k + length / 2] * w;
+                    data[i + k] = even + odd;
+                    data[i + k + length / 2] = even - odd;
+                    w *= root;
+                }
+            }
+        }
+        if (inverse) {
+            for (auto& value : data) {
+                value /= static_cast<double>(n);
+            }
+        }
+    }
+
+    std::vector<float> values;
+};
+
+/**
+ * Per-voice ring of pending MinBLEP corrections.
+ *
+ * addStep() mixes the residual of a discontinuity into the next
+ * MinBlepTable::kLength samples; process() adds the pending correction to a
+ * naive sample and advances the ring.
+ */
+class MinBlepBuffer {
+public:
+    static constexpr int kSize = 64; // Power of two >= MinBlepTable::kLength
+
+    MinBlepBuffer() : position(0) {
+        clear();
+    }
+
+    void clear() {
+        for (float& value : ring) {
+            value = 0.0f;
+        }
+        position = 0;
+    }
+
+    /**
+     * Schedule the correction for a step discontinuity.
+     *
+     * @param amplitude Height of the step (value after minus value before)
+     * @param samplesSince How long before the next output sample the step happened (0 - 2)
+     */
+    void addStep(float amplitude, float samplesSince) {
+        // Every tap shares the same fractional table position, so the
+        // interpolation weights are computed once.
+        const float* table = MinBlepTable::data();
+        const int stride = MinBlepTable::kOversampling;
+        const int end = MinBlepTable::kLength * MinBlepTable::kOversampling;
+        float scaled = samplesSince * static_cast<float>(stride);
+        int index = static_cast<int>(scaled);
+        float fraction = scaled - static_cast<float>(index);
+        for (int i = 0; index < end && i < MinBlepTable::kLength; ++i, index += stride) {
+            float value = table[index] + fraction * (table[index + 1] - table[index]);
+            ring[(position + i) & (kSize - 1)] += amplitude * value;
+        }
+    }
+
+    /**
+     * Apply the pending correction to a naive sample and advance.
+     */
+    float process(float naive) {
+        float out = naive + ring[position];
+        ring[position] = 0.0f;
+        position = (position + 1) & (kSize - 1);
+        return out;
+    }
+
+private:
+    float ring[kSize];
+    int position;
+};
+
+#endif // MINBLEP_H
@@ -0,0 +1,459 @@
+#ifndef MODULATION_EFFECTS_H
+#define MODULATION_EFFECTS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include "fractional_delay.h"
+
+/**
+ * Stereo chorus: four modulated taps per channel on a shared stereo delay
+ * line, read with cubic interpolation.
+ *
+ * The eight taps are processed together as lanes of one loop, so the tap
+ * reads and interpolation vectorize across voices and channels. Each tap has
+ * its own base delay and LFO phase, and the two channels use different sets
+ * of both for width.
+ *
+ * Settings are written from the control thread and read once per block.
+ */
+class Chorus {
+public:
+    static constexpr int kVoices = 4;                  // Taps per channel
+    static constexpr int kLanes = 2 * kVoices;         // Left taps first, then right
+    static constexpr float kMaxBaseDelay = 0.021f;     // Seconds, centre of the longest tap
+    static constexpr float kMaxDepth = 0.005f;         // Seconds of sweep either side at depth 1
+    static constexpr float kDefaultRate = 0.8f;        // Hz
+
+    Chorus() : sampleRate(0) {
+        rate.store(kDefaultRate);
+        depth.store(0.5f);
+        mix.store(0.5f);
+        setSampleRate(44100);
+    }
+
+    /**
+     * Set the sample rate and size the delay line. Not realtime safe.
+     *
+     * @param sr The sample rate
+     */
+    void setSampleRate(int sr) {
+        sampleRate = (sr > 0) ? sr : 44100;
+        const float longest = kMaxBaseDelay + kMaxDepth;
+        line.setMaxDelay(static_cast<int>(longest * static_cast<float>(sampleRate)) + 2);
+        clear();
+    }
+
+    /**
+     * @param hz The LFO rate in Hz (0.01 - 10.0)
+     */
+    void setRate(float hz) {
+        rate.store(std::clamp(hz, 0.01f, 10.0f));
+    }
+
+    /**
+     * Set the LFO phase for the next block; called every block to lock the
+     * LFO to the transport (audio thread).
+     *
+     * @param cycles The phase in cycles
+     */
+    void setLfoPhase(double cycles) {
+        lfo.setPhase(cycles);
+    }
+
+    /**
+     * @param d The modulation depth (0.0 - 1.0)
+     */
+    void setDepth(float d) {
+        depth.store(std::clamp(d, 0.0f, 1.0f));
+    }
+
+    /**
+     * @param m The mix amount (0.0 = dry, 1.0 = wet)
+     */
+    void setMix(float m) {
+        mix.store(std::clamp(m, 0.0f, 1.0f));
+    }
+
+    void clear() {
+        line.clear();
+        lfo.reset();
+    }
+
+    /**
+     * Process a block of stereo audio in place.
+     *
+     * @param left Left channel samples
+     * @param right Right channel samples
+     * @param numFrames The number of frames
+     */
+    void processBlock(float* left, float* right, int numFrames) {
+        if (numFrames <= 0) {
+            return;
+        }
+        const float sr = static_cast<float>(sampleRate);
+        const float sweep = depth.load() * kMaxDepth * sr;
+        const float wet = mix.load();
+        const float dry = 1.0f - wet;
+        const float voiceGain = 1.0f / std::sqrt(static_cast<float>(kVoices));
+
+        // Tap centres (seconds) and LFO phases (cycles), left taps then right
+        static const float baseDelays[kLanes] = {
+            0.0110f, 0.0137f, 0.0163f, 0.0191f,
+            0.0121f, 0.0149f, 0.0178f, 0.0210f
+        };
+        static const float phases[kLanes] = {
+            0.0f, 0.25f, 0.5f, 0.75f,
+            0.125f, 0.375f, 0.625f, 0.875f
+        };
+
+        // Tap delays at the start and end of the block, ramped in between
+        float delay[kLanes];
+        float step[kLanes];
+        for (int lane = 0; lane < kLanes; ++lane) {
+            delay[lane] = baseDelays[lane] * sr + sweep * lfo.value(phases[lane]);
+        }
+        lfo.advance(rate.load(), numFrames, sampleRate);
+        for (int lane = 0; lane < kLanes; ++lane) {
+            const float end = baseDelays[lane] * sr + sweep * lfo.value(phases[lane]);
+            step[lane] = (end - delay[lane]) / static_cast<float>(numFrames);
+        }
+
+        for (int i = 0; i < numFrames; ++i) {
+            const float frame[2] = {left[i], right[i]};
+            line.push(frame);
+            float taps[kLanes];
+            for (int lane = 0; lane < kLanes; ++lane) {
+                taps[lane] = line.readCubic(lane / kVoices, delay[lane]);
+                delay[lane] += step[lane];
+            }
+            float wetLeft = 0.0f;
+            float wetRight = 0.0f;
+            for (int voice = 0; voice < kVoices; ++voice) {
+                wetLeft += taps[voice];
+                wetRight += taps[kVoices + voice];
+            }
+            left[i] = frame[0] * dry + wetLeft * voiceGain * wet;
+            right[i] = frame[1] * dry + wetRight * voiceGain * wet;
+        }
+    }
+
+private:
+    int sampleRate;
+    std::atomic<float> rate;
+    std::atomic<float> depth;
+    std::atomic<float> mix;
+
+    FractionalDelay<2> line;
+    BlockLfo lfo;
+};
+
+/**
+ * Stereo flanger: one short modulated tap per channel with feedback.
+ *
+ * The tap is read with allpass interpolation, which keeps the feedback path
+ * free of the lowpass that polynomial interpolation would add on every
+ * pass. The channels sweep a quarter cycle apart.
+ *
+ * Settings are written from the control thread and read once per block.
+ */
+class Flanger {
+public:
+    static constexpr float kMinDelay = 0.0005f; // Seconds, the closest the sweep gets
+    static constexpr float kMaxDepth = 0.004f;  // Seconds of sweep at depth 1
+    static constexpr float kDefaultRate = 0.25f; // Hz
+
+    Flanger() : sampleRate(0), tapState{0.0f, 0.0f} {
+        rate.store(kDefaultRate);
+        depth.store(0.7f);
+        mix.store(0.5f);
+        feedback.store(0.6f);
+        setSampleRate(44100);
+    }
+
+    /**
+     * Set the sample rate and size the delay line. Not realtime safe.
+     *
+     * @param sr The sample rate
+     */
+    void setSampleRate(int sr) {
+        sampleRate = (sr > 0) ? sr : 44100;
+        line.setMaxDelay(static_cast<int>((kMinDelay + kMaxDepth) * static_cast<float>(sampleRate)) + 4);
+        clear();
+    }
+
+    /**
+     * @param hz The LFO rate in Hz (0.01 - 10.0)
+     */
+    void setRate(float hz) {
+        rate.store(std::clamp(hz, 0.01f, 10.0f));
+    }
+
+    /**
+     * Set the LFO phase for the next block; called every block to lock the
+     * LFO to the transport (audio thread).
+     *
+     * @param cycles The phase in cycles
+     */
+    void setLfoPhase(double cycles) {
+        lfo.setPhase(cycles);
+    }
+
+    /**
+     * @param d The sweep depth (0.0 - 1.0)
+     */
+    void setDepth(float d) {
+        depth.store(std::clamp(d, 0.0f, 1.0f));
+    }
+
+    /**
+     * @param m The mix amount (0.0 = dry, 1.0 = wet)
+     */
+    void setMix(float m) {
+        mix.store(std::clamp(m, 0.0f, 1.0f));
+    }
+
+    /**
+     * @param fb The feedback amount; negative values invert the repeats (-0.95 - 0.95)
+     */
+    void setFeedback(float fb) {
+        feedback.store(std::clamp(fb, -0.95f, 0.95f));
+    }
+
+    void clear() {
+        line.clear();
+        lfo.reset();
+        tapState[0] = tapState[1] = 0.0f;
+    }
+
+    /**
+     * Process a block of stereo audio in place.
+     *
+     * @param left Left channel samples
+     * @param right Right channel samples
+     * @param numFrames The number of frames
+     */
+    void processBlock(float* left, float* right, int numFrames) {
+        if (numFrames <= 0) {
+            return;
+        }
+        const float sr = static_cast<float>(sampleRate);
+        const float minimum = std::max(2.0f, kMinDelay * sr);
+        const float sweep = depth.load() * kMaxDepth * sr;
+        const float fb = feedback.load();
+        const float wet = mix.load();
+        const float dry = 1.0f - wet;
+
+        // The sweep runs from the minimum delay up and back (a raised sine)
+        const float offsets[2] = {0.0f, 0.25f};
+        float delay[2];
+        float step[2];
+        for (int c = 0; c < 2; ++c) {
+            delay[c] = minimum + sweep * (0.5f + 0.5f * lfo.value(offsets[c]));
+        }
+        lfo.advance(rate.load(), numFrames, sampleRate);
+        for (int c = 0; c < 2; ++c) {
+            step[c] = (minimum + sweep * (0.5f + 0.5f * lfo.value(offsets[c])) - delay[c]) / static_cast<float>(numFrames);
+        }
+
+        float state[2] = {tapState[0], tapState[1]};
+        for (int i = 0; i < numFrames; ++i) {
+            const float in[2] = {left[i], right[i]};
+            float taps[2];
+            float frame[2];
+            for (int c = 0; c < 2; ++c) {
+                taps[c] = line.readAllpass(c, delay[c], state[c]);
+                frame[c] = in[c] + fb * taps[c];
+                delay[c] += step[c];
+            }
+            line.push(frame);
+            left[i] = in[0] * dry + taps[0] * wet;
+            right[i] = in[1] * dry + taps[1] * wet;
+        }
+        // Keep silent tails out of denormal arithmetic
+        for (int c = 0; c < 2; ++c) {
+            tapState[c] = (std::abs(state[c]) < 1e-15f) ? 0.0f : state[c];
+        }
+    }
+
+private:
+    int sampleRate;
+    std::atomic<float> rate;
+    std::atomic<float> depth;
+    std::atomic<float> mix;
+    std::atomic<float> feedback;
+
+    FractionalDelay<2> line;
+    BlockLfo lfo;
+    float tapState[2]; // Allpass interpolator outputs
+};
+
+/**
+ * Stereo phaser: a chain of first-order allpass stages per channel whose
+ * break frequency sweeps exponentially, with feedback around the chain.
+ *
+ * The stage coefficient is worked out from the LFO at the start and end of
+ * each block and ramped in between, so there is no tan() per sample. Both
+ * channels run in the same loop, a quarter cycle apart.
+ *
+ * Settings are written from the control thread and read once per block.
+ */
+class Phaser {
+public:
+    static constexpr int kStages = 6;
+    static constexpr float kMinFrequency = 200.0f;  // Hz, bottom of the sweep at full depth
+    static constexpr float kMaxFrequency = 3200.0f; // Hz, top of the sweep
+    static constexpr float kDefaultRate = 0.4f;     // Hz
+
+    Phaser() : sampleRate(44100), feedbackState{0.0f, 0.0f} {
+        rate.store(kDefaultRate);
+        depth.store(0.8f);
+        mix.store(0.5f);
+        feedback.store(0.5f);
+        clear();
+    }
+
+    /**
+     * @param sr The sample rate
+     */
+    void setSampleRate(int sr) {
+        sampleRate = (sr > 0) ? sr : 44100;
+        clear();
+    }
+
+    /**
+     * @param hz The LFO rate in Hz (0.01 - 10.0)
+     */
+    void setRate(float hz) {
+        rate.store(std::clamp(hz, 0.01f, 10.0f));
+    }
+
+    /**
+     * Set the LFO phase for the next block; called every block to lock the
+     * LFO to the transport (audio thread).
+     *
+     * @param cycles The phase in cycles
+     */
+    void setLfoPhase(double cycles) {
+        lfo.setPhase(cycles);
+    }
+
+    /**
+     * @param d The sweep depth (0.0 - 1.0); shallower sweeps stay near the top
+     */
+    void setDepth(float d) {
+        depth.store(std::clamp(d, 0.0f, 1.0f));
+    }
+
+    /**
+     * @param m The mix amount (0.0 = dry, 1.0 = wet)
+     */
+    void setMix(float m) {
+        mix.store(std::clamp(m, 0.0f, 1.0f));
+    }
+
+    /**
+     * @param fb The feedback amount (-0.95 - 0.95)
+     */
+    void setFeedback(float fb) {
+        feedback.store(std::clamp(fb, -0.95f, 0.95f));
+    }
+
+    void clear() {
+        lfo.reset();
+        for (int s = 0; s < kStages; ++s) {
+            stageState[s][0] = stageState[s][1] = 0.0f;
+        }
+        feedbackState[0] = feedbackState[1] = 0.0f;
+    }
+
+    /**
+     * Process a block of stereo audio in place.
+     *
+     * @param left Left channel samples
+     * @param right Right channel samples
+     * @param numFrames The number of frames
+     */
+    void processBlock(float* left, float* right, int numFrames) {
+        if (numFrames <= 0) {
+            return;
+        }
+        const float sweep = depth.load();
+        const float fb = feedback.load();
+        const float wet = mix.load();
+        const float dry = 1.0f - wet;
+
+        const float offsets[2] = {0.0f, 0.25f};
+        float coeff[2];
+        float step[2];
+        for (int c = 0; c < 2; ++c) {
+            coeff[c] = coefficient(lfo.value(offsets[c]), sweep);
+        }
+        lfo.advance(rate.load(), numFrames, sampleRate);
+        for (int c = 0; c < 2; ++c) {
+            step[c] = (coefficient(lfo.value(offsets[c]), sweep) - coeff[c]) / static_cast<float>(numFrames);
+        }
+
+        float state[kStages][2];
+        for (int s = 0; s < kStages; ++s) {
+            state[s][0] = stageState[s][0];
+            state[s][1] = stageState[s][1];
+        }
+        float last[2] = {feedbackState[0], feedbackState[1]};
+        for (int i = 0; i < numFrames; ++i) {
+            const float in[2] = {left[i], right[i]};
+            float x[2];
+            for (int c = 0; c < 2; ++c) {
+                x[c] = in[c] + fb * last[c];
+            }
+            for (int s = 0; s < kStages; ++s) {
+                for (int c = 0; c < 2; ++c) {
+                    // First-order allpass, transposed direct form II
+                    const float y = coeff[c] * x[c] + state[s][c];
+                    state[s][c] = x[c] - coeff[c] * y;
+                    x[c] = y;
+                }
+            }
+            for (int c = 0; c < 2; ++c) {
+                last[c] = x[c];
+                coeff[c] += step[c];
+            }
+            left[i] = in[0] * dry + x[0] * wet;
+            right[i] = in[1] * dry + x[1] * wet;
+        }
+        // Keep silent tails out of denormal arithmetic
+        for (int s = 0; s < kStages; ++s) {
+            for (int c = 0; c < 2; ++c) {
+                stageState[s][c] = (std::abs(state[s][c]) < 1e-15f) ? 0.0f : state[s][c];
+            }
+        }
+        for (int c = 0; c < 2; ++c) {
+            feedbackState[c] = (std::abs(last[c]) < 1e-15f) ? 0.0f : last[c];
+        }
+    }
+
+private:
+    /**
+     * Allpass coefficient for an LFO value: the break frequency sweeps
+     * exponentially down from kMaxFrequency by up to the full range.
+     */
+    float coefficient(float lfoValue, float sweep) const {
+        const float octaves = std::log2(kMaxFrequency / kMinFrequency);
+        const float frequency = kMaxFrequency * fastmath::exp2(-octaves * sweep * (0.5f + 0.5f * lfoValue));
+        const float t = std::tan(static_cast<float>(M_PI) * std::min(frequency, 0.45f * static_cast<float>(sampleRate))
+                                 / static_cast<float>(sampleRate));
+        return (t - 1.0f) / (t + 1.0f);
+    }
+
+    int sampleRate;
+    std::atomic<float> rate;
+    std::atomic<float> depth;
+    std::atomic<float> mix;
+    std::atomic<float> feedback;
+
+    BlockLfo lfo;
+    float stageState[kStages][2];
+    float feedbackState[2];
+};
+
+#endif // MODULATION_EFFECTS_H
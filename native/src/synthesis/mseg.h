@@ -0,0 +1,377 @@
+#ifndef MSEG_H
+#define MSEG_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * Multi-segment envelope (MSEG) for use as a modulation source.
+ *
+ * The shape is a list of breakpoints, each with a time, a level and a curve
+ * for the segment leading to it, plus optional loop points. Breakpoints are
+ * compiled on the control thread into a flat array of segments; the audio
+ * thread walks that array one segment at a time, so rendering costs one
+ * multiply-add per sample however many points there are. Each segment is a
+ * one-pole curve (level = level * multiplier + offset), whose coefficients
+ * are worked out when the segment is entered from its length in samples.
+ *
+ * Editing publishes a new compiled shape with a single atomic pointer store,
+ * picked up at the start of the next block; the renderer never locks. A
+ * replaced shape is freed by a later edit, once the audio thread has
+ * finished every block that could still be reading it.
+ *
+ * noteOn()/noteOff() may be called from any thread; they are applied at the
+ * start of the next block.
+ */
+class MultiSegmentEnvelope {
+public:
+    static constexpr int kMaxPoints = 64;
+    static constexpr float kMaxBend = 10.0f; // Curve exponent at curve = +/-1
+
+    enum class LoopMode {
+        Off,     // Play through once
+        Sustain, // Loop while the note is held, then play on from the loop end
+        Repeat   // Loop for as long as the envelope runs (the whole shape without loop points)
+    };
+
+    /**
+     * A breakpoint. Times are absolute, in seconds (or beats when tempo
+     * synced), and must not decrease from one point to the next.
+     */
+    struct Point {
+        float time;
+        float level; // 0.0 - 1.0
+        float curve; // Bend of the segment ending here: 0 = straight, > 0 slow start, < 0 fast start (-1.0 - 1.0)
+    };
+
+    MultiSegmentEnvelope() :
+        sampleRate(44100),
+        loopMode(static_cast<int>(LoopMode::Off)),
+        tempoSync(false),
+        tempo(120.0f),
+        published(nullptr),
+        audioEpoch(0),
+        triggerPending(false),
+        releasePending(false),
+        gate(false),
+        program(nullptr),
+        running(false),
+        segmentIndex(0),
+        remaining(0),
+        level(0.0f),
+        multiplier(1.0f),
+        offset(0.0f),
+        segmentEnd(0.0f) {
+        const Point defaultPoints[] = {
+            {0.0f, 0.0f, 0.0f},
+            {0.25f, 1.0f, -0.5f},
+            {1.0f, 0.0f, -0.5f}
+        };
+        setPoints(defaultPoints, 3, -1, -1);
+        program = published.load();
+        level = program->startLevel;
+    }
+
+    MultiSegmentEnvelope(const MultiSegmentEnvelope&) = delete;
+    MultiSegmentEnvelope& operator=(const MultiSegmentEnvelope&) = delete;
+
+    /**
+     * Set the sample rate. Call before processing starts.
+     *
+     * @param sr The sample rate
+     */
+    void setSampleRate(int sr) {
+        sampleRate = (sr > 0) ? sr : 44100;
+    }
+
+    /**
+     * Compile and publish a new shape (control thread).
+     *
+     * Loop points are point indices; the loop runs from point loopStart to
+     * point loopEnd and is disabled unless loopStart < loopEnd.
+     *
+     * @param points The breakpoints (at most kMaxPoints are used)
+     * @param count The number of points (at least 1)
+     * @param loopStart The point the loop returns to, or -1
+     * @param loopEnd The point at which the loop returns, or -1
+     * @return True on success, false if there are no points
+     */
+    bool setPoints(const Point* points, int count, int loopStart, int loopEnd) {
+        if (!points || count <= 0) {
+            return false;
+        }
+        std::unique_ptr<Program> compiled = compile(points, std::min(count, kMaxPoints), loopStart, loopEnd);
+
+        std::lock_guard<std::mutex> lock(editMutex);
+        collectRetiredLocked();
+        // Sequentially consistent store and epoch read: any block that starts
+        // after the epoch we read is guaranteed to load the new shape.
+        published.store(compiled.get());
+        if (owned) {
+            retired.push_back({std::move(owned), audioEpoch.load()});
+        }
+        owned = std::move(compiled);
+        return true;
+    }
+
+    /**
+     * @param mode The loop mode (0 = off, 1 = sustain, 2 = repeat)
+     */
+    void setLoopMode(int mode) {
+        loopMode.store(std::clamp(mode, 0, 2));
+    }
+
+    /**
+     * Read point times as beats at the current tempo instead of seconds.
+     * Applies from the next segment.
+     *
+     * @param sync True to sync to tempo
+     */
+    void setTempoSync(bool sync) {
+        tempoSync.store(sync);
+    }
+
+    /**
+     * @param bpm The tempo in beats per minute (20 - 999)
+     */
+    void setTempo(float bpm) {
+        tempo.store(std::clamp(bpm, 20.0f, 999.0f));
+    }
+
+    /**
+     * Restart the shape from its first segment, gliding from the current
+     * level, and hold any sustain loop.
+     */
+    void noteOn() {
+        gate.store(true);
+        triggerPending.store(true);
+    }
+
+    /**
+     * Leave the sustain loop.
+     */
+    void noteOff() {
+        gate.store(false);
+        releasePending.store(true);
+    }
+
+    /**
+     * Render a block of envelope values (audio thread).
+     *
+     * When the shape has finished, or before the first note, the output
+     * holds the current level.
+     *
+     * @param output Buffer for numFrames values (0.0 - 1.0)
+     * @param numFrames The number of frames to render
+     */
+    void processBlock(float* output, int numFrames) {
+        const Program* latest = published.load();
+        if (latest != program) {
+            program = latest;
+            running = running && program->count > 0;
+            if (running) {
+                // Head for the new shape from where the old one had got to
+                enterSegment(std::min(segmentIndex, program->count - 1));
+            }
+        }
+        if (triggerPending.exchange(false)) {
+            running = program->count > 0;
+            if (running) {
+                enterSegment(0);
+            } else {
+                level = program->startLevel;
+            }
+        }
+        if (releasePending.exchange(false)) {
+            leaveSustainLoop();
+        }
+
+        int frame = 0;
+        while (frame < numFrames && running) {
+            const int count = std::min(remaining, numFrames - frame);
+            float value = level;
+            for (int i = 0; i < count; ++i) {
+                value = value * multiplier + offset;
+                output[frame + i] = value;
+            }
+            frame += count;
+            remaining -= count;
+            level = value;
+
+            if (remaining == 0) {
+                // Land exactly on the breakpoint, so rounding does not accumulate
+                level = output[frame - 1] = segmentEnd;
+                nextSegment();
+            }
+        }
+        std::fill(output + frame, output + numFrames, level);
+
+        audioEpoch.fetch_add(1);
+    }
+
+    /**
+     * Check if the envelope is running through its shape.
+     *
+     * @return True while running, false before the first note and once finished
+     */
+    bool isActive() const {
+        return running;
+    }
+
+private:
+    /**
+     * A compiled segment, from the previous level to end.
+     */
+    struct Segment {
+        float duration;  // Seconds or beats
+        float end;
+        float bend;      // Curve exponent; 0 = straight
+        float bendScale; // 1 / (e^bend - 1)
+    };
+
+    /**
+     * A compiled shape. Immutable once published.
+     */
+    struct Program {
+        Segment segments[kMaxPoints - 1];
+        int count;
+        float startLevel;
+        int loopStart; // First segment of the loop, or -1
+        int loopEnd;   // Segment after the loop
+    };
+
+    struct RetiredProgram {
+        std::unique_ptr<Program> program;
+        uint64_t epoch;
+    };
+
+    static std::unique_ptr<Program> compile(const Point* points, int count, int loopStart, int loopEnd) {
+        auto compiled = std::make_unique<Program>();
+        compiled->startLevel = std::clamp(points[0].level, 0.0f, 1.0f);
+        compiled->count = count - 1;
+        float previousTime = points[0].time;
+        for (int i = 1; i < count; ++i) {
+            const float time = std::max(points[i].time, previousTime);
+            Segment& segment = compiled->segments[i - 1];
+            segment.duration = time - previousTime;
+            segment.end = std::clamp(points[i].level, 0.0f, 1.0f);
+            segment.bend = std::clamp(points[i].curve, -1.0f, 1.0f) * kMaxBend;
+            segment.bendScale = (std::abs(segment.bend) < 1e-3f) ? 0.0f
+                              : static_cast<float>(1.0 / std::expm1(static_cast<double>(segment.bend)));
+            previousTime = time;
+        }
+        const bool validLoop = loopStart >= 0 && loopStart < loopEnd && loopEnd < count;
+        compiled->loopStart = validLoop ? loopStart : -1;
+        compiled->loopEnd = validLoop ? loopEnd : -1;
+        return compiled;
+    }
+
+    void collectRetiredLocked() {
+        uint64_t epoch = audioEpoch.load();
+        std::vector<RetiredProgram> pending;
+        for (auto& entry : retired) {
+            if (epoch <= entry.epoch) {
+                pending.push_back(std::move(entry));
+            }
+        }
+        retired.swap(pending);
+    }
+
+    /**
+     * Start a segment from the current level.
+     *
+     * A one-pole curve from 0 to 1 with exponent k is (e^(k p) - 1) / (e^k - 1).
+     * Stepping p by 1/length multiplies e^(k p) by r = e^(k/length), which
+     * becomes the multiplier of the recursion.
+     */
+    void enterSegment(int index) {
+        const Segment& segment = program->segments[index];
+        const float secondsPerUnit = tempoSync.load() ? 60.0f / tempo.load() : 1.0f;
+        const int length = std::max(1, static_cast<int>(std::lround(segment.duration * secondsPerUnit
+                                                                    * static_cast<float>(sampleRate))));
+        const double span = static_cast<double>(segment.end) - level;
+        segmentIndex = index;
+        remaining = length;
+        segmentEnd = segment.end;
+        if (segment.bendScale == 0.0f) {
+            multiplier = 1.0f;
+            offset = static_cast<float>(span / length);
+        } else {
+            double rMinusOne = std::expm1(static_cast<double>(segment.bend) / length);
+            multiplier = static_cast<float>(1.0 + rMinusOne);
+            offset = static_cast<float>(-rMinusOne * level + span * rMinusOne * segment.bendScale);
+        }
+    }
+
+    /**
+     * Move on to the next segment, looping back or finishing as the loop
+     * mode and gate say.
+     */
+    void nextSegment() {
+        int next = segmentIndex + 1;
+        const LoopMode mode = static_cast<LoopMode>(loopMode.load());
+        const bool hasLoop = program->loopStart >= 0;
+        if (mode == LoopMode::Repeat && !hasLoop && next >= program->count) {
+            next = 0;
+        } else if (hasLoop && next == program->loopEnd
+                   && (mode == LoopMode::Repeat || (mode == LoopMode::Sustain && gate.load()))) {
+            next = program->loopStart;
+        }
+        if (next >= program->count) {
+            running = false;
+            return;
+        }
+        enterSegment(next);
+    }
+
+    /**
+     * On release in sustain mode, jump from inside the loop to the segment
+     * after it rather than finishing the current pass.
+     */
+    void leaveSustainLoop() {
+        if (!running || static_cast<LoopMode>(loopMode.load()) != LoopMode::Sustain || program->loopStart < 0) {
+            return;
+        }
+        if (segmentIndex >= program->loopStart && segmentIndex < program->loopEnd) {
+            if (program->loopEnd < program->count) {
+                enterSegment(program->loopEnd);
+            } else {
+                running = false;
+            }
+        }
+    }
+
+    int sampleRate;
+    std::atomic<int> loopMode;
+    std::atomic<bool> tempoSync;
+    std::atomic<float> tempo;
+
+    // Shape publishing (control thread, under editMutex)
+    std::atomic<const Program*> published;
+    std::atomic<uint64_t> audioEpoch; // Blocks rendered so far
+    std::mutex editMutex;
+    std::unique_ptr<Program> owned;
+    std::vector<RetiredProgram> retired;
+
+    // Note events, consumed at the start of a block
+    std::atomic<bool> triggerPending;
+    std::atomic<bool> releasePending;
+    std::atomic<bool> gate;
+
+    // Audio thread state
+    const Program* program;
+    bool running;
+    int segmentIndex;
+    int remaining;   // Samples left in the current segment
+    float level;
+    float multiplier;
+    float offset;
+    float segmentEnd;
+};
+
+#endif // MSEG_H
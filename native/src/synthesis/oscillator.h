@@ -3,7 +3,12 @@
 
 #include <cmath>
 #include <vector>
-#include <random>
+#include <algorithm>
+#include <cstdint>
+#include "fast_math.h"
+#include "noise.h"
+#include "minblep.h"
+#include "shaping_tables.h"
 
 /**
  * Base class for oscillator implementations
@@ -17,12 +22,44 @@ public:
         Sawtooth,
         Noise,
         Pulse,
-        Wavetable // For future expansion
+        Wavetable, // For future expansion
+        PinkNoise,
+        BrownNoise,
+        FM,
+        Additive,
+        Vector,
+        PhaseDistortion, // Casio-style phase-warped cosine; shape selects the variant
+        Waveshaper       // Sine through a morphable transfer curve
+    };
+    
+    /**
+     * Phase-distortion variants, in the order the shape control morphs through them.
+     * The resonant variants sweep a cosine under a saw, trapezoid or triangle window.
+     */
+    enum class PDShape {
+        Saw,
+        Square,
+        Pulse,
+        ResonantSaw,
+        ResonantSquare,
+        ResonantPulse,
+        Count
+    };
+    
+    /**
+     * How the discontinuities of the sawtooth, square and pulse waveforms are band-limited.
+     */
+    enum class AntiAliasMode {
+        PolyBLEP, // Polynomial residual evaluated at every sample
+        MinBLEP   // Precomputed minimum-phase residual, mixed in only at discontinuities
     };
 
     Oscillator() : sampleRate(44100), frequency(440.0f), phase(0.0f), phaseIncrement(0.0f),
                   volume(0.5f), detune(0.0f), pan(0.0f), pulseWidth(0.5f),
-                  waveformType(WaveformType::Sine), lastOutput(0.0f) {
+                  waveformType(WaveformType::Sine), lastOutput(0.0f),
+                  antiAliasMode(AntiAliasMode::PolyBLEP), syncRatio(1.0f), syncPhase(0.0f),
+                  pwmDepth(0.0f), pwmRate(1.0f), pwmPhase(0.0f), modulatedPulseWidth(0.5f),
+                  pulseHigh(true), distortion(0.5f), shape(0.0f), dcInput(0.0f), dcOutput(0.0f) {
         updatePhaseIncrement();
     }
     
@@ -34,6 +71,11 @@ public:
      * @return The computed sample value
      */
     virtual float process() {
+        if (usesMinBlep()) {
+            lastOutput = processMinBlep() * volume;
+            return lastOutput;
+        }
+        
         // Calculate base waveform
         float sample = 0.0f;
         
@@ -65,6 +107,34 @@ public:
             case WaveformType::Wavetable:
                 sample = processWavetable();
                 break;
+                
+            case WaveformType::PinkNoise:
+                sample = noise.pink();
+                break;
+                
+            case WaveformType::BrownNoise:
+                sample = noise.brown();
+                break;
+                
+            case WaveformType::FM:
+                sample = processFM();
+                break;
+                
+            case WaveformType::Additive:
+                sample = processAdditive();
+                break;
+                
+            case WaveformType::Vector:
+                sample = processVector();
+                break;
+                
+            case WaveformType::PhaseDistortion:
+                sample = processPhaseDistortion();
+                break;
+                
+            case WaveformType::Waveshaper:
+                sample = processWaveshaper();
+                break;
         }
         
         // Update phase
@@ -78,6 +148,108 @@ public:
         return lastOutput;
     }
     
+    /**
+     * Process a block of mono audio.
+     * 
+     * Noise waveforms are filled a block at a time from the oscillator's own
+     * generator; other waveforms fall back to one process() call per sample.
+     * 
+     * @param output Destination buffer
+     * @param numFrames Number of samples to render
+     */
+    virtual void processBlock(float* output, int numFrames) {
+        if (numFrames <= 0) {
+            return;
+        }
+        if (isNoiseType()) {
+            noise.fill(noiseColor(), output, numFrames);
+            for (int i = 0; i < numFrames; ++i) {
+                output[i] *= volume;
+            }
+            lastOutput = output[numFrames - 1];
+            return;
+        }
+        if (waveformType == WaveformType::PhaseDistortion) {
+            renderPhaseDistortion(output, numFrames);
+            return;
+        }
+        if (waveformType == WaveformType::Waveshaper) {
+            renderWaveshaper(output, numFrames);
+            return;
+        }
+        for (int i = 0; i < numFrames; ++i) {
+            output[i] = process();
+        }
+    }
+    
+    /**
+     * Process a block of stereo audio.
+     * 
+     * Waveforms with a block kernel (see hasBlockKernel()) render the block
+     * in one processBlock() call and are panned with the same law as
+     * processStereo(); others fall back to one processStereo() call per
+     * sample.
+     * 
+     * @param left Destination for the left channel
+     * @param right Destination for the right channel
+     * @param numFrames Number of samples to render
+     */
+    virtual void processStereoBlock(float* left, float* right, int numFrames) {
+        if (!hasBlockKernel()) {
+            for (int i = 0; i < numFrames; ++i) {
+                processStereo(left[i], right[i]);
+            }
+            return;
+        }
+        processBlock(left, numFrames);
+        const float leftGain = std::sqrt(1.0f - pan);
+        const float rightGain = std::sqrt(1.0f + pan);
+        for (int i = 0; i < numFrames; ++i) {
+            right[i] = left[i] * rightGain;
+            left[i] *= leftGain;
+        }
+    }
+    
+    /**
+     * Check whether the current waveform renders a block at a time rather
+     * than through per-sample process() calls.
+     * 
+     * @return True for the phase-distortion and waveshaper types
+     */
+    bool hasBlockKernel() const {
+        return waveformType == WaveformType::PhaseDistortion || waveformType == WaveformType::Waveshaper;
+    }
+    
+    /**
+     * Process one stereo sample of audio.
+     * 
+     * The default implementation renders one mono sample and places it in the
+     * stereo field with an equal-power pan law (unity gain at centre).
+     * 
+     * @param left Receives the left channel sample
+     * @param right Receives the right channel sample
+     */
+    virtual void processStereo(float& left, float& right) {
+        float sample = process();
+        left = sample * std::sqrt(1.0f - pan);
+        right = sample * std::sqrt(1.0f + pan);
+    }
+    
+    /**
+     * Notify the oscillator that a new note starts on it.
+     * 
+     * @param velocity The normalized note velocity (0.0 - 1.0)
+     */
+    virtual void noteOn(float velocity) {
+        (void)velocity;
+    }
+    
+    /**
+     * Notify the oscillator that its note has been released.
+     */
+    virtual void noteOff() {
+    }
+    
     /**
      * Set the sample rate.
      * 
@@ -123,7 +295,7 @@ public:
      * @param p The pan position (-1.0 = left, 0.0 = center, 1.0 = right)
      */
     virtual void setPan(float p) {
-        pan = p;
+        pan = std::clamp(p, -1.0f, 1.0f);
     }
     
     /**
@@ -141,7 +313,90 @@ public:
      * @param width The pulse width (0.0 - 1.0)
      */
     virtual void setPulseWidth(float width) {
-        pulseWidth = width;
+        pulseWidth = std::clamp(width, 0.01f, 0.99f);
+    }
+    
+    /**
+     * Set the distortion amount of the phase-distortion and waveshaper types:
+     * the phase warp (or resonance) of phase distortion, the drive into the
+     * waveshaper's transfer curve.
+     * 
+     * @param amount The amount (0.0 - 1.0)
+     */
+    void setDistortion(float amount) {
+        distortion = std::clamp(amount, 0.0f, 1.0f);
+    }
+    
+    /**
+     * Set the shape of the phase-distortion and waveshaper types. Phase
+     * distortion morphs through the PDShape variants; the waveshaper morphs
+     * through its transfer curves.
+     * 
+     * @param s The shape position (0.0 - 1.0)
+     */
+    void setShape(float s) {
+        shape = std::clamp(s, 0.0f, 1.0f);
+        shaperTable.setMorph(shape);
+    }
+    
+    /**
+     * Set the pulse width modulation depth.
+     * 
+     * @param depth Modulation depth added to the pulse width (0.0 - 0.5)
+     */
+    void setPwmDepth(float depth) {
+        pwmDepth = std::clamp(depth, 0.0f, 0.5f);
+    }
+    
+    /**
+     * Set the pulse width modulation rate; audio rates are allowed.
+     * 
+     * @param hz The modulation frequency in Hz
+     */
+    void setPwmRate(float hz) {
+        pwmRate = std::max(hz, 0.0f);
+    }
+    
+    /**
+     * Set the hard-sync ratio.
+     * 
+     * The audible (slave) waveform runs at ratio times the note frequency and
+     * is reset every time an internal master running at the note frequency
+     * wraps, so the pitch stays at the note while the timbre sweeps with the ratio.
+     * 
+     * @param ratio Slave to master frequency ratio (1.0 = sync off, up to 16.0)
+     */
+    void setSyncRatio(float ratio) {
+        syncRatio = std::clamp(ratio, 1.0f, 16.0f);
+    }
+    
+    /**
+     * Select how waveform discontinuities are band-limited. PolyBLEP, the
+     * default, is the cheaper; MinBLEP aliases far less.
+     * 
+     * Hard sync always uses MinBLEP, since its resets fall between samples
+     * at arbitrary points of the cycle.
+     * 
+     * @param mode The anti-aliasing mode
+     */
+    void setAntiAliasMode(AntiAliasMode mode) {
+        antiAliasMode = mode;
+    }
+    
+    /**
+     * Seed this oscillator's noise generator.
+     * 
+     * @param seed The seed; equal seeds reproduce the same noise sequence
+     */
+    virtual void setNoiseSeed(uint32_t seed) {
+        noise.setSeed(seed);
+    }
+    
+    /**
+     * Restart the noise sequence from its seed.
+     */
+    void resetNoise() {
+        noise.reseed();
     }
     
     /**
@@ -170,17 +425,26 @@ public:
     float getVolume() const {
         return volume;
     }
+    
+    /**
+     * Get the current pan position.
+     * 
+     * @return The pan position (-1.0 = left, 1.0 = right)
+     */
+    float getPan() const {
+        return pan;
+    }
 
 protected:
     // Processing methods for each waveform type
     virtual float processSine() {
-        return std::sin(2.0f * M_PI * phase);
+        return fastmath::sin2pi(phase);
     }
     
     virtual float processSquare() {
         // Anti-aliased square using PolyBLEP
         float value = (phase < 0.5f) ? 1.0f : -1.0f;
-        return value - polyBLEP(phase) + polyBLEP(fmod(phase + 0.5f, 1.0f));
+        return value + polyBLEP(phase) - polyBLEP(fmod(phase + 0.5f, 1.0f));
     }
     
     virtual float processTriangle() {
@@ -196,17 +460,15 @@ protected:
     }
     
     virtual float processNoise() {
-        // White noise generator
-        static std::random_device rd;
-        static std::mt19937 gen(rd());
-        static std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
-        return dist(gen);
+        // White noise from this instance's own generator
+        return noise.white();
     }
     
     virtual float processPulse() {
         // Anti-aliased pulse wave using PolyBLEP
-        float value = (phase < pulseWidth) ? 1.0f : -1.0f;
-        return value - polyBLEP(phase) + polyBLEP(fmod(phase + (1.0f - pulseWidth), 1.0f));
+        float width = advancePulseWidth();
+        float value = (phase < width) ? 1.0f : -1.0f;
+        return value + polyBLEP(phase) - polyBLEP(fmod(phase + (1.0f - width), 1.0f));
     }
     
     virtual float processWavetable() {
@@ -214,6 +476,287 @@ protected:
         return processSine(); // Fallback to sine
     }
     
+    virtual float processFM() {
+        // Default FM implementation (can be overridden)
+        return processSine(); // Fallback to sine
+    }
+    
+    virtual float processAdditive() {
+        // Default additive implementation (can be overridden)
+        return processSine(); // Fallback to sine
+    }
+    
+    virtual float processVector() {
+        // Default vector implementation (can be overridden)
+        return processSine(); // Fallback to sine
+    }
+    
+    float processPhaseDistortion() {
+        float position = shape * static_cast<float>(static_cast<int>(PDShape::Count) - 1);
+        int first = std::min(static_cast<int>(position), static_cast<int>(PDShape::Count) - 2);
+        float blend = position - static_cast<float>(first);
+        float a = phaseDistortionValue(phase, static_cast<PDShape>(first), distortion);
+        if (blend <= 0.0f) {
+            return a;
+        }
+        float b = phaseDistortionValue(phase, static_cast<PDShape>(first + 1), distortion);
+        return a + blend * (b - a);
+    }
+    
+    float processWaveshaper() {
+        const WaveshaperTable::Curve& curve = shaperTable.acquire();
+        float sample = blockDC(WaveshaperTable::shape(curve, waveshaperDrive() * fastmath::sin2pi(phase)));
+        shaperTable.release();
+        return sample;
+    }
+    
+    /**
+     * Phase distortion at a phase: a cosine read through a warped phase
+     * (saw/square/pulse), or a windowed cosine at a resonant multiple of the
+     * fundamental that restarts every cycle (the resonant variants).
+     */
+    static inline float phaseDistortionValue(float p, PDShape variant, float amount) {
+        const float warp = 0.95f * amount;
+        float w = p;
+        switch (variant) {
+            case PDShape::Saw: {
+                // The first half-cycle of the cosine is squeezed into the knee
+                float knee = 0.5f - 0.5f * warp;
+                w = (p < knee) ? 0.5f * p / knee : 0.5f + 0.5f * (p - knee) / (1.0f - knee);
+                return -ShapingTables::cosine(w);
+            }
+            case PDShape::Square: {
+                // Each half-cycle sweeps quickly, then holds at the peak
+                float half = (p < 0.5f) ? 2.0f * p : 2.0f * p - 1.0f;
+                float sweep = std::min(half / (1.0f - warp), 1.0f);
+                w = (p < 0.5f) ? 0.5f * sweep : 0.5f + 0.5f * sweep;
+                return -ShapingTables::cosine(w);
+            }
+            case PDShape::Pulse: {
+                // Holds at the trough, then runs the whole cosine at the end of the
+                // cycle; the hold's offset (-start on average) is removed
+                float start = warp;
+                w = (p < start) ? 0.0f : (p - start) / (1.0f - start);
+                return (start - ShapingTables::cosine(w)) / (1.0f + start);
+            }
+            default:
+                break;
+        }
+        
+        float window;
+        float mean;
+        if (variant == PDShape::ResonantSaw) {
+            window = 1.0f - p;
+            mean = 0.5f;
+        } else if (variant == PDShape::ResonantSquare) {
+            window = (p < 0.5f) ? 1.0f : 2.0f * (1.0f - p); // Trapezoid
+            mean = 0.75f;
+        } else {
+            window = 1.0f - std::abs(2.0f * p - 1.0f); // Triangle
+            mean = 0.5f;
+        }
+        float resonance = p * (1.0f + 15.0f * amount);
+        float carrier = 1.0f - ShapingTables::cosine(resonance - std::floor(resonance));
+        return (window * carrier - mean) / (2.0f - mean);
+    }
+    
+    float waveshaperDrive() const {
+        return 0.25f + 0.75f * distortion;
+    }
+    
+    /**
+     * One-pole DC blocker for the waveshaper: even-order curves driven
+     * below full scale leave an offset.
+     */
+    inline float blockDC(float x) {
+        float y = x - dcInput + 0.995f * dcOutput;
+        dcInput = x;
+        dcOutput = y;
+        return y;
+    }
+    
+    void renderPhaseDistortion(float* output, int numFrames) {
+        // The variant pair and blend are fixed for the block
+        const float position = shape * static_cast<float>(static_cast<int>(PDShape::Count) - 1);
+        const int first = std::min(static_cast<int>(position), static_cast<int>(PDShape::Count) - 2);
+        const float blend = position - static_cast<float>(first);
+        const PDShape a = static_cast<PDShape>(first);
+        const PDShape b = static_cast<PDShape>(first + 1);
+        const float amount = distortion;
+        float p = phase;
+        for (int i = 0; i < numFrames; ++i) {
+            float value = phaseDistortionValue(p, a, amount);
+            if (blend > 0.0f) {
+                value += blend * (phaseDistortionValue(p, b, amount) - value);
+            }
+            output[i] = value * volume;
+            p += phaseIncrement;
+            p -= (p >= 1.0f) ? 1.0f : 0.0f;
+        }
+        phase = p;
+        lastOutput = output[numFrames - 1];
+    }
+    
+    void renderWaveshaper(float* output, int numFrames) {
+        const float drive = waveshaperDrive();
+        float p = phase;
+        for (int i = 0; i < numFrames; ++i) {
+            output[i] = drive * fastmath::sin2pi(p);
+            p += phaseIncrement;
+            p -= (p >= 1.0f) ? 1.0f : 0.0f;
+        }
+        phase = p;
+        const WaveshaperTable::Curve& curve = shaperTable.acquire();
+        for (int i = 0; i < numFrames; ++i) {
+            output[i] = blockDC(WaveshaperTable::shape(curve, output[i])) * volume;
+        }
+        shaperTable.release();
+        lastOutput = output[numFrames - 1];
+    }
+    
+    bool syncEnabled() const {
+        return syncRatio > 1.0f;
+    }
+    
+    bool usesMinBlep() const {
+        switch (waveformType) {
+            case WaveformType::Square:
+            case WaveformType::Sawtooth:
+            case WaveformType::Pulse:
+                return antiAliasMode == AntiAliasMode::MinBLEP || syncEnabled();
+            case WaveformType::Sine:
+            case WaveformType::Triangle:
+                return syncEnabled();
+            default:
+                return false;
+        }
+    }
+    
+    /**
+     * Advance the PWM LFO by one sample and return the current pulse width.
+     */
+    float advancePulseWidth() {
+        if (pwmDepth <= 0.0f) {
+            modulatedPulseWidth = pulseWidth;
+            return modulatedPulseWidth;
+        }
+        pwmPhase += pwmRate / static_cast<float>(sampleRate);
+        pwmPhase -= std::floor(pwmPhase);
+        modulatedPulseWidth = std::clamp(pulseWidth + pwmDepth * fastmath::sin2pi(pwmPhase), 0.02f, 0.98f);
+        return modulatedPulseWidth;
+    }
+    
+    /**
+     * Naive (aliased) value of the current waveform at a phase. Square and
+     * pulse use the tracked pulse state so the value always agrees with the
+     * edges that have been corrected.
+     */
+    float naiveValue(float p) const {
+        switch (waveformType) {
+            case WaveformType::Sawtooth:
+                return 2.0f * p - 1.0f;
+            case WaveformType::Square:
+            case WaveformType::Pulse:
+                return pulseHigh ? 1.0f : -1.0f;
+            case WaveformType::Triangle: {
+                float saw = 2.0f * (p - std::floor(p + 0.5f));
+                return 2.0f * (std::abs(saw) - 0.5f);
+            }
+            case WaveformType::Sine:
+            default:
+                return fastmath::sin2pi(p);
+        }
+    }
+    
+    /**
+     * Advance the waveform phase by 'span' samples and schedule MinBLEP
+     * corrections for the edges crossed. 'lateness' is the time from the end
+     * of the span to the next output sample.
+     */
+    void advanceWithEdges(float increment, float span, float lateness, float width) {
+        if (increment <= 0.0f) {
+            return;
+        }
+        const float invIncrement = 1.0f / increment;
+        const bool isPulse = waveformType == WaveformType::Square || waveformType == WaveformType::Pulse;
+        float p = phase + increment * span;
+        
+        if (isPulse && pulseHigh && p >= width) {
+            // The width can move under PWM; an edge already passed fires at the start of the span
+            float since = std::clamp((p - width) * invIncrement, 0.0f, span) + lateness;
+            minBlep.addStep(-2.0f, since);
+            pulseHigh = false;
+        }
+        if (p >= 1.0f) {
+            p -= std::floor(p);
+            float since = p * invIncrement + lateness;
+            if (waveformType == WaveformType::Sawtooth) {
+                minBlep.addStep(-2.0f, since);
+            } else if (isPulse) {
+                if (!pulseHigh) {
+                    minBlep.addStep(2.0f, since);
+                    pulseHigh = true;
+                }
+                if (p >= width) {
+                    minBlep.addStep(-2.0f, (p - width) * invIncrement + lateness);
+                    pulseHigh = false;
+                }
+            }
+        }
+        phase = p;
+    }
+    
+    /**
+     * Render one sample of the sawtooth, square or pulse waveform (and of any
+     * basic waveform under hard sync) with MinBLEP-corrected discontinuities.
+     */
+    float processMinBlep() {
+        float width = 0.5f;
+        if (waveformType == WaveformType::Pulse) {
+            width = advancePulseWidth();
+        }
+        float sample = minBlep.process(naiveValue(phase));
+        
+        if (!syncEnabled()) {
+            advanceWithEdges(phaseIncrement, 1.0f, 0.0f, width);
+            return sample;
+        }
+        
+        const float slaveIncrement = phaseIncrement * syncRatio;
+        syncPhase += phaseIncrement;
+        if (syncPhase < 1.0f || phaseIncrement <= 0.0f) {
+            advanceWithEdges(slaveIncrement, 1.0f, 0.0f, width);
+            return sample;
+        }
+        
+        // Master wrapped during this sample: run the slave up to the reset,
+        // reset it with a corrected step, then run it for the remainder.
+        syncPhase -= std::floor(syncPhase);
+        float afterReset = std::min(syncPhase / phaseIncrement, 1.0f);
+        advanceWithEdges(slaveIncrement, 1.0f - afterReset, afterReset, width);
+        float before = naiveValue(phase);
+        phase = 0.0f;
+        pulseHigh = true;
+        float jump = naiveValue(0.0f) - before;
+        if (jump != 0.0f) {
+            minBlep.addStep(jump, afterReset);
+        }
+        advanceWithEdges(slaveIncrement, afterReset, 0.0f, width);
+        return sample;
+    }
+    
+    bool isNoiseType() const {
+        return waveformType == WaveformType::Noise
+            || waveformType == WaveformType::PinkNoise
+            || waveformType == WaveformType::BrownNoise;
+    }
+    
+    NoiseGenerator::Color noiseColor() const {
+        if (waveformType == WaveformType::PinkNoise) return NoiseGenerator::Color::Pink;
+        if (waveformType == WaveformType::BrownNoise) return NoiseGenerator::Color::Brown;
+        return NoiseGenerator::Color::White;
+    }
+    
     // PolyBLEP implementation for anti-aliasing
     float polyBLEP(float t) {
         float dt = phaseIncrement;
@@ -235,8 +778,8 @@ protected:
     }
     
     void updatePhaseIncrement() {
-        // Apply detune in cents to frequency
-        float detuneMultiplier = std::pow(2.0f, detune / 1200.0f);
+        // Apply detune in cents to frequency (runs on every setFrequency, i.e. per sample under pitch bend)
+        float detuneMultiplier = fastmath::centsToRatio(detune);
         float detuneFreq = frequency * detuneMultiplier;
         
         // Calculate phase increment per sample
@@ -253,6 +796,25 @@ protected:
     float pulseWidth;
     WaveformType waveformType;
     float lastOutput;
+    NoiseGenerator noise;
+    
+    // Band-limited edges, hard sync and PWM
+    AntiAliasMode antiAliasMode;
+    float syncRatio;
+    float syncPhase;
+    float pwmDepth;
+    float pwmRate;
+    float pwmPhase;
+    float modulatedPulseWidth;
+    bool pulseHigh;
+    MinBlepBuffer minBlep;
+    
+    // Phase distortion / waveshaper state
+    float distortion;
+    float shape;
+    WaveshaperTable shaperTable;
+    float dcInput;
+    float dcOutput;
 };
 
 #endif // OSCILLATOR_H
\ No newline at end of file
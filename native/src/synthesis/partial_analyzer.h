@@ -0,0 +1,191 @@
+#ifndef PARTIAL_ANALYZER_H
+#define PARTIAL_ANALYZER_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "additive_voice.h"
+#include "kiss_fftr.h"
+
+/**
+ * Converts a stretch of recorded audio into a PartialSet for AdditiveVoice.
+ *
+ * One Blackman-Harris windowed frame around the requested position is
+ * transformed with kissfft, the fundamental is estimated with a harmonic
+ * comb over the magnitude spectrum, and each harmonic's peak is refined with
+ * parabolic interpolation. Ratios keep the measured (possibly inharmonic)
+ * partial frequencies relative to the fundamental. Allocates; call it from a
+ * UI or worker thread, never from the audio callback.
+ */
+class PartialAnalyzer {
+public:
+    static constexpr int kFFTSize = 8192;
+    static constexpr float kMinFundamental = 40.0f;
+    static constexpr float kMaxFundamental = 2000.0f;
+
+    /**
+     * Analyze samples into a partial set.
+     *
+     * @param samples The mono source audio
+     * @param numSamples The number of samples
+     * @param sampleRate The source sample rate
+     * @param position Centre of the analysis frame (0.0 - 1.0 of the buffer)
+     * @param maxPartials Maximum number of partials to extract
+     * @param fundamental Receives the detected fundamental in Hz (may be null)
+     * @return The partial set, normalized to a peak amplitude of 1.0; empty if nothing was found
+     */
+    static PartialSet analyze(const float* samples, size_t numSamples, int sampleRate, float position,
+                              int maxPartials, float* fundamental = nullptr) {
+        PartialSet result;
+        if (fundamental) {
+            *fundamental = 0.0f;
+        }
+        if (!samples || numSamples == 0 || sampleRate <= 0 || maxPartials <= 0) {
+            return result;
+        }
+
+        // Windowed frame centred on the requested position, zero-padded at the edges
+        std::vector<kiss_fft_scalar> frame(kFFTSize, 0.0f);
+        const double twoPi = 2.0 * 3.14159265358979323846;
+        long centre = static_cast<long>(std::clamp(position, 0.0f, 1.0f) * static_cast<float>(numSamples - 1));
+        long start = centre - kFFTSize / 2;
+        double windowSum = 0.0;
+        for (int n = 0; n < kFFTSize; ++n) {
+            double m = twoPi * n / kFFTSize;
+            double w = 0.35875 - 0.48829 * std::cos(m) + 0.14128 * std::cos(2.0 * m) - 0.01168 * std::cos(3.0 * m);
+            windowSum += w;
+            long index = start + n;
+            if (index >= 0 && index < static_cast<long>(numSamples)) {
+                frame[n] = static_cast<kiss_fft_scalar>(samples[index] * w);
+            }
+        }
+
+        std::vector<kiss_fft_cpx> bins(kFFTSize / 2 + 1);
+        kiss_fftr_cfg plan = kiss_fftr_alloc(kFFTSize, 0, nullptr, nullptr);
+        if (!plan) {
+            return result;
+        }
+        kiss_fftr(plan, frame.data(), bins.data());
+        kiss_fftr_free(plan);
+
+        std::vector<float> magnitude(bins.size());
+        float peak = 0.0f;
+        for (size_t k = 0; k < bins.size(); ++k) {
+            magnitude[k] = std::sqrt(bins[k].r * bins[k].r + bins[k].i * bins[k].i);
+            peak = std::max(peak, magnitude[k]);
+        }
+        if (peak <= 0.0f) {
+            return result;
+        }
+
+        const float binHz = static_cast<float>(sampleRate) / static_cast<float>(kFFTSize);
+        float f0 = estimateFundamental(magnitude, binHz, static_cast<float>(sampleRate));
+        if (f0 <= 0.0f) {
+            return result;
+        }
+
+        // Measure each harmonic: strongest bin within +/-40% of f0 around h * f0. The f0
+        // estimate is refined from the harmonics measured so far so the search windows
+        // stay centred on high harmonics.
+        const float floor = peak * 1e-4f; // -80 dB
+        const float amplitudeScale = static_cast<float>(2.0 / windowSum);
+        float weightedFrequency = 0.0f;
+        float weightedHarmonic = 0.0f;
+        std::vector<float> frequencies;
+        for (int h = 1; h <= maxPartials; ++h) {
+            float target = f0 * static_cast<float>(h);
+            if (target >= 0.5f * static_cast<float>(sampleRate) - binHz) {
+                break;
+            }
+            int lo = std::max(1, static_cast<int>((target - 0.4f * f0) / binHz));
+            int hi = std::min(static_cast<int>(magnitude.size()) - 2, static_cast<int>((target + 0.4f * f0) / binHz) + 1);
+            int best = lo;
+            for (int k = lo; k <= hi; ++k) {
+                if (magnitude[k] > magnitude[best]) best = k;
+            }
+
+            float amplitude = 0.0f;
+            float frequency = target;
+            if (magnitude[best] > floor && best > 0) {
+                float offset = 0.0f;
+                float refined = interpolatePeak(magnitude, best, offset);
+                frequency = (static_cast<float>(best) + offset) * binHz;
+                amplitude = refined * amplitudeScale;
+                weightedFrequency += frequency * amplitude;
+                weightedHarmonic += static_cast<float>(h) * amplitude;
+                f0 = weightedFrequency / weightedHarmonic;
+            }
+            result.amplitudes.push_back(amplitude);
+            frequencies.push_back(frequency);
+        }
+
+        if (result.amplitudes.empty()) {
+            return result;
+        }
+
+        // Express partials as ratios of the refined fundamental
+        float maxAmplitude = *std::max_element(result.amplitudes.begin(), result.amplitudes.end());
+        result.ratios.resize(result.amplitudes.size());
+        for (size_t i = 0; i < result.amplitudes.size(); ++i) {
+            result.ratios[i] = frequencies[i] / f0;
+            if (maxAmplitude > 0.0f) {
+                result.amplitudes[i] /= maxAmplitude;
+            }
+        }
+        if (fundamental) {
+            *fundamental = f0;
+        }
+        return result;
+    }
+
+private:
+    /**
+     * Parabolic interpolation on log magnitude around a peak bin.
+     *
+     * @param offset Receives the fractional bin offset (-0.5 - 0.5)
+     * @return The interpolated peak magnitude
+     */
+    static float interpolatePeak(const std::vector<float>& magnitude, int k, float& offset) {
+        float a = std::log(std::max(magnitude[k - 1], 1e-12f));
+        float b = std::log(std::max(magnitude[k], 1e-12f));
+        float c = std::log(std::max(magnitude[k + 1], 1e-12f));
+        float denom = a - 2.0f * b + c;
+        offset = (denom < 0.0f) ? std::clamp(0.5f * (a - c) / denom, -0.5f, 0.5f) : 0.0f;
+        return std::exp(b - 0.25f * (a - c) * offset);
+    }
+
+    static float magnitudeAt(const std::vector<float>& magnitude, float bin) {
+        int k = static_cast<int>(bin + 0.5f);
+        if (k < 1 || k + 1 >= static_cast<int>(magnitude.size())) return 0.0f;
+        return std::max(magnitude[k], std::max(magnitude[k - 1], magnitude[k + 1]));
+    }
+
+    /**
+     * Harmonic comb: reward energy at h * f0 and penalize energy halfway
+     * between harmonics, which rejects octave-up candidates. Candidates are
+     * scanned from high to low and only a clearly better score replaces the
+     * current one, which rejects octave-down candidates.
+     */
+    static float estimateFundamental(const std::vector<float>& magnitude, float binHz, float sampleRate) {
+        const int harmonics = 16;
+        const float nyquist = 0.5f * sampleRate;
+        float bestScore = 0.0f;
+        float best = 0.0f;
+        const float step = std::pow(2.0f, 1.0f / 96.0f); // 1/8 semitone
+        for (float f0 = std::min(kMaxFundamental, nyquist * 0.25f); f0 >= kMinFundamental; f0 /= step) {
+            float score = 0.0f;
+            for (int h = 1; h <= harmonics; ++h) {
+                float f = f0 * static_cast<float>(h);
+                if (f >= nyquist) break;
+                score += magnitudeAt(magnitude, f / binHz) - magnitudeAt(magnitude, (f - 0.5f * f0) / binHz);
+            }
+            if (score > bestScore * 1.01f) {
+                bestScore = score;
+                best = f0;
+            }
+        }
+        return best;
+    }
+};
+
+#endif // PARTIAL_ANALYZER_H
@@ -1,195 +1,341 @@
 #ifndef REVERB_H
 #define REVERB_H
 
-#include "delay.h"
-#include <memory>
-#include <array>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <vector>
 
 /**
- * A simple reverb effect using a feedback delay network.
+ * Stereo reverb built on an eight-line feedback delay network.
+ *
+ * All delay lines live in one contiguous arena, each sized to its own
+ * length at the current sample rate (a prime number of samples, so the
+ * echoes of different lines rarely coincide) plus room for modulation.
+ * Line outputs are mixed back into the inputs through a scaled Hadamard
+ * matrix, applied as a fast Walsh-Hadamard transform (24 additions rather
+ * than a 64-term matrix multiply).
+ *
+ * Each line has its own lowpass for damping and a feedback gain matched to
+ * its length, so every line decays at the same rate and the room size sets
+ * the decay time directly. The read taps are slowly modulated, with a
+ * different rate per line, to break up metallic ringing. Left and right
+ * outputs are taken from the lines with orthogonal sign patterns, so they
+ * come out decorrelated.
+ *
+ * Settings are written from the control thread and picked up once per
+ * block.
  */
 class Reverb {
 public:
-    Reverb() : sampleRate(44100), roomSize(0.5f), damping(0.5f), mix(0.2f) {
-        // Create a network of delays with different times
-        static const float delayTimes[8] = {
-            0.0297f, 0.0371f, 0.0411f, 0.0437f,
-            0.0533f, 0.0653f, 0.0747f, 0.0863f
-        };
-        
-        // Initialize delay lines
-        for (int i = 0; i < 8; ++i) {
-            delays[i] = std::make_unique<Delay>();
-            delays[i]->setTime(delayTimes[i]);
-            delays[i]->setMix(1.0f); // Full wet signal for the network
-            delays[i]->setFeedback(0.0f); // No internal feedback in the delays
-        }
-        
-        // Apply room size and damping
-        updateParameters();
-    }
-    
-    ~Reverb() = default;
-    
-    /**
-     * Process one sample through the reverb.
-     * 
-     * @param input The input sample
-     * @return The processed output sample
-     */
-    float process(float input) {
-        // Apply input diffusion by spreading the signal across all delay lines
-        for (int i = 0; i < 8; ++i) {
-            diffusionBuffer[i] = input * 0.125f; // Distribute energy evenly
-        }
-        
-        // Process through the feedback delay network
-        for (int i = 0; i < 4; ++i) {
-            // Process the first half of delay lines
-            float delayOut1 = delays[i]->process(diffusionBuffer[i]);
-            
-            // Process the second half of delay lines
-            float delayOut2 = delays[i + 4]->process(diffusionBuffer[i + 4]);
-            
-            // Feedback from one delay to others
-            feedbackBuffer[i] = delayOut1;
-            feedbackBuffer[i + 4] = delayOut2;
-        }
-        
-        // Apply the feedback matrix between all delay lines
-        for (int i = 0; i < 8; ++i) {
-            diffusionBuffer[i] = 0.0f;
-            for (int j = 0; j < 8; ++j) {
-                // Hadamard feedback matrix
-                float feedback = (i & j) ? -feedbackMatrix[i][j] : feedbackMatrix[i][j];
-                diffusionBuffer[i] += feedbackBuffer[j] * feedback;
-            }
-        }
-        
-        // Combine all outputs
-        float wetOutput = 0.0f;
-        for (int i = 0; i < 8; ++i) {
-            wetOutput += feedbackBuffer[i] * 0.125f;
-        }
-        
-        // Apply low-pass filtering to simulate air absorption
-        wetOutput = lpFilter(wetOutput);
-        
-        // Mix dry and wet signals
-        return input * (1.0f - mix) + wetOutput * mix;
+    static constexpr int kLines = 8;
+    static constexpr float kModulationDepth = 0.0003f; // Seconds, peak tap excursion
+    static constexpr int kClearChunk = 16384;          // Samples zeroed per clearPart() call
+
+    Reverb() : sampleRate(0), appliedRoomSize(-1.0f), appliedDamping(-1.0f), clearPosition(0), dampingCoeff(0.0f) {
+        roomSize.store(0.5f);
+        damping.store(0.5f);
+        mix.store(0.2f);
+        setSampleRate(44100);
     }
-    
+
     /**
-     * Set the sample rate.
-     * 
+     * Set the sample rate and size the delay arena for it. Not realtime
+     * safe; call before processing starts.
+     *
      * @param sr The new sample rate
      */
     void setSampleRate(int sr) {
+        sr = (sr > 0) ? sr : 44100;
+        if (sr == sampleRate) {
+            return;
+        }
         sampleRate = sr;
-        for (auto& delay : delays) {
-            if (delay) {
-                delay->setSampleRate(sr);
-            }
+
+        // Line lengths from 30 to 86 ms, as mutually prime sample counts
+        static const float lineTimes[kLines] = {
+            0.0297f, 0.0371f, 0.0411f, 0.0437f,
+            0.0533f, 0.0653f, 0.0747f, 0.0863f
+        };
+        static const float modulationRates[kLines] = {
+            0.31f, 0.37f, 0.43f, 0.53f, 0.61f, 0.71f, 0.79f, 0.89f
+        };
+        const float modulationSamples = kModulationDepth * static_cast<float>(sr);
+        int offset = 0;
+        for (int i = 0; i < kLines; ++i) {
+            lineDelay[i] = static_cast<float>(nextPrime(static_cast<int>(lineTimes[i] * static_cast<float>(sr))));
+            lineStart[i] = offset;
+            lineSize[i] = static_cast<int>(lineDelay[i] + modulationSamples) + 2;
+            offset += lineSize[i];
+            writePosition[i] = 0;
+            modulationDepth[i] = modulationSamples;
+            const float angle = 2.0f * static_cast<float>(M_PI) * modulationRates[i] / static_cast<float>(sr);
+            rotationCos[i] = std::cos(angle);
+            rotationSin[i] = std::sin(angle);
         }
+        arena.assign(static_cast<size_t>(offset), 0.0f);
+        appliedRoomSize = appliedDamping = -1.0f;
+        clear();
     }
-    
+
     /**
      * Set the room size.
-     * 
-     * @param size The room size (0.0 - 1.0)
+     *
+     * @param size The room size (0.0 - 1.0), from about 0.4 s to 8 s of decay
      */
     void setRoomSize(float size) {
-        roomSize = std::clamp(size, 0.1f, 0.9f);
-        updateParameters();
+        roomSize.store(std::clamp(size, 0.1f, 0.9f));
     }
-    
+
     /**
      * Set the damping amount.
-     * 
+     *
      * @param damp The damping amount (0.0 - 1.0)
      */
     void setDamping(float damp) {
-        damping = std::clamp(damp, 0.0f, 1.0f);
-        updateParameters();
+        damping.store(std::clamp(damp, 0.0f, 1.0f));
     }
-    
+
     /**
      * Set the wet/dry mix.
-     * 
+     *
      * @param m The mix amount (0.0 = dry, 1.0 = wet)
      */
     void setMix(float m) {
-        mix = std::clamp(m, 0.0f, 1.0f);
+        mix.store(std::clamp(m, 0.0f, 1.0f));
     }
-    
+
     /**
      * Clear the reverb state.
      */
     void clear() {
-        for (auto& delay : delays) {
-            if (delay) {
-                delay->clear();
+        std::fill(arena.begin(), arena.end(), 0.0f);
+        clearPosition = 0;
+        resetState();
+    }
+
+    /**
+     * Clear the next kClearChunk samples of the delay arena, so that a clear
+     * on the audio thread is spread over several blocks. Call once per
+     * block, without processing in between, until it returns true.
+     *
+     * @return True once the whole arena is clear and the state reset
+     */
+    bool clearPart() {
+        const size_t end = std::min(arena.size(), clearPosition + kClearChunk);
+        std::fill(arena.begin() + static_cast<std::ptrdiff_t>(clearPosition),
+                  arena.begin() + static_cast<std::ptrdiff_t>(end), 0.0f);
+        clearPosition = end;
+        if (clearPosition < arena.size()) {
+            return false;
+        }
+        clearPosition = 0;
+        resetState();
+        return true;
+    }
+
+    /**
+     * Process a block of stereo audio in place.
+     *
+     * @param left Left channel samples
+     * @param right Right channel samples
+     * @param numFrames The number of frames
+     */
+    void processBlock(float* left, float* right, int numFrames) {
+        updateParameters();
+        const float wet = mix.load();
+        const float dry = 1.0f - wet;
+        const float damp = dampingCoeff;
+        float* lines = arena.data();
+
+        // Input and output sign patterns: two orthogonal Hadamard rows per side
+        static const float inputLeft[kLines] = {1, 0, 1, 0, 1, 0, 1, 0};
+        static const float inputRight[kLines] = {0, 1, 0, -1, 0, 1, 0, -1};
+        static const float outputLeft[kLines] = {1, 1, 1, 1, -1, -1, -1, -1};
+        static const float outputRight[kLines] = {1, -1, 1, -1, 1, -1, 1, -1};
+        const float inputScale = 0.5f;
+        const float outputScale = 1.0f / kLines;
+
+        // Work on local copies so the state stays in registers: stores into
+        // the arena could otherwise alias the member arrays
+        float low[kLines], gain[kLines], delay[kLines], depth[kLines];
+        float sine[kLines], cosine[kLines], rotSin[kLines], rotCos[kLines];
+        int write[kLines], start[kLines], size[kLines];
+        for (int i = 0; i < kLines; ++i) {
+            low[i] = lowpassState[i];
+            gain[i] = lineGain[i];
+            delay[i] = lineDelay[i];
+            depth[i] = modulationDepth[i];
+            sine[i] = modulationSin[i];
+            cosine[i] = modulationCos[i];
+            rotSin[i] = rotationSin[i];
+            rotCos[i] = rotationCos[i];
+            write[i] = writePosition[i];
+            start[i] = lineStart[i];
+            size[i] = lineSize[i];
+        }
+
+        for (int n = 0; n < numFrames; ++n) {
+            float outputs[kLines];
+            float feedback[kLines];
+            for (int i = 0; i < kLines; ++i) {
+                // Advance the tap modulation (a rotating phasor per line)
+                const float s = sine[i];
+                const float c = cosine[i];
+                sine[i] = s * rotCos[i] + c * rotSin[i];
+                cosine[i] = c * rotCos[i] - s * rotSin[i];
+
+                // Read delay samples behind the write position, with linear interpolation
+                const float tap = delay[i] + depth[i] * s;
+                const int whole = static_cast<int>(tap);
+                const float fraction = tap - static_cast<float>(whole);
+                int newer = write[i] - whole;
+                newer += (newer < 0) ? size[i] : 0;
+                int older = newer - 1;
+                older += (older < 0) ? size[i] : 0;
+                const float a = lines[start[i] + newer];
+                const float b = lines[start[i] + older];
+                outputs[i] = a + fraction * (b - a);
+
+                low[i] = outputs[i] + damp * (low[i] - outputs[i]);
+                feedback[i] = low[i] * gain[i];
             }
+
+            mixHadamard(feedback);
+
+            const float inLeft = left[n];
+            const float inRight = right[n];
+            float wetLeft = 0.0f;
+            float wetRight = 0.0f;
+            for (int i = 0; i < kLines; ++i) {
+                lines[start[i] + write[i]] = feedback[i] + inputScale * (inputLeft[i] * inLeft + inputRight[i] * inRight);
+                write[i] = (write[i] + 1 == size[i]) ? 0 : write[i] + 1;
+                wetLeft += outputs[i] * outputLeft[i];
+                wetRight += outputs[i] * outputRight[i];
+            }
+
+            left[n] = inLeft * dry + wetLeft * outputScale * wet;
+            right[n] = inRight * dry + wetRight * outputScale * wet;
         }
-        
-        for (int i = 0; i < 8; ++i) {
-            diffusionBuffer[i] = 0.0f;
-            feedbackBuffer[i] = 0.0f;
+
+        for (int i = 0; i < kLines; ++i) {
+            // Keep silent tails out of denormal arithmetic
+            lowpassState[i] = (std::abs(low[i]) < 1e-15f) ? 0.0f : low[i];
+            // Keep the modulation phasors on the unit circle
+            const float norm = 1.0f / std::sqrt(sine[i] * sine[i] + cosine[i] * cosine[i]);
+            modulationSin[i] = sine[i] * norm;
+            modulationCos[i] = cosine[i] * norm;
+            writePosition[i] = write[i];
         }
-        
-        lpFilterState = 0.0f;
     }
-    
+
 private:
     /**
-     * Update internal parameters based on room size and damping.
+     * Put the damping filters at rest and the modulation phases back at
+     * their starting points, spread evenly around the circle.
+     */
+    void resetState() {
+        static const float startSin[kLines] = {
+            0.0f, 0.70710678f, 1.0f, 0.70710678f, 0.0f, -0.70710678f, -1.0f, -0.70710678f
+        };
+        static const float startCos[kLines] = {
+            1.0f, 0.70710678f, 0.0f, -0.70710678f, -1.0f, -0.70710678f, 0.0f, 0.70710678f
+        };
+        for (int i = 0; i < kLines; ++i) {
+            lowpassState[i] = 0.0f;
+            modulationSin[i] = startSin[i];
+            modulationCos[i] = startCos[i];
+        }
+    }
+
+    /**
+     * Recompute the line gains and damping after a settings change.
      */
     void updateParameters() {
-        // Update feedback gain based on room size
-        float feedbackGain = 0.7f + roomSize * 0.29f;
-        
-        // Update feedback matrix with the gain
-        for (int i = 0; i < 8; ++i) {
-            for (int j = 0; j < 8; ++j) {
-                feedbackMatrix[i][j] = (i == j) ? 0.0f : feedbackGain / 7.0f;
-            }
+        const float size = roomSize.load();
+        const float damp = damping.load();
+        if (size == appliedRoomSize && damp == appliedDamping) {
+            return;
+        }
+        appliedRoomSize = size;
+        appliedDamping = damp;
+
+        // Each line loses 60 dB over the decay time, whatever its length
+        const float decayTime = 0.3f * std::pow(40.0f, size);
+        for (int i = 0; i < kLines; ++i) {
+            lineGain[i] = std::pow(10.0f, -3.0f * lineDelay[i] / (decayTime * static_cast<float>(sampleRate)));
         }
-        
-        // Update damping (low-pass filter cutoff)
+
         // Map damping 0-1 to cutoff range 10000-2000 Hz (higher damping = lower cutoff)
-        float cutoff = 10000.0f - (damping * 8000.0f);
-        lpCoeff = std::exp(-2.0f * M_PI * cutoff / sampleRate);
+        const float cutoff = 10000.0f - (damp * 8000.0f);
+        dampingCoeff = std::exp(-2.0f * static_cast<float>(M_PI) * cutoff / static_cast<float>(sampleRate));
     }
-    
+
     /**
-     * Apply a simple one-pole low-pass filter.
-     * 
-     * @param input The input sample
-     * @return The filtered output sample
+     * Multiply by the 8x8 Hadamard matrix scaled to be orthogonal, in place.
      */
-    float lpFilter(float input) {
-        lpFilterState = (lpFilterState * lpCoeff) + (input * (1.0f - lpCoeff));
-        return lpFilterState;
+    static inline void mixHadamard(float* v) {
+        for (int span = 1; span < kLines; span <<= 1) {
+            for (int i = 0; i < kLines; i += span << 1) {
+                for (int j = i; j < i + span; ++j) {
+                    const float a = v[j];
+                    const float b = v[j + span];
+                    v[j] = a + b;
+                    v[j + span] = a - b;
+                }
+            }
+        }
+        const float scale = 0.35355339059327373f; // 1 / sqrt(8)
+        for (int i = 0; i < kLines; ++i) {
+            v[i] *= scale;
+        }
+    }
+
+    static int nextPrime(int n) {
+        n = std::max(n, 2);
+        for (;; ++n) {
+            bool prime = true;
+            for (int d = 2; d * d <= n; ++d) {
+                if (n % d == 0) {
+                    prime = false;
+                    break;
+                }
+            }
+            if (prime) {
+                return n;
+            }
+        }
     }
-    
+
     int sampleRate;
-    float roomSize;
-    float damping;
-    float mix;
-    
-    // Delay network
-    std::array<std::unique_ptr<Delay>, 8> delays;
-    
-    // Buffers for the feedback delay network
-    float diffusionBuffer[8] = {0.0f};
-    float feedbackBuffer[8] = {0.0f};
-    
-    // Feedback matrix
-    float feedbackMatrix[8][8] = {0.0f};
-    
-    // Low-pass filter for damping
-    float lpCoeff = 0.0f;
-    float lpFilterState = 0.0f;
+
+    // Settings (control thread)
+    std::atomic<float> roomSize;
+    std::atomic<float> damping;
+    std::atomic<float> mix;
+    float appliedRoomSize;
+    float appliedDamping;
+
+    // Delay arena: line i occupies lineSize[i] floats from lineStart[i]
+    std::vector<float> arena;
+    int lineStart[kLines];
+    int lineSize[kLines];
+    int writePosition[kLines];
+    size_t clearPosition;    // Samples cleared so far by clearPart()
+    float lineDelay[kLines]; // Samples, before modulation
+
+    // Per-line feedback
+    float lineGain[kLines];
+    float dampingCoeff;
+    float lowpassState[kLines];
+
+    // Tap modulation
+    float modulationDepth[kLines]; // Samples
+    float modulationSin[kLines];
+    float modulationCos[kLines];
+    float rotationSin[kLines];
+    float rotationCos[kLines];
 };
 
-#endif // REVERB_H
\ No newline at end of file
+#endif // REVERB_H
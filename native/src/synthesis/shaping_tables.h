@@ -0,0 +1,212 @@
+#ifndef SHAPING_TABLES_H
+#define SHAPING_TABLES_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * Shared lookup tables for the phase-distortion and waveshaper oscillators.
+ *
+ * Built once, on first use (call prepare() from a non-realtime thread to
+ * avoid doing it in the audio callback). Every lookup is a linear
+ * interpolation into a table with a guard point, so there are no wrap or
+ * bounds branches on the audio path.
+ */
+class ShapingTables {
+public:
+    static constexpr int kCosineSize = 2048;   // Points per cycle
+    static constexpr int kTransferSize = 1024; // Points over [-1, 1]
+    static constexpr int kTransferCount = 8;   // Morph positions of the waveshaper
+
+    /**
+     * cos(2 * pi * phase) for a phase in [0, 1].
+     */
+    static inline float cosine(float phase) {
+        const float* table = instance().cosineTable;
+        float position = phase * static_cast<float>(kCosineSize);
+        int index = std::clamp(static_cast<int>(position), 0, kCosineSize - 1);
+        float fraction = position - static_cast<float>(index);
+        return table[index] + fraction * (table[index + 1] - table[index]);
+    }
+
+    /**
+     * One of the waveshaper transfer curves: kTransferSize + 1 points over [-1, 1].
+     *
+     * 0 is the identity (a clean sine); higher positions are increasingly
+     * bright Chebyshev sums, ending with a hard-driven tanh clipper. Curves
+     * are normalized to a peak of 1.0.
+     */
+    static const float* transfer(int index) {
+        return instance().transferTables[std::clamp(index, 0, kTransferCount - 1)];
+    }
+
+    static void prepare() {
+        instance();
+    }
+
+private:
+    ShapingTables() {
+        const double twoPi = 2.0 * 3.14159265358979323846;
+        for (int i = 0; i <= kCosineSize; ++i) {
+            cosineTable[i] = static_cast<float>(std::cos(twoPi * i / kCosineSize));
+        }
+
+        // Chebyshev weights per morph position: T_n(sin) adds the n-th harmonic
+        static const float weights[kTransferCount - 1][8] = {
+            {1.0f},                                                // Clean
+            {1.0f, 0.5f},                                          // + 2nd
+            {1.0f, 0.0f, 0.5f},                                    // + 3rd
+            {1.0f, 0.5f, 0.33f, 0.25f},                            // Low harmonics
+            {1.0f, 0.0f, 0.33f, 0.0f, 0.2f, 0.0f, 0.14f},          // Odd series (hollow, square-like)
+            {1.0f, 0.5f, 0.33f, 0.25f, 0.2f, 0.17f, 0.14f, 0.125f}, // Full series (saw-like)
+            {0.3f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.8f, 0.6f},      // Bright, upper harmonics only
+        };
+        for (int t = 0; t < kTransferCount; ++t) {
+            float peak = 0.0f;
+            for (int i = 0; i <= kTransferSize; ++i) {
+                double x = -1.0 + 2.0 * i / kTransferSize;
+                double y = 0.0;
+                if (t == kTransferCount - 1) {
+                    y = std::tanh(4.0 * x);
+                } else {
+                    // Chebyshev recurrence: T0 = 1, T1 = x, Tn+1 = 2x Tn - Tn-1
+                    double previous = 1.0;
+                    double current = x;
+                    for (int n = 0; n < 8; ++n) {
+                        y += weights[t][n] * current;
+                        double next = 2.0 * x * current - previous;
+                        previous = current;
+                        current = next;
+                    }
+                }
+                transferTables[t][i] = static_cast<float>(y);
+                peak = std::max(peak, static_cast<float>(std::abs(y)));
+            }
+            for (float& value : transferTables[t]) {
+                value /= (peak > 0.0f) ? peak : 1.0f;
+            }
+        }
+    }
+
+    static const ShapingTables& instance() {
+        static const ShapingTables tables;
+        return tables;
+    }
+
+    float cosineTable[kCosineSize + 1];
+    float transferTables[kTransferCount][kTransferSize + 1];
+};
+
+/**
+ * A waveshaper transfer curve blended from two neighbouring ShapingTables
+ * curves. Rebuilt only when the morph position changes, so the per-sample
+ * cost is a single table lookup.
+ *
+ * setMorph() builds the new curve off to the side and publishes it with a
+ * single atomic pointer store. The renderer takes the current curve with
+ * acquire() at the start of a block and hands it back with release() at the
+ * end, so a block never sees a half-built curve. A replaced curve is freed
+ * by a later setMorph(), once every block that could still be reading it
+ * has finished.
+ */
+class WaveshaperTable {
+public:
+    struct Curve {
+        float values[ShapingTables::kTransferSize + 1];
+    };
+
+    WaveshaperTable() : morph(-1.0f), published(nullptr), audioEpoch(0) {
+        setMorph(0.0f);
+    }
+
+    WaveshaperTable(const WaveshaperTable&) = delete;
+    WaveshaperTable& operator=(const WaveshaperTable&) = delete;
+
+    /**
+     * Build and publish a new curve (control thread).
+     *
+     * @param m Morph position across the transfer curves (0.0 - 1.0)
+     */
+    void setMorph(float m) {
+        m = std::clamp(m, 0.0f, 1.0f);
+        std::lock_guard<std::mutex> lock(editMutex);
+        if (m == morph) {
+            return;
+        }
+        morph = m;
+        auto curve = std::make_unique<Curve>();
+        float position = m * static_cast<float>(ShapingTables::kTransferCount - 1);
+        int index = std::min(static_cast<int>(position), ShapingTables::kTransferCount - 2);
+        float fraction = position - static_cast<float>(index);
+        const float* a = ShapingTables::transfer(index);
+        const float* b = ShapingTables::transfer(index + 1);
+        for (int i = 0; i <= ShapingTables::kTransferSize; ++i) {
+            curve->values[i] = a[i] + fraction * (b[i] - a[i]);
+        }
+
+        collectRetiredLocked();
+        // Sequentially consistent store and epoch read: any block that starts
+        // after the epoch we read is guaranteed to load the new curve.
+        published.store(curve.get());
+        if (owned) {
+            retired.push_back({std::move(owned), audioEpoch.load()});
+        }
+        owned = std::move(curve);
+    }
+
+    /**
+     * Take the current curve for a block (audio thread). Pair with release().
+     */
+    const Curve& acquire() const {
+        return *published.load();
+    }
+
+    /**
+     * Finish with the curve taken by acquire() (audio thread).
+     */
+    void release() {
+        audioEpoch.fetch_add(1);
+    }
+
+    /**
+     * Shape an input in [-1, 1].
+     */
+    static inline float shape(const Curve& curve, float x) {
+        const float* values = curve.values;
+        float position = (x + 1.0f) * (0.5f * static_cast<float>(ShapingTables::kTransferSize));
+        int index = std::clamp(static_cast<int>(position), 0, ShapingTables::kTransferSize - 1);
+        float fraction = position - static_cast<float>(index);
+        return values[index] + fraction * (values[index + 1] - values[index]);
+    }
+
+private:
+    struct RetiredCurve {
+        std::unique_ptr<Curve> curve;
+        uint64_t epoch;
+    };
+
+    void collectRetiredLocked() {
+        uint64_t epoch = audioEpoch.load();
+        std::vector<RetiredCurve> pending;
+        for (auto& entry : retired) {
+            if (epoch <= entry.epoch) {
+                pending.push_back(std::move(entry));
+            }
+        }
+        retired.swap(pending);
+    }
+
+    float morph; // Under editMutex
+    std::atomic<const Curve*> published;
+    std::atomic<uint64_t> audioEpoch; // Blocks finished by the renderer
+    std::mutex editMutex;
+    std::unique_ptr<Curve> owned;
+    std::vector<RetiredCurve> retired;
+};
+
+#endif // SHAPING_TABLES_H
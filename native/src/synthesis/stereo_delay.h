@@ -0,0 +1,266 @@
+#ifndef STEREO_DELAY_H
+#define STEREO_DELAY_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Stereo delay with independent left/right times, cross-feedback and
+ * ping-pong.
+ *
+ * Both channels share one interleaved ring buffer (frame-major, left then
+ * right) whose length is a power of two, so positions wrap with a mask
+ * rather than a modulo. Delay times glide towards their targets, which
+ * bends the pitch of the repeats like a tape delay instead of clicking.
+ * The repeats pass through a one-pole lowpass on their way back in.
+ *
+ * Settings are written from the control thread and read once per block.
+ */
+class StereoDelay {
+public:
+    static constexpr float kMaxDelayTime = 2.0f; // Seconds
+    static constexpr float kMinDelayTime = 0.01f;
+    static constexpr float kGlideTime = 0.05f;   // Seconds, time constant of delay time changes
+    static constexpr int kClearChunk = 16384;    // Samples zeroed per clearPart() call
+
+    StereoDelay() : sampleRate(0), mask(0), writeIndex(0), glideCoeff(0.0f), clearPosition(0) {
+        timeLeft.store(0.5f);
+        timeRight.store(0.5f);
+        feedback.store(0.3f);
+        crossFeedback.store(0.0f);
+        pingPong.store(false);
+        mix.store(0.5f);
+        lowpassCutoff.store(10000.0f);
+        setSampleRate(44100);
+    }
+
+    /**
+     * Set the sample rate and size the buffer for it. Not realtime safe;
+     * call before processing starts.
+     *
+     * @param sr The sample rate
+     */
+    void setSampleRate(int sr) {
+        sr = (sr > 0) ? sr : 44100;
+        if (sr == sampleRate) {
+            return;
+        }
+        sampleRate = sr;
+        int frames = 1;
+        while (frames < static_cast<int>(kMaxDelayTime * static_cast<float>(sr)) + 2) {
+            frames <<= 1;
+        }
+        buffer.assign(static_cast<size_t>(frames) * 2, 0.0f);
+        mask = frames - 1;
+        writeIndex = 0;
+        glideCoeff = 1.0f - std::exp(-1.0f / (kGlideTime * static_cast<float>(sr)));
+        clear();
+    }
+
+    /**
+     * Set both delay times.
+     *
+     * @param time The delay time in seconds
+     */
+    void setTime(float time) {
+        setTimeLeft(time);
+        setTimeRight(time);
+    }
+
+    /**
+     * @param time The left delay time in seconds
+     */
+    void setTimeLeft(float time) {
+        timeLeft.store(std::clamp(time, kMinDelayTime, kMaxDelayTime));
+    }
+
+    /**
+     * @param time The right delay time in seconds
+     */
+    void setTimeRight(float time) {
+        timeRight.store(std::clamp(time, kMinDelayTime, kMaxDelayTime));
+    }
+
+    /**
+     * Set the feedback amount.
+     *
+     * @param fb The feedback amount (0.0 - 0.99)
+     */
+    void setFeedback(float fb) {
+        feedback.store(std::clamp(fb, 0.0f, 0.99f)); // Limit to prevent infinite feedback
+    }
+
+    /**
+     * Set how much of each channel's repeats feed the other channel.
+     *
+     * @param amount 0.0 = each channel feeds itself, 1.0 = each feeds the other
+     */
+    void setCrossFeedback(float amount) {
+        crossFeedback.store(std::clamp(amount, 0.0f, 1.0f));
+    }
+
+    /**
+     * Ping-pong: the input (summed to mono) enters on the left only and the
+     * repeats alternate sides. Overrides the cross-feedback amount.
+     *
+     * @param enabled True for ping-pong
+     */
+    void setPingPong(bool enabled) {
+        pingPong.store(enabled);
+    }
+
+    /**
+     * Set the wet/dry mix.
+     *
+     * @param m The mix amount (0.0 = dry, 1.0 = wet)
+     */
+    void setMix(float m) {
+        mix.store(std::clamp(m, 0.0f, 1.0f));
+    }
+
+    /**
+     * Set the lowpass filter cutoff frequency for the feedback path.
+     *
+     * @param cutoff The cutoff frequency in Hz
+     */
+    void setLowpassCutoff(float cutoff) {
+        lowpassCutoff.store(std::clamp(cutoff, 20.0f, 20000.0f));
+    }
+
+    /**
+     * Clear the delay buffer and jump to the current delay times.
+     */
+    void clear() {
+        std::fill(buffer.begin(), buffer.end(), 0.0f);
+        clearPosition = 0;
+        resetState();
+    }
+
+    /**
+     * Clear the next kClearChunk samples of the buffer, so that a clear on
+     * the audio thread is spread over several blocks. Call once per block,
+     * without processing in between, until it returns true.
+     *
+     * @return True once the whole buffer is clear and the state reset
+     */
+    bool clearPart() {
+        const size_t end = std::min(buffer.size(), clearPosition + kClearChunk);
+        std::fill(buffer.begin() + static_cast<std::ptrdiff_t>(clearPosition),
+                  buffer.begin() + static_cast<std::ptrdiff_t>(end), 0.0f);
+        clearPosition = end;
+        if (clearPosition < buffer.size()) {
+            return false;
+        }
+        clearPosition = 0;
+        resetState();
+        return true;
+    }
+
+    /**
+     * Process a block of stereo audio in place.
+     *
+     * @param left Left channel samples
+     * @param right Right channel samples
+     * @param numFrames The number of frames
+     */
+    void processBlock(float* left, float* right, int numFrames) {
+        const float sr = static_cast<float>(sampleRate);
+        const float targetLeft = timeLeft.load() * sr;
+        const float targetRight = timeRight.load() * sr;
+        const float fb = feedback.load();
+        const bool alternate = pingPong.load();
+        const float cross = alternate ? 1.0f : crossFeedback.load();
+        const float wet = mix.load();
+        const float dry = 1.0f - wet;
+        const float damping = std::exp(-2.0f * static_cast<float>(M_PI) * lowpassCutoff.load() / sr);
+
+        // Input routing: straight through, or a mono sum into the left side
+        const float leftFromLeft = alternate ? 0.5f : 1.0f;
+        const float leftFromRight = alternate ? 0.5f : 0.0f;
+        const float rightFromRight = alternate ? 0.0f : 1.0f;
+
+        float* ring = buffer.data();
+        const int wrap = mask;
+        const float glide = glideCoeff;
+        float delayLeft = delaySamples[0];
+        float delayRight = delaySamples[1];
+        float lowLeft = lowpassState[0];
+        float lowRight = lowpassState[1];
+        int write = writeIndex;
+
+        for (int i = 0; i < numFrames; ++i) {
+            delayLeft += (targetLeft - delayLeft) * glide;
+            delayRight += (targetRight - delayRight) * glide;
+            const float delayedLeft = read(ring, write, wrap, delayLeft, 0);
+            const float delayedRight = read(ring, write, wrap, delayRight, 1);
+
+            lowLeft = delayedLeft + damping * (lowLeft - delayedLeft);
+            lowRight = delayedRight + damping * (lowRight - delayedRight);
+            const float returnLeft = lowLeft + cross * (lowRight - lowLeft);
+            const float returnRight = lowRight + cross * (lowLeft - lowRight);
+
+            const float inLeft = left[i];
+            const float inRight = right[i];
+            ring[2 * write] = inLeft * leftFromLeft + inRight * leftFromRight + fb * returnLeft;
+            ring[2 * write + 1] = inRight * rightFromRight + fb * returnRight;
+            write = (write + 1) & wrap;
+
+            left[i] = inLeft * dry + delayedLeft * wet;
+            right[i] = inRight * dry + delayedRight * wet;
+        }
+
+        delaySamples[0] = delayLeft;
+        delaySamples[1] = delayRight;
+        // Keep silent tails out of denormal arithmetic
+        lowpassState[0] = (std::abs(lowLeft) < 1e-15f) ? 0.0f : lowLeft;
+        lowpassState[1] = (std::abs(lowRight) < 1e-15f) ? 0.0f : lowRight;
+        writeIndex = write;
+    }
+
+private:
+    /**
+     * Jump to the current delay times with the feedback filters at rest.
+     */
+    void resetState() {
+        delaySamples[0] = timeLeft.load() * static_cast<float>(sampleRate);
+        delaySamples[1] = timeRight.load() * static_cast<float>(sampleRate);
+        lowpassState[0] = lowpassState[1] = 0.0f;
+    }
+
+    /**
+     * Read one channel delaySamples (at least 1) behind the write position,
+     * with linear interpolation.
+     */
+    static inline float read(const float* ring, int write, int wrap, float delay, int channel) {
+        const int whole = static_cast<int>(delay);
+        const float fraction = delay - static_cast<float>(whole);
+        const float newer = ring[2 * ((write - whole) & wrap) + channel];
+        const float older = ring[2 * ((write - whole - 1) & wrap) + channel];
+        return newer + fraction * (older - newer);
+    }
+
+    int sampleRate;
+    int mask;       // Frames in the buffer - 1
+    int writeIndex; // Frame
+    float glideCoeff;
+    std::vector<float> buffer; // Interleaved left/right frames
+    size_t clearPosition;      // Samples cleared so far by clearPart()
+
+    // Settings (control thread)
+    std::atomic<float> timeLeft;
+    std::atomic<float> timeRight;
+    std::atomic<float> feedback;
+    std::atomic<float> crossFeedback;
+    std::atomic<bool> pingPong;
+    std::atomic<float> mix;
+    std::atomic<float> lowpassCutoff;
+
+    // Per-channel state (audio thread)
+    float delaySamples[2]; // Current, gliding delay times
+    float lowpassState[2];
+};
+
+#endif // STEREO_DELAY_H
@@ -0,0 +1,384 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+/**
+ * Musical clock: tempo, time signature and a play position counted in
+ * samples, for tempo-synced effects and modulators.
+ *
+ * Positions in beats (quarter notes) are never accumulated block by block.
+ * Each is worked out from a sample count and an anchor: the beat and sample
+ * at the last tempo change or relocation. So, however long the transport
+ * runs, a synced phase is exact to the sample and does not drift.
+ *
+ * Two positions are kept. The song position advances only while playing
+ * and can be relocated. The running position advances all the time. It
+ * follows the song position while playing, so synced modulators lock to
+ * the song, and it keeps them moving while stopped.
+ *
+ * External sync follows MIDI clock: Start, Continue, Stop and Song Position
+ * Pointer control playback, which waits for the first clock pulse after
+ * Start or Song Position; the tempo is estimated from the spacing of the
+ * clock pulses; and the position is pulled gently towards the pulse count,
+ * so that jitter in pulse delivery does not reach the audio.
+ *
+ * Control methods may be called from any thread and are picked up at the
+ * start of the next block. beginBlock(), endBlock() and the block queries
+ * belong to the audio thread.
+ */
+class Transport {
+public:
+    static constexpr int kPulsesPerQuarter = 24; // MIDI clock resolution
+    static constexpr int kDivisions = 17;        // Musical divisions, including 0 = off
+
+    Transport() :
+        sampleRate(44100),
+        pendingLocate(false),
+        pendingLocateBeat(0.0),
+        pulseCount(0),
+        pulseBase(0.0),
+        pulseInterval(0.0),
+        blockTempo(120.0),
+        blockPlaying(false),
+        songSample(0),
+        songAnchorSample(0),
+        songAnchorBeat(0.0),
+        runSample(0),
+        runAnchorSample(0),
+        runAnchorBeat(0.0) {
+        tempo.store(120.0f);
+        numerator.store(4);
+        denominator.store(4);
+        playing.store(false);
+        externalSync.store(false);
+        externalTempo.store(120.0f);
+        publishedBeat.store(0.0);
+    }
+
+    /**
+     * Length of a musical division in quarter notes.
+     *
+     * Divisions: 1 = 4 bars, 2 = 2 bars, 3 = 1 bar (of 4/4), 4 = 1/2, 5 = 1/4,
+     * 6 = 1/8, 7 = 1/16, 8 = 1/32, 9 - 12 = dotted 1/2 - 1/16,
+     * 13 - 16 = triplet 1/2 - 1/16.
+     *
+     * @param division The division index
+     * @return Its length in beats, or 0.0 for 0 (off) and unknown indices
+     */
+    static double divisionBeats(int division) {
+        static const double beats[kDivisions] = {
+            0.0,
+            16.0, 8.0, 4.0, 2.0, 1.0, 0.5, 0.25, 0.125,
+            3.0, 1.5, 0.75, 0.375,
+            4.0 / 3.0, 2.0 / 3.0, 1.0 / 3.0, 1.0 / 6.0
+        };
+        return (division > 0 && division < kDivisions) ? beats[division] : 0.0;
+    }
+
+    /**
+     * @param sr The sample rate
+     */
+    void setSampleRate(int sr) {
+        sampleRate = (sr > 0) ? sr : 44100;
+    }
+
+    /**
+     * Set the tempo used without external sync.
+     *
+     * @param bpm The tempo in beats per minute (20 - 999)
+     */
+    void setTempo(float bpm) {
+        tempo.store(std::clamp(bpm, 20.0f, 999.0f));
+    }
+
+    /**
+     * @param beatsPerBar The numerator (1 - 32)
+     * @param beatUnit The denominator (1, 2, 4, 8, 16 or 32)
+     */
+    void setTimeSignature(int beatsPerBar, int beatUnit) {
+        numerator.store(std::clamp(beatsPerBar, 1, 32));
+        int unit = 1;
+        while (unit < beatUnit && unit < 32) {
+            unit <<= 1;
+        }
+        denominator.store(unit);
+    }
+
+    /**
+     * Start or stop playback from the current position.
+     */
+    void setPlaying(bool play) {
+        playing.store(play);
+    }
+
+    /**
+     * Move the song position.
+     *
+     * @param beat The new position in quarter notes
+     */
+    void locate(double beat) {
+        pendingLocateBeat.store(std::max(0.0, beat));
+        pendingLocate.store(true);
+    }
+
+    /**
+     * Follow MIDI clock instead of the internal tempo and play state.
+     *
+     * @param enabled True to slave to incoming MIDI clock
+     */
+    void setExternalSync(bool enabled) {
+        externalSync.store(enabled);
+    }
+
+    /**
+     * Handle a MIDI system message (MIDI thread). Ignored unless external
+     * sync is on.
+     *
+     * @param status 0xF8 clock, 0xFA start, 0xFB continue, 0xFC stop or 0xF2 song position
+     * @param data1 Song position LSB
+     * @param data2 Song position MSB
+     * @return True if the message is a transport message
+     */
+    bool handleMidiMessage(unsigned char status, unsigned char data1, unsigned char data2) {
+        if (status != 0xF8 && status != 0xFA && status != 0xFB && status != 0xFC && status != 0xF2) {
+            return false;
+        }
+        if (!externalSync.load()) {
+            return true;
+        }
+        switch (status) {
+            case 0xF8: {
+                const auto now = std::chrono::steady_clock::now();
+                const double interval = std::chrono::duration<double>(now - lastPulseTime).count();
+                lastPulseTime = now;
+                // Ignore the gap before the first pulse and after a pause
+                if (interval > 0.0 && interval < 0.25) {
+                    pulseInterval = (pulseInterval > 0.0) ? pulseInterval + 0.1 * (interval - pulseInterval) : interval;
+                    externalTempo.store(std::clamp(static_cast<float>(60.0 / (pulseInterval * kPulsesPerQuarter)), 20.0f, 999.0f));
+                }
+                pulseCount.fetch_add(1);
+                break;
+            }
+            case 0xFA: // Start: from the top, beat 0 on the next pulse
+                pulseBase.store(0.0);
+                pulseCount.store(0);
+                locate(0.0);
+                playing.store(true);
+                break;
+            case 0xFB: // Continue
+                playing.store(true);
+                break;
+            case 0xFC: // Stop
+                playing.store(false);
+                break;
+            case 0xF2: { // Song position pointer, in sixteenth notes
+                const double beat = static_cast<double>(data1 | (data2 << 7)) / 4.0;
+                pulseBase.store(beat);
+                pulseCount.store(0);
+                locate(beat);
+                break;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Pick up control changes for the coming block (audio thread).
+     */
+    void beginBlock() {
+        const bool external = externalSync.load();
+        const double newTempo = external ? externalTempo.load() : tempo.load();
+        if (newTempo != blockTempo) {
+            // Re-anchor both positions, so beats before the change keep their samples
+            songAnchorBeat = songBeatAt(songSample);
+            songAnchorSample = songSample;
+            runAnchorBeat = runBeatAt(runSample);
+            runAnchorSample = runSample;
+            blockTempo = newTempo;
+        }
+
+        const bool wasPlaying = blockPlaying;
+        // Under external sync the song starts with the first clock after
+        // Start or Song Position, not with the message itself
+        blockPlaying = playing.load() && !(external && pulseCount.load() == 0);
+        if (pendingLocate.exchange(false)) {
+            setSongBeat(pendingLocateBeat.load());
+        }
+        if (blockPlaying && !wasPlaying) {
+            // Bring the running position onto the song
+            runAnchorBeat = songBeatAt(songSample);
+            runAnchorSample = runSample;
+        }
+
+        if (external && blockPlaying) {
+            followPulses();
+        }
+    }
+
+    /**
+     * Advance past a processed block (audio thread).
+     *
+     * @param numFrames The number of frames processed
+     */
+    void endBlock(int numFrames) {
+        if (blockPlaying) {
+            songSample += numFrames;
+        }
+        runSample += numFrames;
+        publishedBeat.store(songBeatAt(songSample), std::memory_order_relaxed);
+    }
+
+    // --- Block queries (audio thread) ---
+
+    double getTempo() const {
+        return blockTempo;
+    }
+
+    bool isPlaying() const {
+        return blockPlaying;
+    }
+
+    /**
+     * @return The song position at the start of the block, in samples
+     */
+    int64_t getSamplePosition() const {
+        return songSample;
+    }
+
+    /**
+     * @param frameOffset Frames into the block
+     * @return The song position, in quarter notes
+     */
+    double getBeat(int frameOffset = 0) const {
+        return songBeatAt(songSample + (blockPlaying ? frameOffset : 0));
+    }
+
+    /**
+     * Phase within a musical division of the running position, for synced
+     * LFOs and repeats.
+     *
+     * @param division The division index (see divisionBeats)
+     * @param frameOffset Frames into the block
+     * @return The phase in cycles (0.0 - 1.0), or 0.0 for no division
+     */
+    double getPhase(int division, int frameOffset = 0) const {
+        const double length = divisionBeats(division);
+        if (length <= 0.0) {
+            return 0.0;
+        }
+        const double cycles = runBeatAt(runSample + frameOffset) / length;
+        return cycles - std::floor(cycles);
+    }
+
+    /**
+     * @param division The division index (see divisionBeats)
+     * @return The division's length in seconds at the block tempo, or 0.0 for no division
+     */
+    double getDivisionSeconds(int division) const {
+        return divisionBeats(division) * 60.0 / blockTempo;
+    }
+
+    /**
+     * @return Quarter notes per bar of the current time signature
+     */
+    double getBeatsPerBar() const {
+        return numerator.load() * 4.0 / denominator.load();
+    }
+
+    // --- Any thread ---
+
+    /**
+     * @return The song position at the end of the last block, in quarter notes
+     */
+    double getPublishedBeat() const {
+        return publishedBeat.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @return The tempo in effect: the internal tempo, or the MIDI clock estimate under external sync
+     */
+    float getCurrentTempo() const {
+        return externalSync.load() ? externalTempo.load() : tempo.load();
+    }
+
+private:
+    double samplesPerBeat() const {
+        return 60.0 * sampleRate / blockTempo;
+    }
+
+    double songBeatAt(int64_t sample) const {
+        return songAnchorBeat + static_cast<double>(sample - songAnchorSample) / samplesPerBeat();
+    }
+
+    double runBeatAt(int64_t sample) const {
+        return runAnchorBeat + static_cast<double>(sample - runAnchorSample) / samplesPerBeat();
+    }
+
+    void setSongBeat(double beat) {
+        songAnchorBeat = beat;
+        songAnchorSample = songSample;
+        runAnchorBeat = beat;
+        runAnchorSample = runSample;
+    }
+
+    /**
+     * Steer the song position towards the MIDI clock. Between pulses the
+     * true position lies up to one pulse past the last one counted; outside
+     * that window a tenth of the error is corrected each block, and errors
+     * of a beat or more are jumped.
+     */
+    void followPulses() {
+        const int64_t pulses = pulseCount.load();
+        if (pulses == 0) {
+            return;
+        }
+        const double pulseBeat = pulseBase.load() + static_cast<double>(pulses - 1) / kPulsesPerQuarter;
+        const double beat = songBeatAt(songSample);
+        double error = 0.0;
+        if (beat < pulseBeat) {
+            error = pulseBeat - beat;
+        } else if (beat > pulseBeat + 1.0 / kPulsesPerQuarter) {
+            error = pulseBeat + 1.0 / kPulsesPerQuarter - beat;
+        }
+        if (error == 0.0) {
+            return;
+        }
+        setSongBeat((std::abs(error) >= 1.0) ? pulseBeat : beat + 0.1 * error);
+    }
+
+    int sampleRate;
+
+    // Settings (control and MIDI threads)
+    std::atomic<float> tempo;
+    std::atomic<int> numerator;
+    std::atomic<int> denominator;
+    std::atomic<bool> playing;
+    std::atomic<bool> externalSync;
+    std::atomic<bool> pendingLocate;
+    std::atomic<double> pendingLocateBeat;
+    std::atomic<double> publishedBeat;
+
+    // MIDI clock (MIDI thread, except the atomics)
+    std::atomic<int64_t> pulseCount;       // Pulses since Start or Song Position
+    std::atomic<double> pulseBase;         // Beat of the first of those pulses
+    std::atomic<float> externalTempo;
+    std::chrono::steady_clock::time_point lastPulseTime;
+    double pulseInterval;                  // Smoothed seconds between pulses
+
+    // Audio thread
+    double blockTempo;
+    bool blockPlaying;
+    int64_t songSample;                    // Samples played
+    int64_t songAnchorSample;
+    double songAnchorBeat;
+    int64_t runSample;                     // Samples elapsed, playing or not
+    int64_t runAnchorSample;
+    double runAnchorBeat;
+};
+
+#endif // TRANSPORT_H
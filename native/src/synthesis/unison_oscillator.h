@@ -0,0 +1,339 @@
+#ifndef UNISON_OSCILLATOR_H
+#define UNISON_OSCILLATOR_H
+
+#include "wavetable/wavetable_oscillator_impl.h"
+#include <cmath>
+#include <random>
+#include <algorithm>
+
+/**
+ * Unison ("supersaw") oscillator.
+ *
+ * Stacks up to kMaxVoices detuned copies of the selected waveform and spreads
+ * them across the stereo field. The copies are stored as structure-of-arrays
+ * lanes and rendered in groups of kLaneGroup, so each group compiles to a
+ * handful of vector instructions per sample instead of one scalar oscillator
+ * per copy. With a single unison voice the oscillator behaves exactly like
+ * WavetableOscillatorImpl.
+ */
+class UnisonOscillator : public synth::WavetableOscillatorImpl {
+public:
+    static constexpr int kMaxVoices = 16;
+    static constexpr int kLaneGroup = 8;
+
+    UnisonOscillator() : synth::WavetableOscillatorImpl(),
+        unisonVoices(1), activeLanes(kLaneGroup), detuneSpread(0.0f),
+        stereoSpread(0.0f), phaseRandomization(1.0f),
+        randomEngine(noise.getSeed()), randomDist(0.0f, 1.0f),
+        mipTable(nullptr), mipIncrement(0.0f), mipLevel(0) {
+        for (int i = 0; i < kMaxVoices; ++i) {
+            lanePhase[i] = 0.0f;
+            laneIncrement[i] = 0.0f;
+            laneInvIncrement[i] = 0.0f;
+            laneRatio[i] = 1.0f;
+            laneInvRatio[i] = 1.0f;
+            laneGainLeft[i] = 0.0f;
+            laneGainRight[i] = 0.0f;
+        }
+        updateLaneRatios();
+        updateLaneGains();
+    }
+
+    /**
+     * Set the number of stacked unison copies.
+     *
+     * @param voices The number of copies (1 - kMaxVoices)
+     */
+    void setUnisonVoices(int voices) {
+        unisonVoices = std::clamp(voices, 1, kMaxVoices);
+        activeLanes = ((unisonVoices + kLaneGroup - 1) / kLaneGroup) * kLaneGroup;
+        updateLaneRatios();
+        updateLaneGains();
+    }
+
+    /**
+     * Set the detune spread.
+     *
+     * @param cents Detune of the outermost copies in cents (0.0 - 100.0)
+     */
+    void setUnisonDetune(float cents) {
+        detuneSpread = std::clamp(cents, 0.0f, 100.0f);
+        updateLaneRatios();
+    }
+
+    /**
+     * Set the stereo spread of the unison copies.
+     *
+     * @param spread The spread amount (0.0 = mono, 1.0 = full width)
+     */
+    void setStereoSpread(float spread) {
+        stereoSpread = std::clamp(spread, 0.0f, 1.0f);
+        updateLaneGains();
+    }
+
+    /**
+     * Set how much the copies' start phases are randomized on note-on.
+     *
+     * @param amount The randomization amount (0.0 = all in phase, 1.0 = fully random)
+     */
+    void setPhaseRandomization(float amount) {
+        phaseRandomization = std::clamp(amount, 0.0f, 1.0f);
+    }
+
+    int getUnisonVoices() const {
+        return unisonVoices;
+    }
+
+    void setSampleRate(int sr) override {
+        synth::WavetableOscillatorImpl::setSampleRate(sr);
+        updateLaneIncrements();
+    }
+
+    void setFrequency(float freq) override {
+        synth::WavetableOscillatorImpl::setFrequency(freq);
+        updateLaneIncrements();
+    }
+
+    void setDetune(float det) override {
+        synth::WavetableOscillatorImpl::setDetune(det);
+        updateLaneIncrements();
+    }
+
+    void setPan(float p) override {
+        synth::WavetableOscillatorImpl::setPan(p);
+        updateLaneGains();
+    }
+
+    /**
+     * Seed the noise generator and the unison start phases.
+     *
+     * @param seed The seed; equal seeds reproduce the same sequences
+     */
+    void setNoiseSeed(uint32_t seed) override {
+        synth::WavetableOscillatorImpl::setNoiseSeed(seed);
+        randomEngine.seed(seed);
+    }
+
+    void noteOn(float velocity) override {
+        synth::WavetableOscillatorImpl::noteOn(velocity);
+        for (int i = 0; i < kMaxVoices; ++i) {
+            lanePhase[i] = phaseRandomization * randomDist(randomEngine);
+        }
+    }
+
+    float process() override {
+        if (!usesLanes()) {
+            return synth::WavetableOscillatorImpl::process();
+        }
+        float left = 0.0f;
+        float right = 0.0f;
+        renderLanes(left, right);
+        lastOutput = (left + right) * 0.5f * volume;
+        return lastOutput;
+    }
+
+    void processStereo(float& left, float& right) override {
+        if (!usesLanes()) {
+            synth::WavetableOscillatorImpl::processStereo(left, right);
+            return;
+        }
+        renderLanes(left, right);
+        left *= volume;
+        right *= volume;
+        lastOutput = (left + right) * 0.5f;
+    }
+
+private:
+    enum class LaneShape {
+        Sine,
+        Square,
+        Triangle,
+        Sawtooth,
+        Pulse,
+        Table
+    };
+
+    bool usesLanes() const {
+        // Noise gains nothing from stacking, and FM and additive render their
+        // own operator/partial banks; all of them keep the single-voice path.
+        // Hard sync needs the single-voice MinBLEP path as well, and the lanes
+        // have no phase-distortion or waveshaper kernels.
+        return unisonVoices > 1 && !isNoiseType() && !syncEnabled()
+            && waveformType != WaveformType::FM && waveformType != WaveformType::Additive
+            && waveformType != WaveformType::Vector && waveformType != WaveformType::PhaseDistortion
+            && waveformType != WaveformType::Waveshaper;
+    }
+
+    /**
+     * Branch-free PolyBLEP residual so the lane loop stays vectorizable.
+     */
+    static inline float laneBLEP(float t, float dt, float invDt) {
+        float a = t * invDt;
+        float b = (t - 1.0f) * invDt;
+        float head = (t < dt) ? (a + a - a * a - 1.0f) : 0.0f;
+        float tail = (t > 1.0f - dt) ? (b * b + b + b + 1.0f) : 0.0f;
+        return head + tail;
+    }
+
+    static inline float wrapPhase(float p) {
+        return p - std::floor(p);
+    }
+
+    void renderLanes(float& left, float& right) {
+        switch (waveformType) {
+            case WaveformType::Square:
+                renderShape<LaneShape::Square>(left, right);
+                break;
+            case WaveformType::Triangle:
+                renderShape<LaneShape::Triangle>(left, right);
+                break;
+            case WaveformType::Sawtooth:
+                renderShape<LaneShape::Sawtooth>(left, right);
+                break;
+            case WaveformType::Pulse:
+                renderShape<LaneShape::Pulse>(left, right);
+                break;
+            case WaveformType::Wavetable:
+                renderShape<LaneShape::Table>(left, right);
+                break;
+            case WaveformType::Sine:
+            default:
+                renderShape<LaneShape::Sine>(left, right);
+                break;
+        }
+    }
+
+    template <LaneShape Shape>
+    void renderShape(float& left, float& right) {
+        const synth::Wavetable* table = (Shape == LaneShape::Table) ? getCurrentWavetable() : nullptr;
+        const float position = getWavetablePosition();
+        const int level = table ? laneMipLevel(table) : 0;
+        const float width = (Shape == LaneShape::Pulse) ? advancePulseWidth() : pulseWidth;
+        float sumLeft = 0.0f;
+        float sumRight = 0.0f;
+
+        for (int group = 0; group < activeLanes; group += kLaneGroup) {
+            float* p = lanePhase + group;
+            const float* inc = laneIncrement + group;
+            const float* invInc = laneInvIncrement + group;
+            const float* gl = laneGainLeft + group;
+            const float* gr = laneGainRight + group;
+
+            for (int i = 0; i < kLaneGroup; ++i) {
+                float t = p[i];
+                float dt = inc[i];
+                float sample;
+
+                if (Shape == LaneShape::Sine) {
+                    sample = fastmath::sin2pi(t);
+                } else if (Shape == LaneShape::Sawtooth) {
+                    sample = 2.0f * t - 1.0f - laneBLEP(t, dt, invInc[i]);
+                } else if (Shape == LaneShape::Square) {
+                    sample = ((t < 0.5f) ? 1.0f : -1.0f)
+                           + laneBLEP(t, dt, invInc[i])
+                           - laneBLEP(wrapPhase(t + 0.5f), dt, invInc[i]);
+                } else if (Shape == LaneShape::Pulse) {
+                    sample = ((t < width) ? 1.0f : -1.0f)
+                           + laneBLEP(t, dt, invInc[i])
+                           - laneBLEP(wrapPhase(t + (1.0f - width)), dt, invInc[i]);
+                } else if (Shape == LaneShape::Triangle) {
+                    float saw = 2.0f * (t - std::floor(t + 0.5f));
+                    sample = 2.0f * (std::abs(saw) - 0.5f);
+                } else {
+                    sample = table ? table->getSample(t, position, level) : 0.0f;
+                }
+
+                sumLeft += sample * gl[i];
+                sumRight += sample * gr[i];
+
+                t += dt;
+                p[i] = (t >= 1.0f) ? t - 1.0f : t;
+            }
+        }
+
+        left = sumLeft;
+        right = sumRight;
+    }
+
+    /**
+     * Mip level of the table for the highest lane, so that no lane aliases.
+     * Worked out again only when the table or the pitch changes.
+     */
+    int laneMipLevel(const synth::Wavetable* table) {
+        const float topIncrement = laneIncrement[unisonVoices - 1];
+        if (table != mipTable || topIncrement != mipIncrement) {
+            mipTable = table;
+            mipIncrement = topIncrement;
+            mipLevel = table->mipLevelFor(topIncrement);
+        }
+        return mipLevel;
+    }
+
+    /**
+     * Lane offset in [-1, 1]; copies are spread symmetrically around the
+     * centre pitch and pan.
+     */
+    float laneOffset(int lane) const {
+        if (unisonVoices <= 1) return 0.0f;
+        return 2.0f * static_cast<float>(lane) / static_cast<float>(unisonVoices - 1) - 1.0f;
+    }
+
+    void updateLaneRatios() {
+        for (int i = 0; i < kMaxVoices; ++i) {
+            laneRatio[i] = (i < unisonVoices)
+                ? fastmath::centsToRatio(laneOffset(i) * detuneSpread)
+                : 0.0f;
+            laneInvRatio[i] = (i < unisonVoices) ? 1.0f / laneRatio[i] : 0.0f;
+        }
+        updateLaneIncrements();
+    }
+
+    void updateLaneIncrements() {
+        // Called on every setFrequency (pitch bend), so this is one division in
+        // all and two multiplies per lane.
+        const float invIncrement = (phaseIncrement > 0.0f) ? 1.0f / phaseIncrement : 0.0f;
+        for (int i = 0; i < kMaxVoices; ++i) {
+            laneIncrement[i] = phaseIncrement * laneRatio[i];
+            laneInvIncrement[i] = invIncrement * laneInvRatio[i];
+        }
+    }
+
+    void updateLaneGains() {
+        float norm = 1.0f / std::sqrt(static_cast<float>(unisonVoices));
+        for (int i = 0; i < kMaxVoices; ++i) {
+            if (i < unisonVoices) {
+                float lanePan = std::clamp(pan + laneOffset(i) * stereoSpread, -1.0f, 1.0f);
+                laneGainLeft[i] = std::sqrt(1.0f - lanePan) * norm;
+                laneGainRight[i] = std::sqrt(1.0f + lanePan) * norm;
+            } else {
+                laneGainLeft[i] = 0.0f;
+                laneGainRight[i] = 0.0f;
+            }
+        }
+    }
+
+    int unisonVoices;
+    int activeLanes;
+    float detuneSpread;
+    float stereoSpread;
+    float phaseRandomization;
+
+    // Lane state (structure-of-arrays)
+    alignas(32) float lanePhase[kMaxVoices];
+    alignas(32) float laneIncrement[kMaxVoices];
+    alignas(32) float laneInvIncrement[kMaxVoices];
+    alignas(32) float laneRatio[kMaxVoices];
+    alignas(32) float laneInvRatio[kMaxVoices];
+    alignas(32) float laneGainLeft[kMaxVoices];
+    alignas(32) float laneGainRight[kMaxVoices];
+
+    std::minstd_rand randomEngine; // Start phases, seeded like the noise generator
+    std::uniform_real_distribution<float> randomDist;
+
+    // Mip level cache for table lanes
+    const synth::Wavetable* mipTable;
+    float mipIncrement;
+    int mipLevel;
+};
+
+#endif // UNISON_OSCILLATOR_H
@@ -0,0 +1,216 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace synth {
+
+/// Minimal reader for uncompressed WAV and AIFF/AIFC files.
+///
+/// Supports 8/16/24/32-bit integer PCM and 32/64-bit float data (WAVE_FORMAT
+/// IEEE_FLOAT, WAVE_FORMAT_EXTENSIBLE, AIFC 'fl32'/'fl64'). Channels are
+/// mixed down to mono. Intended for worker threads: reads the whole file.
+class AudioFileReader {
+public:
+    struct Result {
+        std::vector<float> samples; ///< Mono samples in [-1, 1]
+        int sampleRate = 0;
+        std::string error;          ///< Empty on success
+    };
+
+    static Result read(const std::string& path) {
+        Result result;
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            result.error = "cannot open " + path;
+            return result;
+        }
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (data.size() < 12) {
+            result.error = "file too short";
+            return result;
+        }
+        if (std::memcmp(data.data(), "RIFF", 4) == 0 && std::memcmp(data.data() + 8, "WAVE", 4) == 0) {
+            readWav(data, result);
+        } else if (std::memcmp(data.data(), "FORM", 4) == 0 &&
+                   (std::memcmp(data.data() + 8, "AIFF", 4) == 0 || std::memcmp(data.data() + 8, "AIFC", 4) == 0)) {
+            readAiff(data, result);
+        } else {
+            result.error = "unsupported file format";
+        }
+        if (result.error.empty() && (result.samples.empty() || result.sampleRate <= 0)) {
+            result.error = "no audio data";
+        }
+        return result;
+    }
+
+private:
+    enum class Encoding { Int, Float };
+
+    struct Format {
+        Encoding encoding = Encoding::Int;
+        int channels = 0;
+        int bitsPerSample = 0;
+        bool bigEndian = false;
+    };
+
+    static uint32_t le32(const uint8_t* p) {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+    static uint16_t le16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+    static uint32_t be32(const uint8_t* p) {
+        return (static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+    }
+    static uint16_t be16(const uint8_t* p) { return static_cast<uint16_t>((p[0] << 8) | p[1]); }
+
+    /// 80-bit IEEE 754 extended float, as used for the AIFF sample rate
+    static double extended80(const uint8_t* p) {
+        int exponent = ((p[0] & 0x7F) << 8) | p[1];
+        uint64_t mantissa = 0;
+        for (int i = 0; i < 8; ++i) {
+            mantissa = (mantissa << 8) | p[2 + i];
+        }
+        if (exponent == 0 && mantissa == 0) return 0.0;
+        double value = std::ldexp(static_cast<double>(mantissa), exponent - 16383 - 63);
+        return (p[0] & 0x80) ? -value : value;
+    }
+
+    static float decodeSample(const uint8_t* p, const Format& format) {
+        const int bytes = format.bitsPerSample / 8;
+        if (format.encoding == Encoding::Float) {
+            uint8_t ordered[8];
+            for (int i = 0; i < bytes; ++i) {
+                ordered[i] = format.bigEndian ? p[bytes - 1 - i] : p[i];
+            }
+            if (bytes == 8) {
+                double value;
+                std::memcpy(&value, ordered, 8);
+                return static_cast<float>(value);
+            }
+            float value;
+            std::memcpy(&value, ordered, 4);
+            return value;
+        }
+        if (bytes == 1) {
+            // WAV 8-bit is unsigned, AIFF 8-bit is signed
+            return format.bigEndian ? static_cast<int8_t>(p[0]) / 128.0f : (static_cast<int>(p[0]) - 128) / 128.0f;
+        }
+        // Assemble the big-endian-ordered bytes into the top of an int32
+        int32_t value = 0;
+        for (int i = 0; i < bytes; ++i) {
+            uint8_t byte = format.bigEndian ? p[i] : p[bytes - 1 - i];
+            value |= static_cast<int32_t>(static_cast<uint32_t>(byte) << (24 - 8 * i));
+        }
+        return static_cast<float>(value / 2147483648.0);
+    }
+
+    static void decodeFrames(const uint8_t* p, size_t available, const Format& format, Result& result) {
+        const int bytes = format.bitsPerSample / 8;
+        if (format.channels <= 0 || bytes <= 0 || bytes > 8 ||
+            (format.encoding == Encoding::Float && bytes != 4 && bytes != 8)) {
+            result.error = "unsupported sample format";
+            return;
+        }
+        const size_t frameBytes = static_cast<size_t>(bytes) * format.channels;
+        const size_t frames = available / frameBytes;
+        const float scale = 1.0f / static_cast<float>(format.channels);
+        result.samples.resize(frames);
+        for (size_t f = 0; f < frames; ++f) {
+            float sum = 0.0f;
+            for (int c = 0; c < format.channels; ++c) {
+                sum += decodeSample(p + f * frameBytes + static_cast<size_t>(c) * bytes, format);
+            }
+            result.samples[f] = sum * scale;
+        }
+    }
+
+    static void readWav(const std::vector<uint8_t>& data, Result& result) {
+        Format format;
+        bool haveFormat = false;
+        size_t offset = 12;
+        while (offset + 8 <= data.size()) {
+            const uint8_t* chunk = data.data() + offset;
+            size_t size = le32(chunk + 4);
+            size_t available = std::min(size, data.size() - offset - 8);
+            if (std::memcmp(chunk, "fmt ", 4) == 0 && available >= 16) {
+                uint16_t tag = le16(chunk + 8);
+                if (tag == 0xFFFE && available >= 40) {
+                    tag = le16(chunk + 32); // Sub-format GUID starts with the format tag
+                }
+                format.encoding = (tag == 3) ? Encoding::Float : Encoding::Int;
+                format.channels = le16(chunk + 10);
+                result.sampleRate = static_cast<int>(le32(chunk + 12));
+                format.bitsPerSample = le16(chunk + 22);
+                if (tag != 1 && tag != 3) {
+                    result.error = "compressed WAV data is not supported";
+                    return;
+                }
+                haveFormat = true;
+            } else if (std::memcmp(chunk, "data", 4) == 0) {
+                if (!haveFormat) {
+                    result.error = "data chunk before fmt chunk";
+                    return;
+                }
+                decodeFrames(chunk + 8, available, format, result);
+                return;
+            }
+            offset += 8 + size + (size & 1); // Chunks are word aligned
+        }
+        result.error = "missing data chunk";
+    }
+
+    static void readAiff(const std::vector<uint8_t>& data, Result& result) {
+        Format format;
+        format.bigEndian = true;
+        bool haveFormat = false;
+        size_t offset = 12;
+        while (offset + 8 <= data.size()) {
+            const uint8_t* chunk = data.data() + offset;
+            size_t size = be32(chunk + 4);
+            size_t available = std::min(size, data.size() - offset - 8);
+            if (std::memcmp(chunk, "COMM", 4) == 0 && available >= 18) {
+                format.channels = be16(chunk + 8);
+                format.bitsPerSample = be16(chunk + 14);
+                result.sampleRate = static_cast<int>(extended80(chunk + 16) + 0.5);
+                if (available >= 22) { // AIFC compression type
+                    const uint8_t* type = chunk + 26;
+                    if (std::memcmp(type, "fl32", 4) == 0 || std::memcmp(type, "FL32", 4) == 0) {
+                        format.encoding = Encoding::Float;
+                        format.bitsPerSample = 32;
+                    } else if (std::memcmp(type, "fl64", 4) == 0 || std::memcmp(type, "FL64", 4) == 0) {
+                        format.encoding = Encoding::Float;
+                        format.bitsPerSample = 64;
+                    } else if (std::memcmp(type, "sowt", 4) == 0) {
+                        format.bigEndian = false;
+                    } else if (std::memcmp(type, "NONE", 4) != 0) {
+                        result.error = "compressed AIFC data is not supported";
+                        return;
+                    }
+                }
+                format.bitsPerSample = (format.bitsPerSample + 7) / 8 * 8;
+                haveFormat = true;
+            } else if (std::memcmp(chunk, "SSND", 4) == 0 && available >= 8) {
+                if (!haveFormat) {
+                    result.error = "SSND chunk before COMM chunk";
+                    return;
+                }
+                size_t dataOffset = be32(chunk + 8);
+                if (8 + dataOffset > available) {
+                    result.error = "corrupt SSND chunk";
+                    return;
+                }
+                decodeFrames(chunk + 16 + dataOffset, available - 8 - dataOffset, format, result);
+                return;
+            }
+            offset += 8 + size + (size & 1);
+        }
+        result.error = "missing SSND chunk";
+    }
+};
+
+} // namespace synth
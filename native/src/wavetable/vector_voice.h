@@ -0,0 +1,333 @@
+#pragma once
+#include "synthesis/oscillator.h"
+#include "wavetable_manager.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace synth {
+
+/// A recorded XY pad gesture: up to kMaxPoints (time, x, y) breakpoints,
+/// played back with linear interpolation.
+struct JoystickEnvelope {
+    static constexpr int kMaxPoints = 128;
+
+    enum class Mode { Off = 0, OneShot = 1, Loop = 2 };
+
+    struct Point {
+        float time; ///< Seconds since the start of the gesture
+        float x;
+        float y;
+    };
+
+    Point points[kMaxPoints];
+    int count = 0;
+
+    float duration() const {
+        return (count > 0) ? points[count - 1].time : 0.0f;
+    }
+
+    /// Position at a time (held at the last point past the end)
+    void evaluate(float time, float& x, float& y) const {
+        if (count <= 0) return;
+        if (time <= points[0].time) {
+            x = points[0].x;
+            y = points[0].y;
+            return;
+        }
+        int i = 1;
+        while (i < count && points[i].time < time) ++i;
+        if (i >= count) {
+            x = points[count - 1].x;
+            y = points[count - 1].y;
+            return;
+        }
+        const Point& a = points[i - 1];
+        const Point& b = points[i];
+        float span = b.time - a.time;
+        float t = (span > 0.0f) ? (time - a.time) / span : 1.0f;
+        x = a.x + (b.x - a.x) * t;
+        y = a.y + (b.y - a.y) * t;
+    }
+};
+
+/// Vector synthesis voice: four sources at the corners of the XY pad,
+/// crossfaded with bilinear weights.
+///
+/// Corner 0 is bottom-left (x = 0, y = 0), 1 bottom-right, 2 top-left and
+/// 3 top-right. Each corner is a basic waveform or a registered wavetable.
+/// Audio is rendered kBlockSize samples at a time: each corner renders its
+/// block, then a single branch-free loop ramps the smoothed pad position
+/// across the block and mixes the four buffers, which the compiler
+/// vectorizes. Smoothing is a one-pole lag evaluated exactly at block
+/// boundaries and interpolated linearly in between.
+///
+/// A recorded gesture is copied on the control thread and published with a
+/// single atomic pointer store, picked up at the next block. A replaced
+/// gesture is freed by a later publish, once every block that could still be
+/// reading it has finished.
+class VectorVoice {
+public:
+    static constexpr int kCorners = 4;
+    static constexpr int kBlockSize = 32;
+
+    VectorVoice()
+        : manager_(nullptr)
+        , sampleRate_(44100)
+        , frequency_(440.0f)
+        , targetX_(0.5f)
+        , targetY_(0.5f)
+        , x_(0.5f)
+        , y_(0.5f)
+        , smoothingMs_(20.0f)
+        , blockDecay_(0.0f)
+        , envelopeMode_(0)
+        , envelope_(nullptr)
+        , audioEpoch_(0)
+        , envelopeTime_(0.0f)
+        , restartEnvelope_(false)
+        , outputPosition_(kBlockSize) {
+        for (int c = 0; c < kCorners; ++c) {
+            corners_[c].oscillator.setVolume(1.0f);
+            corners_[c].handle = WavetableManager::kInvalidHandle;
+            corners_[c].type = Oscillator::WaveformType::Sine;
+        }
+        // Distinct defaults so the pad does something before it is configured
+        setCornerType(0, static_cast<int>(Oscillator::WaveformType::Sine));
+        setCornerType(1, static_cast<int>(Oscillator::WaveformType::Sawtooth));
+        setCornerType(2, static_cast<int>(Oscillator::WaveformType::Square));
+        setCornerType(3, static_cast<int>(Oscillator::WaveformType::Triangle));
+        updateSmoothing();
+    }
+
+    void setWavetableManager(const WavetableManager* manager) {
+        manager_ = manager;
+    }
+
+    void setSampleRate(int sr) {
+        sampleRate_ = (sr > 0) ? sr : 44100;
+        for (auto& corner : corners_) {
+            corner.oscillator.setSampleRate(sampleRate_);
+            corner.table.setSampleRate(static_cast<float>(sampleRate_));
+        }
+        updateSmoothing();
+    }
+
+    void setFrequency(float freq) {
+        if (freq == frequency_) return; // Called every sample by the owning oscillator
+        frequency_ = freq;
+        for (auto& corner : corners_) {
+            corner.oscillator.setFrequency(freq);
+            corner.table.setFrequency(freq);
+        }
+    }
+
+    /// Set a corner's source. Wavetable uses the corner's table handle;
+    /// FM, additive and vector types are not available as corners and play a sine.
+    void setCornerType(int corner, int type) {
+        if (corner < 0 || corner >= kCorners) return;
+        auto waveform = static_cast<Oscillator::WaveformType>(std::clamp(type, 0, static_cast<int>(Oscillator::WaveformType::BrownNoise)));
+        corners_[corner].type = waveform;
+        corners_[corner].oscillator.setType(static_cast<int>(waveform));
+    }
+
+    void setCornerWavetable(int corner, WavetableManager::Handle handle) {
+        if (corner < 0 || corner >= kCorners) return;
+        corners_[corner].handle = handle;
+    }
+
+    void setCornerWavetablePosition(int corner, float position) {
+        if (corner < 0 || corner >= kCorners) return;
+        corners_[corner].table.setTablePosition(position);
+    }
+
+    /// Set the pad position the voice glides to (0.0 - 1.0 on each axis)
+    void setPosition(float x, float y) {
+        targetX_.store(std::clamp(x, 0.0f, 1.0f));
+        targetY_.store(std::clamp(y, 0.0f, 1.0f));
+    }
+
+    void setX(float x) { targetX_.store(std::clamp(x, 0.0f, 1.0f)); }
+    void setY(float y) { targetY_.store(std::clamp(y, 0.0f, 1.0f)); }
+
+    /// Set the glide time constant in milliseconds
+    void setSmoothing(float ms) {
+        smoothingMs_ = std::clamp(ms, 0.0f, 2000.0f);
+        updateSmoothing();
+    }
+
+    /// Publish a recorded gesture (control thread, any number per block)
+    void setJoystickEnvelope(const JoystickEnvelope& envelope) {
+        auto copy = std::make_unique<JoystickEnvelope>(envelope);
+        std::lock_guard<std::mutex> lock(envelopeMutex_);
+        collectRetiredLocked();
+        // Sequentially consistent store and epoch read: any block that starts
+        // after the epoch we read is guaranteed to load the new gesture.
+        envelope_.store(copy.get());
+        if (ownedEnvelope_) {
+            retired_.push_back({std::move(ownedEnvelope_), audioEpoch_.load()});
+        }
+        ownedEnvelope_ = std::move(copy);
+    }
+
+    /// 0 = off (pad position only), 1 = play once per note, 2 = loop
+    void setEnvelopeMode(int mode) {
+        envelopeMode_.store(std::clamp(mode, 0, 2));
+    }
+
+    /// Restart the gesture; applied by the next block, which reads it
+    void noteOn() {
+        restartEnvelope_.store(true);
+    }
+
+    float nextSample() {
+        if (outputPosition_ >= kBlockSize) {
+            renderBlock();
+            outputPosition_ = 0;
+        }
+        return output_[outputPosition_++];
+    }
+
+    void render(float* out, int numFrames) {
+        while (numFrames > 0) {
+            if (outputPosition_ >= kBlockSize) {
+                renderBlock();
+                outputPosition_ = 0;
+            }
+            int count = std::min(numFrames, kBlockSize - outputPosition_);
+            std::copy(output_ + outputPosition_, output_ + outputPosition_ + count, out);
+            outputPosition_ += count;
+            out += count;
+            numFrames -= count;
+        }
+    }
+
+private:
+    struct RetiredEnvelope {
+        std::unique_ptr<JoystickEnvelope> envelope;
+        uint64_t epoch;
+    };
+
+    void collectRetiredLocked() {
+        uint64_t epoch = audioEpoch_.load();
+        std::vector<RetiredEnvelope> pending;
+        for (auto& entry : retired_) {
+            if (epoch <= entry.epoch) {
+                pending.push_back(std::move(entry));
+            }
+        }
+        retired_.swap(pending);
+    }
+
+    struct Corner {
+        Oscillator::WaveformType type;
+        Oscillator oscillator;
+        WavetableOscillator table;
+        WavetableManager::Handle handle;
+    };
+
+    void updateSmoothing() {
+        float samples = smoothingMs_ * 0.001f * static_cast<float>(sampleRate_);
+        blockDecay_ = (samples > 0.0f) ? std::exp(-static_cast<float>(kBlockSize) / samples) : 0.0f;
+    }
+
+    void renderCorner(Corner& corner, float* buffer) {
+        if (corner.type == Oscillator::WaveformType::Wavetable) {
+            // Resolved per block: the table behind a handle may be hot-swapped
+            const Wavetable* table = manager_ ? manager_->getWavetable(corner.handle) : nullptr;
+            if (table) {
+                corner.table.setWavetable(table);
+                for (int i = 0; i < kBlockSize; ++i) {
+                    buffer[i] = corner.table.process();
+                }
+                return;
+            }
+            std::fill(buffer, buffer + kBlockSize, 0.0f);
+            return;
+        }
+        corner.oscillator.processBlock(buffer, kBlockSize);
+    }
+
+    void renderBlock() {
+        // Target: the recorded gesture when one is playing, else the pad
+        float targetX = targetX_.load();
+        float targetY = targetY_.load();
+        int mode = envelopeMode_.load();
+        const JoystickEnvelope* envelope = envelope_.load();
+        if (restartEnvelope_.exchange(false)) {
+            envelopeTime_ = 0.0f;
+            // Start the gesture from its first point rather than gliding to it
+            if (mode != static_cast<int>(JoystickEnvelope::Mode::Off) && envelope && envelope->count > 0) {
+                envelope->evaluate(0.0f, x_, y_);
+            }
+        }
+        if (mode != static_cast<int>(JoystickEnvelope::Mode::Off) && envelope && envelope->count > 0) {
+            float duration = envelope->duration();
+            if (mode == static_cast<int>(JoystickEnvelope::Mode::Loop) && duration > 0.0f &&
+                envelopeTime_ >= duration) {
+                envelopeTime_ = std::fmod(envelopeTime_, duration);
+            }
+            envelope->evaluate(envelopeTime_, targetX, targetY);
+            envelopeTime_ += static_cast<float>(kBlockSize) / static_cast<float>(sampleRate_);
+        }
+
+        const float x0 = x_;
+        const float y0 = y_;
+        x_ = targetX + (x_ - targetX) * blockDecay_;
+        y_ = targetY + (y_ - targetY) * blockDecay_;
+        const float dx = (x_ - x0) / kBlockSize;
+        const float dy = (y_ - y0) / kBlockSize;
+
+        for (int c = 0; c < kCorners; ++c) {
+            renderCorner(corners_[c], cornerBuffers_[c]);
+        }
+
+        // Fused bilinear mix
+        const float* a = cornerBuffers_[0];
+        const float* b = cornerBuffers_[1];
+        const float* c = cornerBuffers_[2];
+        const float* d = cornerBuffers_[3];
+        for (int i = 0; i < kBlockSize; ++i) {
+            float x = x0 + dx * static_cast<float>(i);
+            float y = y0 + dy * static_cast<float>(i);
+            float bottom = a[i] + x * (b[i] - a[i]);
+            float top = c[i] + x * (d[i] - c[i]);
+            output_[i] = bottom + y * (top - bottom);
+        }
+
+        audioEpoch_.fetch_add(1);
+    }
+
+    const WavetableManager* manager_;
+    int sampleRate_;
+    float frequency_;
+    Corner corners_[kCorners];
+
+    // Pad position: targets are written by the control thread
+    std::atomic<float> targetX_;
+    std::atomic<float> targetY_;
+    float x_;
+    float y_;
+    float smoothingMs_;
+    float blockDecay_;
+
+    // Joystick envelope publishing (under envelopeMutex_)
+    std::atomic<int> envelopeMode_;
+    std::atomic<const JoystickEnvelope*> envelope_;
+    std::atomic<uint64_t> audioEpoch_; // Blocks finished by the renderer
+    std::mutex envelopeMutex_;
+    std::unique_ptr<JoystickEnvelope> ownedEnvelope_;
+    std::vector<RetiredEnvelope> retired_;
+    float envelopeTime_;
+    std::atomic<bool> restartEnvelope_;
+
+    alignas(32) float cornerBuffers_[kCorners][kBlockSize];
+    alignas(32) float output_[kBlockSize];
+    int outputPosition_;
+};
+
+} // namespace synth
@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <cmath>
@@ -14,9 +15,9 @@ struct WaveFrame {
     float getSample(float phase) const {
         if (samples.empty()) return 0.0f;
         
-        // Linear interpolation between samples
-        float indexFloat = phase * (samples.size() - 1);
-        size_t index0 = static_cast<size_t>(indexFloat);
+        // Linear interpolation between samples; the cycle wraps from the last sample to the first
+        float indexFloat = phase * samples.size();
+        size_t index0 = std::min(static_cast<size_t>(indexFloat), samples.size() - 1);
         size_t index1 = (index0 + 1) % samples.size();
         float fraction = indexFloat - index0;
         
@@ -36,20 +37,39 @@ public:
     
     // Get interpolated sample from the wavetable
     float getSample(float phase, float position) const {
-        if (frames_.empty()) return 0.0f;
-        
-        // Position determines which frames to interpolate between
-        float frameIndex = position * (frames_.size() - 1);
-        size_t frame0 = static_cast<size_t>(frameIndex);
-        size_t frame1 = (frame0 + 1) % frames_.size();
-        float frameFraction = frameIndex - frame0;
-        
-        // Get samples from both frames
-        float sample0 = frames_[frame0].getSample(phase);
-        float sample1 = frames_[frame1].getSample(phase);
-        
-        // Interpolate between frames
-        return sample0 * (1.0f - frameFraction) + sample1 * frameFraction;
+        return sampleFrames(frames_, phase, position);
+    }
+    
+    // Get interpolated sample from a mip level (0 = full bandwidth)
+    float getSample(float phase, float position, int mipLevel) const {
+        if (mipLevel <= 0 || mipLevels_.empty()) {
+            return sampleFrames(frames_, phase, position);
+        }
+        size_t level = std::min(static_cast<size_t>(mipLevel), mipLevels_.size());
+        return sampleFrames(mipLevels_[level - 1], phase, position);
+    }
+    
+    /// Band-limited copies of the frames, one set per octave: level L keeps
+    /// the lowest (frameSize / 2) >> L harmonics. Level 0 is the frames themselves,
+    /// so levels[0] here is mip level 1.
+    void setMipLevels(std::vector<std::vector<WaveFrame>> levels) {
+        mipLevels_ = std::move(levels);
+    }
+    
+    int getMipLevelCount() const {
+        return static_cast<int>(mipLevels_.size()) + 1;
+    }
+    
+    /// Lowest mip level whose harmonics all stay below Nyquist at this phase increment
+    int mipLevelFor(float phaseIncrement) const {
+        if (mipLevels_.empty() || frames_.empty()) return 0;
+        float harmonicsOver = std::abs(phaseIncrement) * static_cast<float>(frames_[0].samples.size());
+        int level = 0;
+        int maxLevel = static_cast<int>(mipLevels_.size());
+        for (float limit = 1.0f; harmonicsOver > limit && level < maxLevel; limit *= 2.0f) {
+            ++level;
+        }
+        return level;
     }
     
     // Factory methods for common wavetables
@@ -123,10 +143,29 @@ public:
     
     const std::string& getName() const { return name_; }
     size_t getFrameCount() const { return frames_.size(); }
+    const WaveFrame& getFrame(size_t index) const { return frames_[index]; }
     
 private:
+    static float sampleFrames(const std::vector<WaveFrame>& frames, float phase, float position) {
+        if (frames.empty()) return 0.0f;
+        
+        // Position determines which frames to interpolate between
+        float frameIndex = position * (frames.size() - 1);
+        size_t frame0 = static_cast<size_t>(frameIndex);
+        size_t frame1 = (frame0 + 1) % frames.size();
+        float frameFraction = frameIndex - frame0;
+        
+        // Get samples from both frames
+        float sample0 = frames[frame0].getSample(phase);
+        float sample1 = frames[frame1].getSample(phase);
+        
+        // Interpolate between frames
+        return sample0 * (1.0f - frameFraction) + sample1 * frameFraction;
+    }
+    
     std::string name_;
     std::vector<WaveFrame> frames_;
+    std::vector<std::vector<WaveFrame>> mipLevels_;
 };
 
 /// Wavetable oscillator class
@@ -163,7 +202,9 @@ public:
     float process() {
         if (!currentTable_) return 0.0f;
         
-        float sample = currentTable_->getSample(phase_, tablePosition_);
+        // Imported tables carry mip levels; pick the one that cannot alias at this pitch
+        int mipLevel = currentTable_->mipLevelFor(phaseIncrement_);
+        float sample = currentTable_->getSample(phase_, tablePosition_, mipLevel);
         
         // Update phase
         phase_ += phaseIncrement_;
@@ -178,6 +219,9 @@ public:
         phase_ = 0.0f;
     }
     
+    const Wavetable* getWavetable() const { return currentTable_; }
+    float getTablePosition() const { return tablePosition_; }
+    
 private:
     void updatePhaseIncrement() {
         phaseIncrement_ = frequency_ / sampleRate_;
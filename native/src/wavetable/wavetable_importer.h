@@ -0,0 +1,398 @@
+#pragma once
+#include "wavetable_manager.h"
+#include "audio_file_reader.h"
+#include "kiss_fftr.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace synth {
+
+/// Turns recorded audio into a mip-mapped wavetable on a background thread.
+///
+/// The source is cut pitch-synchronously: the fundamental is estimated with
+/// YIN, each frame starts at a rising zero crossing and spans one locally
+/// measured period, and that cycle is resampled to kFrameSize samples.
+/// Octave-spaced band-limited mip levels are built with kissfft and the
+/// finished table is published through WavetableManager::addWavetable, so
+/// the audio thread never blocks or allocates on behalf of an import.
+/// Unpitched material falls back to consecutive kFrameSize-sample slices.
+class WavetableImporter {
+public:
+    enum class Status { Progress = 0, Completed = 1, Failed = 2 };
+
+    /// (jobId, status, progress 0.0 - 1.0, handle). Invoked on the worker thread;
+    /// the handle is only valid with Status::Completed.
+    using Callback = std::function<void(int, Status, float, WavetableManager::Handle)>;
+    using ProgressFn = std::function<bool(float)>;
+
+    static constexpr int kFrameSize = 2048;
+    static constexpr int kMaxFrames = 256;
+    static constexpr float kMinFundamental = 30.0f;
+    static constexpr float kMaxFundamental = 2000.0f;
+
+    explicit WavetableImporter(WavetableManager* manager)
+        : manager_(manager), nextJobId_(1), stopping_(false) {}
+
+    ~WavetableImporter() {
+        stop();
+    }
+
+    WavetableImporter(const WavetableImporter&) = delete;
+    WavetableImporter& operator=(const WavetableImporter&) = delete;
+
+    void setCallback(Callback callback) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        callback_ = std::move(callback);
+    }
+
+    /// Queue an import of a WAV/AIFF file. Returns the job id.
+    int importFile(const std::string& path, const std::string& name) {
+        Job job;
+        job.path = path;
+        job.name = name;
+        return enqueue(std::move(job));
+    }
+
+    /// Queue an import of mono samples. Returns the job id.
+    int importBuffer(std::vector<float> samples, int sampleRate, const std::string& name) {
+        Job job;
+        job.samples = std::move(samples);
+        job.sampleRate = sampleRate;
+        job.name = name;
+        return enqueue(std::move(job));
+    }
+
+    /// Cancel pending work and join the worker thread
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+            queue_.clear();
+        }
+        wake_.notify_all();
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+    }
+
+    /// Build a wavetable synchronously. Returns null if the audio is too short.
+    ///
+    /// @param progress Called with 0.0 - 1.0; returning false cancels the build (may be empty)
+    /// @param fundamental Receives the detected fundamental in Hz, 0 if unpitched (may be null)
+    static std::unique_ptr<Wavetable> buildWavetable(const std::vector<float>& samples, int sampleRate,
+                                                     const std::string& name, const ProgressFn& progress,
+                                                     float* fundamental = nullptr) {
+        if (fundamental) *fundamental = 0.0f;
+        if (sampleRate <= 0 || samples.size() < static_cast<size_t>(kFrameSize)) {
+            return nullptr;
+        }
+        auto report = [&](float value) { return !progress || progress(value); };
+
+        const float minPeriod = static_cast<float>(sampleRate) / kMaxFundamental;
+        const float maxPeriod = static_cast<float>(sampleRate) / kMinFundamental;
+        float period = estimateGlobalPeriod(samples, minPeriod, maxPeriod);
+        bool pitched = period > 0.0f;
+        if (!pitched) {
+            period = static_cast<float>(kFrameSize);
+        }
+        if (fundamental && pitched) *fundamental = static_cast<float>(sampleRate) / period;
+
+        // Frames are spread evenly over the part of the file where a full cycle
+        // and its analysis window fit
+        const float span = pitched ? 2.5f * period : period;
+        const float usable = static_cast<float>(samples.size()) - span;
+        if (usable < 0.0f) {
+            return nullptr;
+        }
+        const int frameCount = std::clamp(static_cast<int>(usable / period), 1, kMaxFrames);
+
+        auto table = std::make_unique<Wavetable>(name);
+        std::vector<WaveFrame> frames;
+        frames.reserve(frameCount);
+        float peak = 0.0f;
+        for (int f = 0; f < frameCount; ++f) {
+            float target = (frameCount > 1) ? usable * f / (frameCount - 1) : 0.5f * usable;
+            float start = target;
+            float cycle = period;
+            if (pitched) {
+                start = risingZeroCrossing(samples, target, period);
+                float local = estimatePeriod(samples, static_cast<size_t>(start), 0.8f * period, 1.25f * period, 0.3f);
+                if (local > 0.0f) cycle = local;
+            }
+            frames.push_back(sliceCycle(samples, start, cycle));
+            for (float s : frames.back().samples) peak = std::max(peak, std::abs(s));
+            if (!report(0.8f * (f + 1) / frameCount)) return nullptr;
+        }
+
+        float gain = (peak > 0.0f) ? 1.0f / peak : 1.0f;
+        for (auto& frame : frames) {
+            for (float& s : frame.samples) s *= gain;
+            table->addFrame(frame);
+        }
+        if (!buildMipLevels(*table, [&](float value) { return report(0.8f + 0.2f * value); })) {
+            return nullptr;
+        }
+        return table;
+    }
+
+private:
+    struct Job {
+        int id = 0;
+        std::string path;
+        std::vector<float> samples;
+        int sampleRate = 0;
+        std::string name;
+    };
+
+    int enqueue(Job job) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job.id = nextJobId_++;
+        int id = job.id;
+        stopping_ = false;
+        queue_.push_back(std::move(job));
+        if (!worker_.joinable()) {
+            worker_ = std::thread([this]() { run(); });
+        }
+        wake_.notify_one();
+        return id;
+    }
+
+    void notify(int jobId, Status status, float progress, WavetableManager::Handle handle) {
+        Callback callback;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            callback = callback_;
+        }
+        if (callback) {
+            callback(jobId, status, progress, handle);
+        }
+    }
+
+    void run() {
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+                if (stopping_) return;
+                job = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            process(job);
+        }
+    }
+
+    void process(Job& job) {
+        notify(job.id, Status::Progress, 0.0f, WavetableManager::kInvalidHandle);
+        float readShare = 0.0f;
+        if (!job.path.empty()) {
+            AudioFileReader::Result file = AudioFileReader::read(job.path);
+            if (!file.error.empty()) {
+                std::cerr << "WavetableImporter: " << file.error << std::endl;
+                notify(job.id, Status::Failed, 1.0f, WavetableManager::kInvalidHandle);
+                return;
+            }
+            job.samples = std::move(file.samples);
+            job.sampleRate = file.sampleRate;
+            readShare = 0.1f;
+            notify(job.id, Status::Progress, readShare, WavetableManager::kInvalidHandle);
+        }
+
+        // Report at most every 5% so a long import does not flood the UI
+        float lastReported = readShare;
+        auto progress = [&](float value) {
+            float overall = readShare + (1.0f - readShare) * value;
+            if (overall - lastReported >= 0.05f && overall < 1.0f) {
+                lastReported = overall;
+                notify(job.id, Status::Progress, overall, WavetableManager::kInvalidHandle);
+            }
+            return !stopping_.load();
+        };
+
+        auto table = buildWavetable(job.samples, job.sampleRate, job.name, progress);
+        WavetableManager::Handle handle = WavetableManager::kInvalidHandle;
+        if (table && manager_) {
+            handle = manager_->addWavetable(job.name, std::move(table));
+        }
+        if (handle == WavetableManager::kInvalidHandle) {
+            notify(job.id, Status::Failed, 1.0f, handle);
+            return;
+        }
+        notify(job.id, Status::Completed, 1.0f, handle);
+    }
+
+    /// YIN period estimate (cumulative mean normalized difference) over one
+    /// window starting at start. Returns 0 if no lag is periodic enough.
+    static float estimatePeriod(const std::vector<float>& x, size_t start, float minPeriod, float maxPeriod,
+                                float threshold) {
+        const int minLag = std::max(2, static_cast<int>(minPeriod));
+        const int maxLag = static_cast<int>(std::ceil(maxPeriod)) + 1;
+        const int window = maxLag;
+        if (start + static_cast<size_t>(window + maxLag + 1) > x.size()) {
+            return 0.0f;
+        }
+        const float* s = x.data() + start;
+
+        std::vector<float> cmnd(maxLag + 1, 1.0f);
+        double running = 0.0;
+        for (int tau = 1; tau <= maxLag; ++tau) {
+            double d = 0.0;
+            for (int j = 0; j < window; ++j) {
+                double diff = s[j] - s[j + tau];
+                d += diff * diff;
+            }
+            running += d;
+            cmnd[tau] = (running > 0.0) ? static_cast<float>(d * tau / running) : 1.0f;
+        }
+
+        int best = -1;
+        for (int tau = minLag; tau < maxLag; ++tau) {
+            if (cmnd[tau] < threshold) {
+                while (tau + 1 < maxLag && cmnd[tau + 1] < cmnd[tau]) ++tau;
+                best = tau;
+                break;
+            }
+        }
+        if (best < 0) {
+            return 0.0f;
+        }
+        // Parabolic interpolation of the dip
+        float a = cmnd[best - 1], b = cmnd[best], c = cmnd[best + 1];
+        float denom = a - 2.0f * b + c;
+        float offset = (denom > 0.0f) ? std::clamp(0.5f * (a - c) / denom, -0.5f, 0.5f) : 0.0f;
+        return static_cast<float>(best) + offset;
+    }
+
+    /// Median of YIN estimates taken across the file; 0 if mostly unpitched
+    static float estimateGlobalPeriod(const std::vector<float>& x, float minPeriod, float maxPeriod) {
+        const int probes = 9;
+        const size_t needed = static_cast<size_t>(2.0f * maxPeriod) + 2;
+        std::vector<float> periods;
+        for (int i = 0; i < probes; ++i) {
+            float fraction = 0.1f + 0.8f * i / (probes - 1);
+            size_t start = static_cast<size_t>(fraction * static_cast<float>(x.size()));
+            start = (start + needed <= x.size()) ? start : (x.size() > needed ? x.size() - needed : 0);
+            float period = estimatePeriod(x, start, minPeriod, maxPeriod, 0.15f);
+            if (period > 0.0f) periods.push_back(period);
+        }
+        if (periods.size() * 2 < static_cast<size_t>(probes)) {
+            return 0.0f;
+        }
+        std::nth_element(periods.begin(), periods.begin() + periods.size() / 2, periods.end());
+        return periods[periods.size() / 2];
+    }
+
+    /// Fractional position of the rising zero crossing nearest to target
+    /// (within half a period), or target itself if there is none
+    static float risingZeroCrossing(const std::vector<float>& x, float target, float period) {
+        long centre = static_cast<long>(target);
+        long reach = static_cast<long>(0.5f * period);
+        for (long d = 0; d <= reach; ++d) {
+            for (long k : {centre + d, centre - d}) {
+                if (k < 0 || k + 1 >= static_cast<long>(x.size())) continue;
+                if (x[k] <= 0.0f && x[k + 1] > 0.0f) {
+                    return static_cast<float>(k) + x[k] / (x[k] - x[k + 1]);
+                }
+            }
+        }
+        return target;
+    }
+
+    /// Catmull-Rom interpolation at a fractional index
+    static float sampleAt(const std::vector<float>& x, float position) {
+        long i = static_cast<long>(std::floor(position));
+        float t = position - static_cast<float>(i);
+        const long last = static_cast<long>(x.size()) - 1;
+        float p0 = x[std::clamp(i - 1, 0L, last)];
+        float p1 = x[std::clamp(i, 0L, last)];
+        float p2 = x[std::clamp(i + 1, 0L, last)];
+        float p3 = x[std::clamp(i + 2, 0L, last)];
+        return p1 + 0.5f * t * (p2 - p0 + t * (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3 + t * (3.0f * (p1 - p2) + p3 - p0)));
+    }
+
+    /// Resample one cycle to kFrameSize samples, removing the drift between
+    /// its ends (so it loops without a step) and its DC offset
+    static WaveFrame sliceCycle(const std::vector<float>& x, float start, float cycle) {
+        WaveFrame frame(kFrameSize);
+        const float step = cycle / kFrameSize;
+        const float drift = sampleAt(x, start + cycle) - sampleAt(x, start);
+        double mean = 0.0;
+        for (int n = 0; n < kFrameSize; ++n) {
+            float value = sampleAt(x, start + n * step) - drift * n / kFrameSize;
+            frame.samples[n] = value;
+            mean += value;
+        }
+        const float dc = static_cast<float>(mean / kFrameSize);
+        for (float& s : frame.samples) s -= dc;
+        return frame;
+    }
+
+    /// Level L keeps (kFrameSize / 2) >> L harmonics, stored at twice that
+    /// bandwidth (kFrameSize >> (L - 1) samples, at least 64) to save memory
+    static bool buildMipLevels(Wavetable& table, const ProgressFn& progress) {
+        const int levels = 10; // log2(kFrameSize / 2): the last level is a sine
+        const int frameCount = static_cast<int>(table.getFrameCount());
+        std::vector<std::vector<WaveFrame>> mips(levels);
+
+        kiss_fftr_cfg forward = kiss_fftr_alloc(kFrameSize, 0, nullptr, nullptr);
+        std::vector<kiss_fftr_cfg> inverse(levels, nullptr);
+        std::vector<int> sizes(levels);
+        for (int l = 0; l < levels; ++l) {
+            sizes[l] = std::max(64, kFrameSize >> l);
+            inverse[l] = kiss_fftr_alloc(sizes[l], 1, nullptr, nullptr);
+        }
+        auto release = [&]() {
+            kiss_fftr_free(forward);
+            for (auto plan : inverse) kiss_fftr_free(plan);
+        };
+
+        std::vector<kiss_fft_scalar> input(kFrameSize);
+        std::vector<kiss_fft_cpx> spectrum(kFrameSize / 2 + 1);
+        std::vector<kiss_fft_cpx> truncated(kFrameSize / 2 + 1);
+        std::vector<kiss_fft_scalar> output(kFrameSize);
+        for (int f = 0; f < frameCount; ++f) {
+            const WaveFrame& source = table.getFrame(f);
+            std::copy(source.samples.begin(), source.samples.end(), input.begin());
+            kiss_fftr(forward, input.data(), spectrum.data());
+            for (int l = 0; l < levels; ++l) {
+                const int keep = (kFrameSize / 2) >> (l + 1);
+                const int size = sizes[l];
+                std::fill(truncated.begin(), truncated.begin() + size / 2 + 1, kiss_fft_cpx{0.0f, 0.0f});
+                for (int k = 1; k <= keep; ++k) {
+                    truncated[k] = spectrum[k];
+                }
+                kiss_fftri(inverse[l], truncated.data(), output.data());
+                WaveFrame frame(size);
+                for (int n = 0; n < size; ++n) {
+                    frame.samples[n] = output[n] / kFrameSize;
+                }
+                mips[l].push_back(std::move(frame));
+            }
+            if (progress && !progress(static_cast<float>(f + 1) / frameCount)) {
+                release();
+                return false;
+            }
+        }
+        release();
+        table.setMipLevels(std::move(mips));
+        return true;
+    }
+
+    WavetableManager* manager_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<Job> queue_;
+    std::thread worker_;
+    Callback callback_;
+    int nextJobId_;
+    std::atomic<bool> stopping_;
+};
+
+} // namespace synth
@@ -1,52 +1,159 @@
 #pragma once
 #include "wavetable.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <unordered_map>
 #include <memory>
+#include <mutex>
 
 namespace synth {
 
-/// Manages a collection of wavetables and provides access to them
+/// Manages a collection of wavetables and provides access to them.
+///
+/// Tables are addressed by stable integer handles, assigned in registration
+/// order and never reused. The audio thread resolves a handle with a single
+/// atomic load from a fixed slot array; registering or replacing a table is
+/// an atomic pointer publish, so voices can keep playing a handle while its
+/// table is swapped. A replaced table is retired, not freed: it is deleted
+/// only once the audio thread has finished the block that might still be
+/// reading it (see audioBlockFinished()).
 class WavetableManager {
 public:
-    WavetableManager() {
+    using Handle = int;
+    static constexpr int kMaxTables = 256;
+    static constexpr Handle kInvalidHandle = -1;
+
+    WavetableManager() : tableCount_(0), audioEpoch_(0) {
+        for (auto& slot : slots_) {
+            slot.store(nullptr, std::memory_order_relaxed);
+        }
         initializeBuiltinTables();
     }
-    
-    // Get a wavetable by name
+
+    WavetableManager(const WavetableManager&) = delete;
+    WavetableManager& operator=(const WavetableManager&) = delete;
+
+    // Get a wavetable by handle. Lock-free; safe on the audio thread. The
+    // pointer stays valid until the end of the current audio block.
+    const Wavetable* getWavetable(Handle handle) const {
+        if (handle < 0 || handle >= tableCount_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return slots_[handle].load();
+    }
+
+    // Get a wavetable by name (control thread)
     const Wavetable* getWavetable(const std::string& name) const {
-        auto it = tables_.find(name);
-        return (it != tables_.end()) ? it->second.get() : nullptr;
+        return getWavetable(findHandle(name));
     }
-    
-    // Add a custom wavetable
-    void addWavetable(const std::string& name, std::unique_ptr<Wavetable> table) {
-        tables_[name] = std::move(table);
+
+    // Look up the handle registered for a name, or kInvalidHandle
+    Handle findHandle(const std::string& name) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = handles_.find(name);
+        return (it != handles_.end()) ? it->second : kInvalidHandle;
     }
-    
-    // Get list of available wavetable names
+
+    // Add a custom wavetable, or replace the table already registered under
+    // this name (keeping its handle). Returns the handle, or kInvalidHandle
+    // if the registry is full.
+    Handle addWavetable(const std::string& name, std::unique_ptr<Wavetable> table) {
+        if (!table) return kInvalidHandle;
+        std::lock_guard<std::mutex> lock(mutex_);
+        collectRetiredLocked();
+
+        auto it = handles_.find(name);
+        if (it != handles_.end()) {
+            publishLocked(it->second, std::move(table));
+            return it->second;
+        }
+
+        Handle handle = tableCount_.load(std::memory_order_relaxed);
+        if (handle >= kMaxTables) return kInvalidHandle;
+        handles_[name] = handle;
+        names_.push_back(name);
+        publishLocked(handle, std::move(table));
+        // Publish the slot before making the handle visible
+        tableCount_.store(handle + 1, std::memory_order_release);
+        return handle;
+    }
+
+    // Replace the table behind an existing handle while it may be playing
+    bool replaceWavetable(Handle handle, std::unique_ptr<Wavetable> table) {
+        if (!table) return false;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (handle < 0 || handle >= tableCount_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        collectRetiredLocked();
+        publishLocked(handle, std::move(table));
+        return true;
+    }
+
+    // Get list of available wavetable names; the index of each name is its handle
     std::vector<std::string> getTableNames() const {
-        std::vector<std::string> names;
-        names.reserve(tables_.size());
-        for (const auto& pair : tables_) {
-            names.push_back(pair.first);
+        std::lock_guard<std::mutex> lock(mutex_);
+        return names_;
+    }
+
+    int getTableCount() const {
+        return tableCount_.load(std::memory_order_acquire);
+    }
+
+    // Called by the audio thread after each block: any table retired before
+    // this point can no longer be referenced and may be freed.
+    void audioBlockFinished() {
+        audioEpoch_.fetch_add(1);
+    }
+
+    // Free retired tables the audio thread has moved past (control thread)
+    void collectRetired() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        collectRetiredLocked();
+    }
+
+private:
+    struct RetiredTable {
+        std::unique_ptr<Wavetable> table;
+        uint64_t epoch;
+    };
+
+    void publishLocked(Handle handle, std::unique_ptr<Wavetable> table) {
+        // Sequentially consistent store and epoch read: any block that starts
+        // after the epoch we read is guaranteed to load the new pointer.
+        slots_[handle].store(table.get());
+        if (owned_[handle]) {
+            retired_.push_back({std::move(owned_[handle]), audioEpoch_.load()});
         }
-        return names;
+        owned_[handle] = std::move(table);
     }
-    
+
+    void collectRetiredLocked() {
+        uint64_t epoch = audioEpoch_.load();
+        std::vector<RetiredTable> pending;
+        for (auto& entry : retired_) {
+            if (epoch <= entry.epoch) {
+                pending.push_back(std::move(entry));
+            }
+        }
+        retired_.swap(pending);
+    }
+
 private:
     void initializeBuiltinTables() {
-        // Basic waveforms
-        tables_["Basic Shapes"] = std::make_unique<Wavetable>(Wavetable::createBasicShapes());
-        tables_["PWM"] = std::make_unique<Wavetable>(Wavetable::createPWM());
+        // Basic waveforms (handles 0 and 1)
+        addWavetable("Basic Shapes", std::make_unique<Wavetable>(Wavetable::createBasicShapes()));
+        addWavetable("PWM", std::make_unique<Wavetable>(Wavetable::createPWM()));
         
         // Harmonic series
-        tables_["Harmonic Series"] = std::make_unique<Wavetable>(createHarmonicSeries());
+        addWavetable("Harmonic Series", std::make_unique<Wavetable>(createHarmonicSeries()));
         
         // Formant wavetable
-        tables_["Vocal Formants"] = std::make_unique<Wavetable>(createVocalFormants());
+        addWavetable("Vocal Formants", std::make_unique<Wavetable>(createVocalFormants()));
         
         // Bell/Metallic sounds
-        tables_["Bell"] = std::make_unique<Wavetable>(createBellTable());
+        addWavetable("Bell", std::make_unique<Wavetable>(createBellTable()));
     }
     
     Wavetable createHarmonicSeries() {
@@ -145,7 +252,17 @@ private:
         return table;
     }
     
-    std::unordered_map<std::string, std::unique_ptr<Wavetable>> tables_;
+    // Audio-thread view: one atomic pointer per handle
+    std::array<std::atomic<const Wavetable*>, kMaxTables> slots_;
+    std::atomic<int> tableCount_;
+    std::atomic<uint64_t> audioEpoch_;
+
+    // Control-thread state, guarded by mutex_
+    mutable std::mutex mutex_;
+    std::array<std::unique_ptr<Wavetable>, kMaxTables> owned_;
+    std::unordered_map<std::string, Handle> handles_;
+    std::vector<std::string> names_;
+    std::vector<RetiredTable> retired_;
 };
 
 } // namespace synth
\ No newline at end of file
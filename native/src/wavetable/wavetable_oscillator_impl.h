@@ -1,6 +1,9 @@
 #pragma once
 #include "synthesis/oscillator.h"
 #include "wavetable_manager.h"
+#include "synthesis/fm_voice.h"
+#include "synthesis/additive_voice.h"
+#include "vector_voice.h"
 
 namespace synth {
 
@@ -11,23 +14,33 @@ public:
         : Oscillator()
         , wavetableOsc_()
         , wavetableManager_(nullptr)
-        , currentWavetableName_("Basic Shapes")
+        , currentHandle_(0)
         , wavetablePosition_(0.0f) {
     }
     
     void setWavetableManager(WavetableManager* manager) {
         wavetableManager_ = manager;
-        selectWavetable(currentWavetableName_);
+        wavetableOsc_.setWavetable(getCurrentWavetable());
+        vectorVoice_.setWavetableManager(manager);
     }
     
-    void selectWavetable(const std::string& tableName) {
-        if (wavetableManager_) {
-            const Wavetable* table = wavetableManager_->getWavetable(tableName);
-            if (table) {
-                wavetableOsc_.setWavetable(table);
-                currentWavetableName_ = tableName;
-            }
+    /// Select a table by handle. Lock-free and allocation-free, so it is
+    /// safe to call from the audio thread (e.g. automation playback).
+    bool selectWavetable(WavetableManager::Handle handle) {
+        if (wavetableManager_ && wavetableManager_->getWavetable(handle)) {
+            currentHandle_ = handle;
+            return true;
         }
+        return false;
+    }
+    
+    /// Select a table by name (control thread)
+    bool selectWavetable(const std::string& tableName) {
+        return wavetableManager_ && selectWavetable(wavetableManager_->findHandle(tableName));
+    }
+    
+    WavetableManager::Handle getWavetableHandle() const {
+        return currentHandle_;
     }
     
     void setWavetablePosition(float position) {
@@ -40,12 +53,72 @@ public:
     }
     
     std::string getCurrentWavetableName() const {
-        return currentWavetableName_;
+        const Wavetable* table = getCurrentWavetable();
+        return table ? table->getName() : std::string();
+    }
+    
+    /// Resolve the current handle. The table behind a handle can be swapped
+    /// at any time, so the pointer is only valid for the current audio block.
+    const Wavetable* getCurrentWavetable() const {
+        return wavetableManager_ ? wavetableManager_->getWavetable(currentHandle_) : nullptr;
+    }
+    
+    /// Operator voice used when the waveform type is FM
+    FMVoice& getFMVoice() {
+        return fmVoice_;
+    }
+    
+    /// Partial bank used when the waveform type is Additive
+    AdditiveVoice& getAdditiveVoice() {
+        return additiveVoice_;
+    }
+    
+    /// Four-corner crossfade used when the waveform type is Vector
+    VectorVoice& getVectorVoice() {
+        return vectorVoice_;
     }
     
     void setSampleRate(int sr) override {
         Oscillator::setSampleRate(sr);
         wavetableOsc_.setSampleRate(static_cast<float>(sr));
+        fmVoice_.setSampleRate(sr);
+        additiveVoice_.setSampleRate(sr);
+        vectorVoice_.setSampleRate(sr);
+    }
+    
+    void noteOn(float velocity) override {
+        Oscillator::noteOn(velocity);
+        fmVoice_.noteOn();
+        additiveVoice_.noteOn();
+        vectorVoice_.noteOn();
+    }
+    
+    void noteOff() override {
+        Oscillator::noteOff();
+        fmVoice_.noteOff();
+    }
+    
+    void processBlock(float* output, int numFrames) override {
+        if (numFrames <= 0) {
+            return;
+        }
+        if (waveformType == WaveformType::FM) {
+            fmVoice_.setBaseIncrement(phaseIncrement);
+            fmVoice_.render(output, numFrames);
+        } else if (waveformType == WaveformType::Additive) {
+            additiveVoice_.setFrequency(phaseIncrement * static_cast<float>(sampleRate));
+            additiveVoice_.render(output, numFrames);
+        } else if (waveformType == WaveformType::Vector) {
+            vectorVoice_.setFrequency(phaseIncrement * static_cast<float>(sampleRate));
+            vectorVoice_.render(output, numFrames);
+        } else {
+            Oscillator::processBlock(output, numFrames);
+            return;
+        }
+        for (int i = 0; i < numFrames; ++i) {
+            output[i] *= volume;
+        }
+        lastOutput = output[numFrames - 1];
     }
     
     void setFrequency(float freq) override {
@@ -60,14 +133,34 @@ public:
     
 protected:
     float processWavetable() override {
+        wavetableOsc_.setWavetable(getCurrentWavetable());
         return wavetableOsc_.process();
     }
     
+    float processFM() override {
+        fmVoice_.setBaseIncrement(phaseIncrement);
+        return fmVoice_.nextSample();
+    }
+    
+    float processAdditive() override {
+        // Detune is already folded into phaseIncrement
+        additiveVoice_.setFrequency(phaseIncrement * static_cast<float>(sampleRate));
+        return additiveVoice_.nextSample();
+    }
+    
+    float processVector() override {
+        vectorVoice_.setFrequency(phaseIncrement * static_cast<float>(sampleRate));
+        return vectorVoice_.nextSample();
+    }
+    
 private:
     WavetableOscillator wavetableOsc_;
     WavetableManager* wavetableManager_;
-    std::string currentWavetableName_;
+    WavetableManager::Handle currentHandle_;
     float wavetablePosition_;
+    FMVoice fmVoice_;
+    AdditiveVoice additiveVoice_;
+    VectorVoice vectorVoice_;
 };
 
 } // namespace synth
\ No newline at end of file
@@ -0,0 +1,355 @@
+#include "src/synthesis/envelope.h"
+#include "src/synthesis/oscillator.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Benchmarks the DSP building blocks and reports speed and, where it applies,
+// signal quality.
+//
+// Oscillators: PolyBLEP (evaluated every sample) vs MinBLEP (table residual
+// mixed in at discontinuities), plus hard sync and audio-rate PWM, which only
+// the MinBLEP path supports. Aliasing is reported as the energy outside the
+// harmonics of the fundamental relative to the total.
+//
+// Envelopes: the per-sample ADSR (stage switch, progress division and curve
+// function on every sample) vs the recursive segments that replaced it,
+// stepped per sample and rendered a block at a time. Accuracy is the largest
+// difference from the per-sample curves over a full note.
+//
+// Build: g++ -std=c++17 -O2 test_dsp_benchmark.cpp -o test_dsp_benchmark
+
+namespace {
+
+const int kSampleRate = 48000;
+const int kBenchmarkSamples = kSampleRate * 20;
+const int kAnalysisSize = 8192;
+
+double nanosecondsPerSample(const std::function<float()>& render) {
+    volatile float sink = 0.0f;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kBenchmarkSamples; ++i) {
+        sink = sink + render();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / kBenchmarkSamples;
+}
+
+// Energy away from the harmonics of f0 relative to the total, in dB
+double aliasingDb(const std::vector<float>& signal, double f0) {
+    const double pi = 3.14159265358979323846;
+    const int n = static_cast<int>(signal.size());
+    std::vector<double> windowed(n);
+    for (int i = 0; i < n; ++i) {
+        double w = 0.35875 - 0.48829 * std::cos(2.0 * pi * i / n) + 0.14128 * std::cos(4.0 * pi * i / n)
+                 - 0.01168 * std::cos(6.0 * pi * i / n);
+        windowed[i] = signal[i] * w;
+    }
+
+    const double binHz = static_cast<double>(kSampleRate) / n;
+    double harmonicEnergy = 0.0;
+    double aliasEnergy = 0.0;
+    for (int k = 1; k < n / 2; ++k) {
+        double re = 0.0;
+        double im = 0.0;
+        for (int i = 0; i < n; ++i) {
+            double angle = 2.0 * pi * static_cast<double>(k) * i / n;
+            re += windowed[i] * std::cos(angle);
+            im -= windowed[i] * std::sin(angle);
+        }
+        double energy = re * re + im * im;
+        double harmonic = std::round(k * binHz / f0);
+        bool nearHarmonic = std::abs(k * binHz - harmonic * f0) <= 5.0 * binHz;
+        if (harmonic < 1.0 && nearHarmonic) {
+            continue; // DC offsets (e.g. of a pulse) are not aliasing
+        }
+        (nearHarmonic ? harmonicEnergy : aliasEnergy) += energy;
+    }
+    return 10.0 * std::log10(aliasEnergy / (harmonicEnergy + aliasEnergy) + 1e-30);
+}
+
+struct Case {
+    std::string name;
+    Oscillator::WaveformType type;
+    Oscillator::AntiAliasMode mode;
+    float syncRatio;
+    float pwmDepth;
+};
+
+void configure(Oscillator& osc, const Case& c, float frequency) {
+    osc.setSampleRate(kSampleRate);
+    osc.setType(static_cast<int>(c.type));
+    osc.setAntiAliasMode(c.mode);
+    osc.setFrequency(frequency);
+    osc.setVolume(1.0f);
+    osc.setPulseWidth(0.3f);
+    osc.setSyncRatio(c.syncRatio);
+    osc.setPwmDepth(c.pwmDepth);
+    osc.setPwmRate(3.0f);
+}
+
+void runOscillatorBenchmarks() {
+    using Type = Oscillator::WaveformType;
+    using Mode = Oscillator::AntiAliasMode;
+    const std::vector<Case> cases = {
+        {"saw      PolyBLEP", Type::Sawtooth, Mode::PolyBLEP, 1.0f, 0.0f},
+        {"saw      MinBLEP ", Type::Sawtooth, Mode::MinBLEP, 1.0f, 0.0f},
+        {"square   PolyBLEP", Type::Square, Mode::PolyBLEP, 1.0f, 0.0f},
+        {"square   MinBLEP ", Type::Square, Mode::MinBLEP, 1.0f, 0.0f},
+        {"pulse    PolyBLEP", Type::Pulse, Mode::PolyBLEP, 1.0f, 0.0f},
+        {"pulse    MinBLEP ", Type::Pulse, Mode::MinBLEP, 1.0f, 0.0f},
+        {"pwm      PolyBLEP", Type::Pulse, Mode::PolyBLEP, 1.0f, 0.2f},
+        {"pwm      MinBLEP ", Type::Pulse, Mode::MinBLEP, 1.0f, 0.2f},
+        {"sync saw MinBLEP ", Type::Sawtooth, Mode::MinBLEP, 2.37f, 0.0f},
+        {"sync sq  MinBLEP ", Type::Square, Mode::MinBLEP, 2.37f, 0.0f},
+    };
+
+    // A high, non-bin-aligned fundamental makes aliasing easy to see
+    const float testFrequency = 1234.5f;
+
+    std::cout << "Oscillators (" << kBenchmarkSamples / kSampleRate << " s at " << kSampleRate << " Hz, f0 "
+              << testFrequency << " Hz)" << std::endl;
+    for (const Case& c : cases) {
+        Oscillator timed;
+        configure(timed, c, 220.0f);
+        double ns = nanosecondsPerSample([&]() { return timed.process(); });
+
+        Oscillator analyzed;
+        configure(analyzed, c, testFrequency);
+        for (int i = 0; i < 1024; ++i) {
+            analyzed.process(); // Let PWM and sync settle away from the start phase
+        }
+        std::vector<float> signal(kAnalysisSize);
+        for (float& sample : signal) {
+            sample = analyzed.process();
+        }
+        double alias = (c.pwmDepth > 0.0f) ? 0.0 : aliasingDb(signal, testFrequency);
+
+        std::cout << "  " << c.name << std::fixed << std::setprecision(2) << std::setw(8) << ns << " ns/sample";
+        if (c.pwmDepth > 0.0f) {
+            std::cout << "   aliasing    n/a (moving spectrum)";
+        } else {
+            std::cout << "   aliasing " << std::setw(7) << std::setprecision(1) << alias << " dB";
+        }
+        std::cout << std::endl;
+    }
+}
+
+// The ADSR as it was before it rendered recursive segments, kept as the
+// baseline for speed and for the accuracy of the segment fit
+class PerSampleEnvelope {
+public:
+    using CurveType = Envelope::CurveType;
+
+    void setSampleRate(int sr) { sampleRate = sr; }
+    void setTimes(float attack, float decay, float sustain, float release) {
+        attackTime = attack;
+        decayTime = decay;
+        sustainLevel = sustain;
+        releaseTime = release;
+    }
+    void setCurve(CurveType type) { curve = type; }
+
+    void noteOn(float vel) {
+        state = Envelope::State::Attack;
+        currentTime = 0.0f;
+        velocity = vel;
+        if (currentLevel <= 0.001f) {
+            currentLevel = 0.0f;
+        }
+    }
+
+    void noteOff() {
+        if (state != Envelope::State::Idle) {
+            state = Envelope::State::Release;
+            releaseLevel = currentLevel;
+            currentTime = 0.0f;
+        }
+    }
+
+    float process() {
+        float samplesPerMs = sampleRate / 1000.0f;
+        switch (state) {
+            case Envelope::State::Attack: {
+                currentTime += 1.0f / samplesPerMs;
+                float progress = currentTime / (attackTime * 1000.0f);
+                if (progress >= 1.0f) {
+                    currentLevel = velocity;
+                    state = Envelope::State::Decay;
+                    currentTime = 0.0f;
+                } else {
+                    currentLevel = applyCurve(progress) * velocity;
+                }
+                break;
+            }
+            case Envelope::State::Decay: {
+                currentTime += 1.0f / samplesPerMs;
+                float progress = currentTime / (decayTime * 1000.0f);
+                if (progress >= 1.0f) {
+                    currentLevel = sustainLevel * velocity;
+                    state = Envelope::State::Sustain;
+                } else {
+                    currentLevel = (1.0f - applyCurve(progress) * (1.0f - sustainLevel)) * velocity;
+                }
+                break;
+            }
+            case Envelope::State::Sustain:
+                currentLevel = sustainLevel * velocity;
+                break;
+            case Envelope::State::Release: {
+                currentTime += 1.0f / samplesPerMs;
+                float progress = currentTime / (releaseTime * 1000.0f);
+                if (progress >= 1.0f) {
+                    currentLevel = 0.0f;
+                    state = Envelope::State::Idle;
+                } else {
+                    currentLevel = releaseLevel * (1.0f - applyCurve(progress));
+                }
+                break;
+            }
+            default:
+                currentLevel = 0.0f;
+                break;
+        }
+        return currentLevel;
+    }
+
+private:
+    float applyCurve(float value) const {
+        value = std::clamp(value, 0.0f, 1.0f);
+        switch (curve) {
+            case CurveType::Exponential:
+                return value * value;
+            case CurveType::Logarithmic:
+                return std::sqrt(value);
+            case CurveType::SCurve:
+                return (fastmath::sin2pi((value - 0.5f) * 0.5f) * 0.5f) + 0.5f;
+            default:
+                return value;
+        }
+    }
+
+    int sampleRate = 44100;
+    float attackTime = 0.01f;
+    float decayTime = 0.1f;
+    float sustainLevel = 0.7f;
+    float releaseTime = 0.5f;
+    CurveType curve = CurveType::Exponential;
+    Envelope::State state = Envelope::State::Idle;
+    float currentLevel = 0.0f;
+    float currentTime = 0.0f;
+    float releaseLevel = 0.0f;
+    float velocity = 1.0f;
+};
+
+// One note: attack, decay, some sustain, then release to silence
+const float kEnvelopeAttack = 0.05f;
+const float kEnvelopeDecay = 0.2f;
+const float kEnvelopeSustain = 0.6f;
+const float kEnvelopeRelease = 0.4f;
+const int kNoteSamples = static_cast<int>(kSampleRate * 1.0f);
+const int kNoteCycleSamples = kNoteSamples + static_cast<int>(kSampleRate * kEnvelopeRelease) + 64;
+
+void configure(Envelope& env, Envelope::CurveType curve) {
+    env.setSampleRate(kSampleRate);
+    env.setAttack(kEnvelopeAttack);
+    env.setDecay(kEnvelopeDecay);
+    env.setSustain(kEnvelopeSustain);
+    env.setRelease(kEnvelopeRelease);
+    env.setAttackCurve(curve);
+    env.setDecayCurve(curve);
+    env.setReleaseCurve(curve);
+}
+
+void configure(PerSampleEnvelope& env, Envelope::CurveType curve) {
+    env.setSampleRate(kSampleRate);
+    env.setTimes(kEnvelopeAttack, kEnvelopeDecay, kEnvelopeSustain, kEnvelopeRelease);
+    env.setCurve(curve);
+}
+
+// Steps an envelope through repeated notes, triggering them on schedule
+template <typename Env>
+float stepNote(Env& env, int& position) {
+    if (position == 0) {
+        env.noteOn(0.9f);
+    } else if (position == kNoteSamples) {
+        env.noteOff();
+    }
+    position = (position + 1) % kNoteCycleSamples;
+    return env.process();
+}
+
+void runEnvelopeBenchmarks() {
+    using Curve = Envelope::CurveType;
+    const std::vector<std::pair<std::string, Curve>> curves = {
+        {"linear     ", Curve::Linear},
+        {"exponential", Curve::Exponential},
+        {"logarithmic", Curve::Logarithmic},
+        {"s-curve    ", Curve::SCurve},
+    };
+    const int blockSize = 64;
+
+    std::cout << "Envelopes (per voice, notes of " << kNoteSamples / kSampleRate << " s + "
+              << kEnvelopeRelease << " s release)" << std::endl;
+    for (const auto& [name, curve] : curves) {
+        PerSampleEnvelope before;
+        configure(before, curve);
+        int beforePosition = 0;
+        double beforeNs = nanosecondsPerSample([&]() { return stepNote(before, beforePosition); });
+
+        Envelope stepped;
+        configure(stepped, curve);
+        int steppedPosition = 0;
+        double steppedNs = nanosecondsPerSample([&]() { return stepNote(stepped, steppedPosition); });
+
+        // Block rendering, with note events on block boundaries
+        Envelope blocked;
+        configure(blocked, curve);
+        std::vector<float> block(blockSize);
+        volatile float sink = 0.0f;
+        const int cycleBlocks = kNoteCycleSamples / blockSize;
+        const int totalBlocks = kBenchmarkSamples / blockSize;
+        auto start = std::chrono::steady_clock::now();
+        for (int b = 0; b < totalBlocks; ++b) {
+            int position = b % cycleBlocks;
+            if (position == 0) {
+                blocked.noteOn(0.9f);
+            } else if (position == kNoteSamples / blockSize) {
+                blocked.noteOff();
+            }
+            blocked.processBlock(block.data(), blockSize);
+            sink = sink + block[blockSize - 1];
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        double blockNs = std::chrono::duration<double, std::nano>(elapsed).count() / (totalBlocks * blockSize);
+
+        PerSampleEnvelope reference;
+        Envelope segmented;
+        configure(reference, curve);
+        configure(segmented, curve);
+        int referencePosition = 0;
+        int segmentedPosition = 0;
+        float maxError = 0.0f;
+        for (int i = 0; i < kNoteCycleSamples; ++i) {
+            float expected = stepNote(reference, referencePosition);
+            maxError = std::max(maxError, std::abs(stepNote(segmented, segmentedPosition) - expected));
+        }
+
+        std::cout << "  " << name << std::fixed << std::setprecision(2) << "  per-sample " << std::setw(6)
+                  << beforeNs << "  segments " << std::setw(6) << steppedNs << "  block " << std::setw(6)
+                  << blockNs << " ns/sample   max error " << std::setprecision(4) << maxError << std::endl;
+    }
+}
+
+} // namespace
+
+int main() {
+    runOscillatorBenchmarks();
+    runEnvelopeBenchmarks();
+    return 0;
+}
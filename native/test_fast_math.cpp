@@ -0,0 +1,96 @@
+#include "src/synthesis/fast_math.h"
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <functional>
+#include <string>
+
+// Reports the maximum error of each fast-math approximation against libm and
+// fails if any tier exceeds its documented bound.
+//
+// Build: g++ -std=c++17 -O2 test_fast_math.cpp -o test_fast_math
+
+namespace {
+
+int failures = 0;
+
+void report(const std::string& name, double lo, double hi, double bound, bool relative,
+            const std::function<double(double)>& reference,
+            const std::function<float(float)>& approx) {
+    const int steps = 200000;
+    double maxError = 0.0;
+    double worstInput = lo;
+    for (int i = 0; i <= steps; ++i) {
+        double x = lo + (hi - lo) * static_cast<double>(i) / steps;
+        double expected = reference(x);
+        double actual = approx(static_cast<float>(x));
+        double error = std::abs(actual - expected);
+        if (relative && expected != 0.0) {
+            error /= std::abs(expected);
+        }
+        if (error > maxError) {
+            maxError = error;
+            worstInput = x;
+        }
+    }
+
+    bool ok = maxError <= bound;
+    if (!ok) {
+        ++failures;
+    }
+    std::cout << std::left << std::setw(26) << name
+              << " max " << (relative ? "rel " : "abs ") << "error " << std::scientific << std::setprecision(3) << maxError
+              << " at x=" << std::fixed << std::setprecision(5) << worstInput
+              << "  (bound " << std::scientific << std::setprecision(1) << bound << ")"
+              << (ok ? "" : "  FAILED") << std::endl;
+}
+
+template <fastmath::Precision P>
+void testTier(const std::string& tier, double sinBound, double expBound, double tanhBound) {
+    const double twoPi = 2.0 * 3.14159265358979323846;
+    report("sin2pi<" + tier + ">", -2.0, 2.0, sinBound, false,
+           [=](double x) { return std::sin(twoPi * x); },
+           [](float x) { return fastmath::sin2pi<P>(x); });
+    report("cos2pi<" + tier + ">", -2.0, 2.0, sinBound, false,
+           [=](double x) { return std::cos(twoPi * x); },
+           [](float x) { return fastmath::cos2pi<P>(x); });
+    report("exp2<" + tier + ">", -20.0, 20.0, expBound, true,
+           [](double x) { return std::exp2(x); },
+           [](float x) { return fastmath::exp2<P>(x); });
+    report("centsToRatio<" + tier + ">", -2400.0, 2400.0, expBound, true,
+           [](double x) { return std::pow(2.0, x / 1200.0); },
+           [](float x) { return fastmath::centsToRatio<P>(x); });
+    report("tanh<" + tier + ">", -10.0, 10.0, tanhBound, false,
+           [](double x) { return std::tanh(x); },
+           [](float x) { return fastmath::tanh<P>(x); });
+
+    // Exact at the identities, so an untransposed ratio is 1 and silence stays silent
+    const bool exact = fastmath::exp2<P>(0.0f) == 1.0f && fastmath::exp2<P>(1.0f) == 2.0f
+                    && fastmath::centsToRatio<P>(0.0f) == 1.0f && fastmath::tanh<P>(0.0f) == 0.0f;
+    if (!exact) {
+        ++failures;
+    }
+    std::cout << std::left << std::setw(26) << ("identities<" + tier + ">")
+              << (exact ? " exact" : " not exact  FAILED") << std::endl;
+}
+
+} // namespace
+
+int main() {
+    std::cout << "Fast-math accuracy against libm" << std::endl;
+
+    testTier<fastmath::Precision::Low>("Low", 1e-4, 2e-4, 3e-2);
+    testTier<fastmath::Precision::Medium>("Medium", 1e-6, 1e-5, 1e-5);
+    testTier<fastmath::Precision::High>("High", 5e-7, 1e-6, 1e-6);
+
+    report("sin2piLookup", -2.0, 2.0, 1e-5, false,
+           [](double x) { return std::sin(2.0 * 3.14159265358979323846 * x); },
+           [](float x) { return fastmath::sin2piLookup(x); });
+
+    if (failures > 0) {
+        std::cerr << failures << " approximation(s) exceeded their error bound!" << std::endl;
+        return 1;
+    }
+    std::cout << "All approximations within bounds." << std::endl;
+    return 0;
+}